@@ -0,0 +1,188 @@
+#include <math.h>
+#include <string.h>
+#include "AnomalyDetector.h"
+#include "MemoryArena.h"
+
+// --- Vibration Settings ---
+static const float VIB_MASK_MARGIN = 1.4f;     // +40% tolerance
+static const float VIB_NOISE_FLOOR = 2.0f;     // Minimum sensitivity
+static const int   VIB_SKIP_BINS = 2;
+
+// --- Current Settings ---
+static const float CUR_UPPER_PERCENT = 0.30f;  // +30% = Overload
+static const float CUR_LOWER_PERCENT = 0.50f;  // -50% = Underload
+static const float CUR_NOISE_BUFFER = 100.0f;  // Minimum gap for limits (prevents false alarms on 0)
+static const float CUR_IDLE_CUTOFF = 50.0f;    // Ignore values below this (Motor OFF)
+static const float CUR_RIPPLE_MARGIN = 1.6f;   // +60% tolerance for arcing
+static const float CUR_RIPPLE_FLOOR = 2.0f;
+static const int   CUR_FFT_SKIP_BINS = 5;      // IGNORE DC Component (Huge Spike at start)
+
+const char* alarmText(AlarmCode code){
+    switch (code) {
+        case ALARM_VIB_HIGH_ENERGY: return "VIB: HIGH ENERGY";
+        case ALARM_VIB_FREQ_SPIKE:  return "VIB: FREQ SPIKE";
+        case ALARM_CUR_OVERLOAD:    return "MOTOR FAULT: JAM / OVERLOAD";
+        case ALARM_CUR_UNDERLOAD:   return "MOTOR FAULT: DRY RUN / BROKEN BELT";
+        case ALARM_CUR_ARCING:      return "MOTOR FAULT: BRUSH ARCING / NOISE";
+        default:                    return "SYSTEM NORMAL";
+    }
+}
+
+static float spectrumRms(const float* fft, int bins){
+    float sum = 0;
+    for (int i = 0; i < bins; i++) sum += fft[i] * fft[i];
+    return sqrtf(sum / bins);
+}
+
+AnomalyDetector::AnomalyDetector(SensorDataType type, int bins, float binHz) : _type(type), _bins(bins), _binHz(binHz){
+	_mask = arenaNew<float>(_bins, MEM_FAST, "detector");
+	_simulated = arenaNew<float>(_bins, MEM_BULK, "detector");	// Only touched by /simulate
+	memset(&_active, 0, sizeof(_active));
+}
+
+AnomalyDetector::~AnomalyDetector(){
+	arenaDelete(_mask);
+	arenaDelete(_simulated);
+}
+
+void AnomalyDetector::startLearning(int frames){
+    memset(_mask, 0, sizeof(float) * _bins);
+    _maxRms = 0;
+    _baselineMean = 0;
+    _haveBaseline = false;
+    _learnFrames = 0;
+    _learnTarget = frames;
+    _state = STATE_LEARNING;
+}
+
+void AnomalyDetector::reset(){
+    startLearning(0);
+    memset(&_active, 0, sizeof(_active));
+    _state = STATE_UNCALIBRATED;
+}
+
+float AnomalyDetector::binLimit(int bin) const {
+    if (_type == TYPE_CURRENT) return fmaxf(_mask[bin] * CUR_RIPPLE_MARGIN, CUR_RIPPLE_FLOOR);
+    return fmaxf(_mask[bin] * VIB_MASK_MARGIN, VIB_NOISE_FLOOR);
+}
+
+float AnomalyDetector::upperLimit() const {
+    return _baselineMean + fmaxf(fabsf(_baselineMean) * CUR_UPPER_PERCENT, CUR_NOISE_BUFFER);
+}
+
+float AnomalyDetector::lowerLimit() const {
+    return _baselineMean - fmaxf(fabsf(_baselineMean) * CUR_LOWER_PERCENT, CUR_NOISE_BUFFER);
+}
+
+void AnomalyDetector::learn(float mean, const float* fft){
+    if (_type == TYPE_VIBRATION) {
+        float rms = spectrumRms(fft, _bins);
+        if (rms > _maxRms) _maxRms = rms;
+    } else {
+        if (!_haveBaseline) { _baselineMean = mean; _haveBaseline = true; }
+        else _baselineMean = (_baselineMean * 0.9f) + (mean * 0.1f);
+    }
+    for (int i = 0; i < _bins; i++) if (fft[i] > _mask[i]) _mask[i] = fft[i];
+
+    if (++_learnFrames >= _learnTarget) _state = STATE_MONITORING;
+}
+
+AlarmEvent_t AnomalyDetector::check(float mean, const float* fft) const {
+    AlarmEvent_t found;
+    memset(&found, 0, sizeof(found));
+
+    // >>> VIBRATION CHECK <<<
+    if (_type == TYPE_VIBRATION) {
+        float rms = spectrumRms(fft, _bins);
+        float rmsLimit = fmaxf(_maxRms * VIB_MASK_MARGIN, VIB_NOISE_FLOOR);
+        if (rms > rmsLimit) {
+            found.code = ALARM_VIB_HIGH_ENERGY; found.value = rms; found.limit = rmsLimit;
+            return found;
+        }
+        for (int i = VIB_SKIP_BINS; i < _bins; i++) {
+            float limit = binLimit(i);
+            if (fft[i] > limit) {
+                found.code = ALARM_VIB_FREQ_SPIKE; found.frequencyHz = i * _binHz; found.value = fft[i]; found.limit = limit;
+                return found;
+            }
+        }
+        return found;
+    }
+
+    // >>> CURRENT CHECK <<<
+    // Motor OFF (or sensor disconnected): no faults
+    if (fabsf(mean) < CUR_IDLE_CUTOFF && fabsf(_baselineMean) < CUR_IDLE_CUTOFF) return found;
+
+    float upper = upperLimit();
+    float lower = lowerLimit();
+    if (mean > upper) {
+        found.code = ALARM_CUR_OVERLOAD; found.value = mean; found.limit = upper;
+    } else if (mean < lower) {
+        found.code = ALARM_CUR_UNDERLOAD; found.value = mean; found.limit = lower;
+    } else {
+        for (int i = CUR_FFT_SKIP_BINS; i < _bins; i++) {
+            float limit = binLimit(i);
+            if (fft[i] > limit) {
+                found.code = ALARM_CUR_ARCING; found.frequencyHz = i * _binHz; found.value = fft[i]; found.limit = limit;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+bool AnomalyDetector::report(const AlarmEvent_t& found, AlarmEvent_t* event){
+    bool changed = (found.code != _active.code);
+    _active = found;
+    if (changed && event != nullptr) *event = found;
+    return changed;
+}
+
+bool AnomalyDetector::update(const DspPipeline& pipeline, AlarmEvent_t* event){
+    if (_state == STATE_UNCALIBRATED) return false;
+
+    // Only current uses the time-domain level
+    float mean = 0;
+    if (_type == TYPE_CURRENT) {
+        const int n = pipeline.fftSize();
+        for (int i = 0; i < n; i++) mean += pipeline.timeSample(i);
+        mean /= n;
+    }
+
+    if (_state == STATE_LEARNING) {
+        learn(mean, pipeline.spectrum());
+        return false;
+    }
+    return report(check(mean, pipeline.spectrum()), event);
+}
+
+bool AnomalyDetector::simulate(SimulatedFault fault, AlarmEvent_t* event){
+    if (_state != STATE_MONITORING) return false;
+    if ((fault == SIM_VIB_SPIKE) != (_type == TYPE_VIBRATION)) return false;
+
+    // Same synthetic frames the dashboard buttons used to build
+    float* fft = _simulated;
+    const int spikeBin = (_bins > 50) ? 50 : _bins - 1;
+    float mean = _baselineMean;
+
+    switch (fault) {
+        case SIM_VIB_SPIKE:
+            for (int i = 0; i < _bins; i++) fft[i] = _mask[i] * 0.5f;
+            fft[spikeBin] = (_mask[spikeBin] * VIB_MASK_MARGIN) + 50.0f;	// Massive Spike
+            break;
+        case SIM_CUR_JAM:
+            memcpy(fft, _mask, sizeof(float) * _bins);
+            mean = _baselineMean + fmaxf(_baselineMean * 0.5f, CUR_NOISE_BUFFER + 50.0f);
+            break;
+        case SIM_CUR_DRY:
+            memcpy(fft, _mask, sizeof(float) * _bins);
+            mean = _baselineMean - fmaxf(_baselineMean * 0.6f, CUR_NOISE_BUFFER + 50.0f);
+            break;
+        case SIM_CUR_ARC:
+            memcpy(fft, _mask, sizeof(float) * _bins);
+            fft[spikeBin] = (_mask[spikeBin] * CUR_RIPPLE_MARGIN) + 100.0f;
+            break;
+    }
+
+    return report(check(mean, fft), event);
+}
\ No newline at end of file
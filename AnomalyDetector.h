@@ -0,0 +1,93 @@
+#ifndef ANOMALY_DETECTOR_H
+#define ANOMALY_DETECTOR_H
+
+#include <stdint.h>
+#include "Protocol.h"
+#include "DspPipeline.h"
+
+// Fault logic that used to live in the dashboard JavaScript, now run on every spectrum.
+// Learning phase: vibration keeps the max spectrum (mask) and max spectral RMS,
+// current keeps an EMA of the mean level and the max ripple spectrum.
+// Monitoring: the same thresholds as the old dashboard (see AnomalyDetector.cpp).
+
+enum AlarmCode {
+    ALARM_NONE = 0,
+    ALARM_VIB_HIGH_ENERGY = 1,
+    ALARM_VIB_FREQ_SPIKE = 2,
+    ALARM_CUR_OVERLOAD = 3,      // Jam
+    ALARM_CUR_UNDERLOAD = 4,     // Dry run / broken belt
+    ALARM_CUR_ARCING = 5         // Brush arcing / ripple noise
+};
+
+enum SimulatedFault {
+    SIM_VIB_SPIKE = 0,
+    SIM_CUR_JAM,
+    SIM_CUR_DRY,
+    SIM_CUR_ARC
+};
+
+typedef struct {
+    AlarmCode code;
+    float     frequencyHz;   // Offending bin (spectral alarms)
+    float     value;
+    float     limit;
+} AlarmEvent_t;
+
+const char* alarmText(AlarmCode code);
+
+class AnomalyDetector {
+	public:
+		enum State { STATE_UNCALIBRATED, STATE_LEARNING, STATE_MONITORING };
+
+		AnomalyDetector(SensorDataType type, int bins, float binHz);
+		~AnomalyDetector();
+
+		AnomalyDetector(const AnomalyDetector&) = delete;
+		AnomalyDetector& operator=(const AnomalyDetector&) = delete;
+
+		void startLearning(int frames);
+		// Back to uncalibrated, alarm cleared (another sensor took the channel)
+		void reset();
+
+		// Feeds one spectrum. Returns true when the alarm state changed; `event` then
+		// holds the new alarm (code ALARM_NONE = back to normal).
+		bool update(const DspPipeline& pipeline, AlarmEvent_t* event);
+
+		// Runs a synthetic frame through the checks (dashboard fault buttons).
+		// Returns false if the fault does not apply to this channel or it is not calibrated.
+		bool simulate(SimulatedFault fault, AlarmEvent_t* event);
+
+		State state() const { return _state; }
+		int learningPercent() const { return (_learnTarget > 0) ? (100 * _learnFrames) / _learnTarget : 0; }
+		AlarmCode activeAlarm() const { return _active.code; }
+		SensorDataType type() const { return _type; }
+		int bins() const { return _bins; }
+
+		// --- Learned limits (dashboard overlays) ---
+		float binLimit(int bin) const;
+		float upperLimit() const;
+		float lowerLimit() const;
+
+	private:
+		SensorDataType	_type;
+		int				_bins;
+		float			_binHz;
+
+		State			_state = STATE_UNCALIBRATED;
+		int				_learnFrames = 0;
+		int				_learnTarget = 0;
+
+		float*			_mask;				// Max spectrum seen while learning
+		float*			_simulated;			// Synthetic frame for simulate()
+		float			_maxRms = 0;		// Vibration
+		float			_baselineMean = 0;	// Current
+		bool			_haveBaseline = false;
+
+		AlarmEvent_t	_active;
+
+		void learn(float mean, const float* fft);
+		AlarmEvent_t check(float mean, const float* fft) const;
+		bool report(const AlarmEvent_t& found, AlarmEvent_t* event);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "BatchPool.h"
+#include "MemoryArena.h"
+
+BatchPool::BatchPool(int capacity) : _capacity(capacity > 255 ? 255 : capacity) {
+	for (int c = 0; c < BATCH_POOL_CONSUMERS; c++) _returned[c].setOverflowPolicy(SpscRing<uint8_t, 256>::DROP_NEWEST);
+	_slots = arenaNew<InternalMessage_t>(_capacity, MEM_FAST, "pool");
+	_freeStack = arenaNew<uint8_t>(_capacity, MEM_FAST, "pool");
+	for (int i = 0; i < _capacity; i++) _freeStack[i] = (uint8_t)i;
+	_freeCount = _capacity;
+}
+
+InternalMessage_t* BatchPool::acquire(uint8_t* index){
+	// Pull back whatever ProcessingCore released before giving up
+	if (_freeCount == 0) collectReturned();
+	if (_freeCount == 0) {
+		_exhausted++;
+		return nullptr;
+	}
+	*index = _freeStack[--_freeCount];
+	return &_slots[*index];
+}
+
+void BatchPool::recycle(uint8_t index){
+	if (_freeCount < _capacity) _freeStack[_freeCount++] = index;
+}
+
+int BatchPool::freeSlots(){
+	collectReturned();
+	return _freeCount;
+}
+
+void BatchPool::collectReturned(){
+	uint8_t returned;
+	for (int c = 0; c < BATCH_POOL_CONSUMERS; c++) {
+		while (_freeCount < _capacity && _returned[c].pop(returned)) _freeStack[_freeCount++] = returned;
+	}
+}
+
+void BatchPool::release(uint8_t index, int consumer){
+	_returned[consumer].push(index);
+}
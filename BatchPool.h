@@ -0,0 +1,54 @@
+#ifndef BATCH_POOL_H
+#define BATCH_POOL_H
+
+#include <stdint.h>
+#include "Protocol.h"
+#include "SpscRing.h"
+
+// Batches a sensor may have queued for the DSP core before the oldest is dropped
+#define BATCH_RING_DEPTH 2
+// DSP workers that may release slots concurrently, one return ring each
+#define BATCH_POOL_CONSUMERS 4
+
+// Per-sensor handoff from CommunicationHub (producer) to ProcessingCore (consumer),
+// carrying BatchPool slot indices. Fresh data wins: a full ring evicts its oldest batch.
+typedef SpscRing<uint8_t, BATCH_RING_DEPTH> BatchRing;
+
+// Preallocated InternalMessage_t slots shared by the two cores.
+// CommunicationHub acquires a slot and reads the socket straight into it, the sensor's
+// BatchRing only carries the slot index, and ProcessingCore releases the slot once it is aggregated.
+//
+// Ownership is split so no locks are needed: free slots sit on a stack owned by the hub,
+// slots released by ProcessingCore come back through a lock-free SPSC ring per DSP worker.
+class BatchPool {
+	public:
+		BatchPool(int capacity = 16);
+
+		// --- Hub (producer core) side ---
+		// Non-blocking. Returns nullptr when every slot is in flight.
+		InternalMessage_t* acquire(uint8_t* index);
+		// Give back a slot the hub never handed over (evicted, aborted packet)
+		void recycle(uint8_t index);
+		// Slots free for acquire(), released ones included (a leak check once the workers are idle)
+		int freeSlots();
+
+		// --- ProcessingCore (consumer core) side ---
+		// `consumer` is the DSP worker releasing (0 .. BATCH_POOL_CONSUMERS - 1), each has its own ring
+		void release(uint8_t index, int consumer = 0);
+
+		InternalMessage_t* slot(uint8_t index) { return &_slots[index]; }
+		int capacity() const { return _capacity; }
+		uint32_t exhausted() const { return _exhausted; }
+
+	private:
+		int					_capacity;
+		InternalMessage_t*	_slots;
+		uint8_t*			_freeStack;		// Hub only
+		int					_freeCount;
+		SpscRing<uint8_t, 256> _returned[BATCH_POOL_CONSUMERS];	// DSP workers -> hub, never overflow (capacity <= 255)
+		uint32_t			_exhausted = 0;	// acquire() calls that found no free slot
+
+		void collectReturned();
+};
+
+#endif
\ No newline at end of file
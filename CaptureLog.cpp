@@ -0,0 +1,248 @@
+#include <string.h>
+#include "CaptureLog.h"
+#include "MemoryArena.h"
+
+static uint16_t payloadSum(const uint8_t* p, size_t len, uint16_t sum){
+    for (size_t i = 0; i < len; i++) sum += p[i];
+    return sum;
+}
+
+CaptureLog::CaptureLog(FlashStore* store) : _store(store){
+}
+
+CaptureLog::~CaptureLog(){
+	arenaDelete(_sectorSeq);
+	arenaDelete(_page);
+	arenaDelete(_pre);
+	arenaDelete(_preTime);
+}
+
+bool CaptureLog::begin(){
+    if (_store == nullptr || !_store->begin()) return false;
+    _sectorSize = _store->sectorSize();
+    _pageSize = _store->pageSize();
+    int sectors = (int)(_store->size() / _sectorSize);
+    if (sectors < 2 || _sectorSize % _pageSize) return false;
+
+    // Touched once per batch at most: bulk memory
+    _sectorSeq = arenaNew<uint32_t>(sectors, MEM_BULK, "capture");
+    _page = arenaNew<uint8_t>(_pageSize, MEM_BULK, "capture");
+    _pre = arenaNew<InternalMessage_t>(CAPTURE_PRE_BATCHES, MEM_BULK, "capture");
+    _preTime = arenaNew<uint32_t>(CAPTURE_PRE_BATCHES, MEM_BULK, "capture");
+
+    // Find the newest sector from the last run, the log continues right after it
+    int newest = sectors - 1;
+    uint32_t newestSeq = 0;
+    for (int i = 0; i < sectors; i++) {
+        CaptureSectorHeader_t h;
+        _sectorSeq[i] = 0;
+        if (!_store->read((uint32_t)i * _sectorSize, &h, sizeof(h))) return false;
+        if (h.magic != CAPTURE_SECTOR_MAGIC || h.sequence == 0 || h.sequence == 0xFFFFFFFF) continue;
+        _sectorSeq[i] = h.sequence;
+        if (h.sequence > newestSeq) { newestSeq = h.sequence; newest = i; }
+    }
+    _nextSeq = newestSeq + 1;
+    _sector = newest;
+    _sectorCount = sectors;
+    _erasedAhead = 0;
+    advance();
+    return true;
+}
+
+// Moves to the next sector (erasing it unless maintain() already did) and starts it with its header
+void CaptureLog::advance(){
+    flushPage();
+    int next = (_sector + 1) % _sectorCount;
+    if (_erasedAhead > 0) _erasedAhead--;
+    else if (!_store->erase((uint32_t)next * _sectorSize, _sectorSize)) _writeErrors++;
+
+    _sector = next;
+    _sectorSeq[next] = _nextSeq++;
+    _pageOffset = (uint32_t)next * _sectorSize;
+    _pageFill = 0;
+
+    CaptureSectorHeader_t h;
+    h.magic = CAPTURE_SECTOR_MAGIC;
+    h.sequence = _sectorSeq[next];
+    append(&h, sizeof(h));
+}
+
+void CaptureLog::maintain(){
+    if (!ready() || capturing() || _erasedAhead >= CAPTURE_ERASE_AHEAD || _erasedAhead >= _sectorCount - 2) return;
+    int sector = (_sector + 1 + _erasedAhead) % _sectorCount;
+    if (!_store->erase((uint32_t)sector * _sectorSize, _sectorSize)) { _writeErrors++; return; }
+    _sectorSeq[sector] = 0;
+    _erasedAhead++;
+}
+
+void CaptureLog::flushPage(){
+    if (_pageFill == 0) return;
+    memset(_page + _pageFill, 0xFF, _pageSize - _pageFill);	// Erased state, reads back as padding
+    if (!_store->write(_pageOffset, _page, _pageSize)) _writeErrors++;
+    _pageOffset += _pageSize;
+    _pageFill = 0;
+}
+
+void CaptureLog::append(const void* src, uint32_t len){
+    const uint8_t* in = (const uint8_t*)src;
+    while (len > 0) {
+        uint32_t n = _pageSize - _pageFill;
+        if (n > len) n = len;
+        memcpy(_page + _pageFill, in, n);
+        _pageFill += n;
+        in += n;
+        len -= n;
+        if (_pageFill == _pageSize) flushPage();
+    }
+}
+
+bool CaptureLog::appendRecord(uint8_t kind, uint8_t slot, uint32_t nowMs, const void* a, uint16_t aLen, const void* b, uint16_t bLen){
+    const uint32_t total = sizeof(CaptureRecordHeader_t) + aLen + bLen;
+    if (total > _sectorSize - sizeof(CaptureSectorHeader_t)) {
+        _skipped++;
+        return false;
+    }
+    if (sectorRemaining() < total) advance();
+
+    CaptureRecordHeader_t h;
+    h.magic = CAPTURE_RECORD_MAGIC;
+    h.kind = kind;
+    h.slot = slot;
+    h.captureId = _captureId;
+    h.timestampMs = nowMs;
+    h.length = aLen + bLen;
+    h.check = payloadSum((const uint8_t*)b, bLen, payloadSum((const uint8_t*)a, aLen, 0));
+
+    append(&h, sizeof(h));
+    append(a, aLen);
+    if (bLen > 0) append(b, bLen);
+    return true;
+}
+
+void CaptureLog::recordBatch(const InternalMessage_t& msg, uint32_t nowMs){
+    if (!ready()) return;
+
+    if (capturing()) {
+        appendRecord(CAPTURE_BATCH, msg.sensorSlot, nowMs, &msg, sizeof(msg));
+        // Capture complete: get the last partial page onto flash
+        if (--_postLeft == 0) flushPage();
+        return;
+    }
+
+    // Pre-trigger history
+    memcpy(&_pre[_preHead], &msg, sizeof(msg));
+    _preTime[_preHead] = nowMs;
+    _preHead = (_preHead + 1) % CAPTURE_PRE_BATCHES;
+    if (_preCount < CAPTURE_PRE_BATCHES) _preCount++;
+}
+
+void CaptureLog::recordSpectrum(uint8_t slot, SensorDataType type, const DspPipeline& pipeline, uint32_t nowMs){
+    if (!ready() || !capturing()) return;
+
+    CaptureSpectrum_t h;
+    h.type = type;
+    h.bins = (uint16_t)pipeline.bins();
+    h.binHz = pipeline.samplingFrequency() / pipeline.fftSize();
+    uint32_t bytes = sizeof(float) * h.bins;
+    if (bytes > 0xFFFF - sizeof(h)) { _skipped++; return; }
+    appendRecord(CAPTURE_SPECTRUM, slot, nowMs, &h, sizeof(h), pipeline.spectrum(), (uint16_t)bytes);
+}
+
+bool CaptureLog::trigger(uint8_t slot, const CaptureTrigger_t& info, uint32_t nowMs){
+    if (!ready() || capturing()) return false;
+
+    // Each capture starts on a fresh sector, whose sequence doubles as a reboot-proof id
+    const uint32_t emptySector = (uint32_t)_sector * _sectorSize + sizeof(CaptureSectorHeader_t);
+    if (_pageOffset + _pageFill != emptySector) advance();
+    _captureId = _sectorSeq[_sector];
+    _captures++;
+
+    appendRecord(CAPTURE_TRIGGER, slot, nowMs, &info, sizeof(info));
+
+    // History, oldest first
+    int start = (_preHead - _preCount + CAPTURE_PRE_BATCHES) % CAPTURE_PRE_BATCHES;
+    for (int i = 0; i < _preCount; i++) {
+        int k = (start + i) % CAPTURE_PRE_BATCHES;
+        appendRecord(CAPTURE_BATCH, _pre[k].sensorSlot, _preTime[k], &_pre[k], sizeof(_pre[k]));
+    }
+    _preCount = 0;
+    _postLeft = CAPTURE_POST_BATCHES;
+    return true;
+}
+
+uint32_t CaptureLog::logicalSize() const {
+    if (!ready()) return 0;
+    uint32_t used = 0;
+    for (int i = 0; i < _sectorCount; i++) if (_sectorSeq[i] != 0) used++;
+    return used * _sectorSize;
+}
+
+size_t CaptureLog::readLogical(uint32_t offset, uint8_t* dst, size_t len){
+    if (!ready() || len == 0) return 0;
+
+    // k-th used sector, walking from the oldest (just after the write position) around
+    uint32_t k = offset / _sectorSize;
+    uint32_t within = offset % _sectorSize;
+    for (int i = 1; i <= _sectorCount; i++) {
+        int sector = (_sector + i) % _sectorCount;
+        if (_sectorSeq[sector] == 0) continue;
+        if (k-- > 0) continue;
+
+        size_t n = _sectorSize - within;
+        if (n > len) n = len;
+        if (!_store->read((uint32_t)sector * _sectorSize + within, dst, n)) return 0;
+        return n;
+    }
+    return 0;
+}
+
+int CaptureLog::snapshot(uint16_t* sectors, uint32_t* sequences, int max) const {
+    if (!ready()) return 0;
+    int count = 0;
+    for (int i = 1; i <= _sectorCount && count < max; i++) {
+        int sector = (_sector + i) % _sectorCount;
+        if (_sectorSeq[sector] == 0) continue;
+        sectors[count] = (uint16_t)sector;
+        sequences[count] = _sectorSeq[sector];
+        count++;
+    }
+    return count;
+}
+
+size_t CaptureLog::readSnapshot(const uint16_t* sectors, const uint32_t* sequences, int count, uint32_t offset, uint8_t* dst, size_t len){
+    if (!ready() || len == 0) return 0;
+    uint32_t k = offset / _sectorSize;
+    uint32_t within = offset % _sectorSize;
+    if (k >= (uint32_t)count || _sectorSeq[sectors[k]] != sequences[k]) return 0;	// Past the end, or the log wrapped over it
+
+    size_t n = _sectorSize - within;
+    if (n > len) n = len;
+    if (!_store->read((uint32_t)sectors[k] * _sectorSize + within, dst, n)) return 0;
+    return n;
+}
+
+uint32_t CaptureLog::walkSector(const uint8_t* sector, uint32_t sectorSize, uint32_t pageSize, RecordVisitor visit, void* ctx){
+    CaptureSectorHeader_t sh;
+    memcpy(&sh, sector, sizeof(sh));
+    if (sh.magic != CAPTURE_SECTOR_MAGIC || sh.sequence == 0 || sh.sequence == 0xFFFFFFFF) return 0;
+
+    uint32_t pos = sizeof(sh);
+    while (pos + sizeof(CaptureRecordHeader_t) <= sectorSize) {
+        uint16_t magic = (uint16_t)(sector[pos] | (sector[pos + 1] << 8));
+        if (magic == 0xFFFF) {
+            // Padding to the end of the page, or an unwritten page = end of the sector's data
+            if (pos % pageSize == 0) break;
+            pos = (pos / pageSize + 1) * pageSize;
+            continue;
+        }
+        if (magic != CAPTURE_RECORD_MAGIC) break;
+
+        CaptureRecordHeader_t h;
+        memcpy(&h, sector + pos, sizeof(h));
+        const uint8_t* payload = sector + pos + sizeof(h);
+        if (pos + sizeof(h) + h.length > sectorSize) break;
+        visit(h, payload, payloadSum(payload, h.length, 0) == h.check, ctx);
+        pos += sizeof(h) + h.length;
+    }
+    return sh.sequence;
+}
@@ -0,0 +1,140 @@
+#ifndef CAPTURE_LOG_H
+#define CAPTURE_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "FlashStore.h"
+#include "DspPipeline.h"
+
+// Batches kept in RAM before a trigger, and batches logged after it
+#define CAPTURE_PRE_BATCHES 16
+#define CAPTURE_POST_BATCHES 16
+
+// Sectors kept erased ahead of the write position, so a capture does not stall on erases
+#define CAPTURE_ERASE_AHEAD 12
+
+#define CAPTURE_SECTOR_MAGIC 0x47504143		// "CAPG"
+#define CAPTURE_RECORD_MAGIC 0xC47E
+
+enum CaptureRecordKind {
+    CAPTURE_TRIGGER = 1,	// CaptureTrigger_t
+    CAPTURE_BATCH = 2,		// InternalMessage_t, as received
+    CAPTURE_SPECTRUM = 3	// CaptureSpectrum_t + bins floats
+};
+
+// Every sector starts with this, sequence increases by one per sector written
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t sequence;
+} CaptureSectorHeader_t;
+
+// Records never cross a sector. 0xFFFF where a magic is expected = rest of the page is padding.
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t  kind;
+    uint8_t  slot;
+    uint32_t captureId;
+    uint32_t timestampMs;
+    uint16_t length;		// Payload bytes after this header
+    uint16_t check;			// Sum of the payload bytes
+} CaptureRecordHeader_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t alarmCode;
+    int16_t  type;			// SensorDataType
+    float    frequencyHz;
+    float    value;
+    float    limit;
+} CaptureTrigger_t;
+
+typedef struct __attribute__((packed)) {
+    int16_t  type;
+    uint16_t bins;
+    float    binHz;
+} CaptureSpectrum_t;
+
+// Post-mortem capture into a circular log on flash.
+// Raw batches are copied into a RAM ring all the time (CAPTURE_PRE_BATCHES). A trigger
+// writes a trigger record and that history, then the next CAPTURE_POST_BATCHES batches and
+// every spectrum go straight to flash. Only captures are written, which keeps flash wear low.
+//
+// Writes go through a one-page buffer and are appended page by page to pre-erased sectors.
+// The oldest captures are overwritten when the log wraps. Call maintain() when idle to
+// erase ahead. readLogical() serves the used sectors oldest first for a chunked download;
+// snapshot() / readSnapshot() do the same for a download that runs while the log keeps writing.
+class CaptureLog {
+	public:
+		CaptureLog(FlashStore* store);
+		~CaptureLog();
+
+		CaptureLog(const CaptureLog&) = delete;
+		CaptureLog& operator=(const CaptureLog&) = delete;
+
+		// Scans the sector headers and continues after the newest one. False if the store is unusable.
+		bool begin();
+		bool ready() const { return _sectorCount > 0; }
+
+		// Every batch, before its pool slot is released
+		void recordBatch(const InternalMessage_t& msg, uint32_t nowMs);
+		// Spectra are only logged while capturing
+		void recordSpectrum(uint8_t slot, SensorDataType type, const DspPipeline& pipeline, uint32_t nowMs);
+		// Starts a capture unless one is running. Returns true if it started.
+		bool trigger(uint8_t slot, const CaptureTrigger_t& info, uint32_t nowMs);
+
+		// Housekeeping: erases one sector ahead per call when not capturing
+		void maintain();
+
+		bool capturing() const { return _postLeft > 0; }
+		uint32_t captures() const { return _captures; }			// Since boot
+		uint32_t lastCaptureId() const { return _captureId; }	// = sequence of the sector it starts in
+		uint32_t writeErrors() const { return _writeErrors; }
+		uint32_t skippedRecords() const { return _skipped; }	// Larger than a sector (e.g. 4096-point spectra)
+
+		// --- Download: used sectors in write order, oldest first ---
+		uint32_t logicalSize() const;
+		size_t readLogical(uint32_t offset, uint8_t* dst, size_t len);
+		// The same order, fixed when a download starts: used sectors and their sequences (max = sectorCount()).
+		// readSnapshot() returns 0 once a snapshot sector has been erased or reused, which ends the download.
+		int sectorCount() const { return _sectorCount; }
+		int snapshot(uint16_t* sectors, uint32_t* sequences, int max) const;
+		size_t readSnapshot(const uint16_t* sectors, const uint32_t* sequences, int count, uint32_t offset, uint8_t* dst, size_t len);
+
+		// Walks the records of one sector image (from flash or a download), calling
+		// visit(header, payload, checkOk, ctx) for each. Returns the sector sequence, 0 if not a log sector.
+		typedef void (*RecordVisitor)(const CaptureRecordHeader_t& header, const uint8_t* payload, bool checkOk, void* ctx);
+		static uint32_t walkSector(const uint8_t* sector, uint32_t sectorSize, uint32_t pageSize, RecordVisitor visit, void* ctx);
+
+	private:
+		FlashStore*	_store;
+		uint32_t	_sectorSize = 0;
+		uint32_t	_pageSize = 0;
+		int			_sectorCount = 0;
+		uint32_t*	_sectorSeq = nullptr;	// 0 = erased / not ours
+		uint32_t	_nextSeq = 1;
+
+		int			_sector = -1;			// Sector being written
+		uint32_t	_pageOffset = 0;		// Flash address of _page
+		uint8_t*	_page = nullptr;
+		uint32_t	_pageFill = 0;
+		int			_erasedAhead = 0;
+
+		InternalMessage_t*	_pre = nullptr;	// RAM history ring
+		uint32_t*	_preTime = nullptr;
+		int			_preHead = 0;
+		int			_preCount = 0;
+
+		uint32_t	_captureId = 0;
+		uint32_t	_captures = 0;
+		int			_postLeft = 0;
+		uint32_t	_writeErrors = 0;
+		uint32_t	_skipped = 0;
+
+		bool appendRecord(uint8_t kind, uint8_t slot, uint32_t nowMs, const void* a, uint16_t aLen, const void* b = nullptr, uint16_t bLen = 0);
+		void append(const void* src, uint32_t len);
+		void flushPage();
+		void advance();
+		uint32_t sectorRemaining() const { return (uint32_t)(_sector + 1) * _sectorSize - (_pageOffset + _pageFill); }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <string.h>
+#include "ClientPacer.h"
+
+void ClientPacer::reset(uint32_t nowMs){
+    _head = 0;
+    _count = 0;
+    _queuedBytes = 0;
+    _rate = PACER_START_RATE;
+    _drainRate = 0;
+    _tokens = PACER_QUEUE_BYTES;
+    _lastRefillMs = nowMs;
+    _windowStartMs = nowMs;
+    _windowBytes = 0;
+    _windowBacklog = false;
+    _lastDrainMs = nowMs;
+    _sentBytes = 0;
+    memset(_dropped, 0, sizeof(_dropped));
+}
+
+void ClientPacer::refill(uint32_t nowMs){
+    uint32_t elapsed = nowMs - _lastRefillMs;
+    _lastRefillMs = nowMs;
+    _tokens += _rate * (float)elapsed / 1000.0f;
+    if (_tokens > PACER_QUEUE_BYTES) _tokens = PACER_QUEUE_BYTES;
+}
+
+void ClientPacer::observe(size_t queued, uint32_t nowMs){
+    refill(nowMs);
+
+    // The library sends in FIFO order, so whatever left its queue is the oldest of ours
+    if (queued > (size_t)_count) queued = _count;
+    uint32_t drained = 0;
+    for (int n = _count - (int)queued; n > 0; n--) {
+        drained += _sizes[_head];
+        _head = (_head + 1) % PACER_MAX_QUEUE;
+        _count--;
+    }
+    _queuedBytes -= drained;
+    if (drained > 0) {
+        _windowBytes += drained;
+        _lastDrainMs = nowMs;
+    }
+    if (_count > 0 && (uint32_t)(nowMs - _queuedMs[_head]) > PACER_BACKLOG_MS) _windowBacklog = true;
+
+    uint32_t elapsed = nowMs - _windowStartMs;
+    if (elapsed < PACER_WINDOW_MS) return;
+
+    float sample = (float)_windowBytes * 1000.0f / (float)elapsed;
+    if (_windowBacklog) {
+        // The client was the bottleneck, so the sample is its real drain rate: send a bit below it
+        _drainRate = (_drainRate > 0) ? 0.75f * _drainRate + 0.25f * sample : sample;
+        _rate = 0.9f * _drainRate;
+    } else {
+        // Everything drained as fast as it was sent: the sample is only a lower bound, probe upwards
+        if (sample > _drainRate) _drainRate = sample;
+        _rate *= 1.5f;
+    }
+    if (_rate < PACER_MIN_RATE) _rate = PACER_MIN_RATE;
+    if (_rate > PACER_MAX_RATE) _rate = PACER_MAX_RATE;
+
+    _windowStartMs = nowMs;
+    _windowBytes = 0;
+    _windowBacklog = false;
+}
+
+uint32_t ClientPacer::queueLimit() const {
+    // Until the first backlog there is no measurement, allow the full queue
+    if (_drainRate <= 0) return PACER_QUEUE_BYTES;
+    float limit = _drainRate * PACER_LATENCY_MS / 1000.0f;
+    return (limit < PACER_QUEUE_BYTES) ? (uint32_t)limit : PACER_QUEUE_BYTES;
+}
+
+bool ClientPacer::admit(PaceClass cls, size_t bytes, bool heapLow) const {
+    if (_count >= PACER_MAX_QUEUE) return false;
+    if (cls == PACE_CRITICAL) return true;
+    if (heapLow) return false;
+    // Spectra are rare and replace each other, so only the hard cap applies to them;
+    // small messages also keep to the latency target and cannot crowd them out
+    uint32_t limit = (cls == PACE_SPECTRUM) ? PACER_QUEUE_BYTES : queueLimit();
+    if (_count > 0 && _queuedBytes + bytes > limit) return false;
+    return _tokens >= 0;
+}
+
+void ClientPacer::sent(size_t bytes, uint32_t nowMs){
+    if (_count >= PACER_MAX_QUEUE) return;		// Library drops it too
+    int tail = (_head + _count) % PACER_MAX_QUEUE;
+    _sizes[tail] = (bytes > 0xFFFF) ? 0xFFFF : (uint16_t)bytes;
+    _queuedMs[tail] = nowMs;
+    _count++;
+    _queuedBytes += _sizes[tail];
+    _sentBytes += bytes;
+    _tokens -= (float)bytes;
+}
@@ -0,0 +1,98 @@
+#ifndef CLIENT_PACER_H
+#define CLIENT_PACER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Messages tracked per client. AsyncEventSource drops anything past 32 queued messages itself.
+#define PACER_MAX_QUEUE 24
+// Queued bytes above which droppable messages are skipped (one full spectrum always fits in an empty queue)
+#define PACER_QUEUE_BYTES 12288
+// ...and at most this much queueing delay at the measured drain rate, so a slow client gets fresh data
+#define PACER_LATENCY_MS 1000
+// Send-rate limits, bytes/s. A new client starts at PACER_START_RATE and probes upwards while it keeps up.
+#define PACER_MIN_RATE 256.0f
+#define PACER_START_RATE 16384.0f
+#define PACER_MAX_RATE 262144.0f
+// Drain rate is re-estimated at most this often
+#define PACER_WINDOW_MS 250
+// Oldest message waiting longer than this = the client, not the sender, is the bottleneck
+#define PACER_BACKLOG_MS 100
+// A client that has not drained anything for this long is considered stalled
+#define PACER_STALL_MS 15000
+
+enum PaceClass {
+    PACE_CRITICAL = 0,      // Alarms, status, hello: only limited by the queue length
+    PACE_FEATURES,          // Per-spectrum features: dropped when the client is behind
+    PACE_SPECTRUM,          // Full spectrum + time trace: dropped, the next one replaces it
+    PACE_CLASS_COUNT
+};
+
+// Backpressure for one dashboard client (ESPAsyncWebServer queues every message in heap
+// until the socket drains). The owner reports the library's queue depth before each send;
+// the pacer remembers the sizes it let through, so depth changes give the bytes the client
+// actually drained. The send rate follows that drain rate: 90% of it while a backlog builds,
+// growing by half each window while the queue stays empty. Droppable messages pay from a
+// token bucket at that rate and are refused (drop-to-latest) when it is empty, when the
+// queue is over PACER_QUEUE_BYTES, or (for small messages) holds more than PACER_LATENCY_MS
+// of data, or when the caller reports heap pressure.
+// Platform neutral, all times in ms.
+class ClientPacer {
+	public:
+		ClientPacer() { reset(0); }
+
+		void reset(uint32_t nowMs);
+
+		// Call before admit(): queued = messages waiting in the library's queue for this client
+		void observe(size_t queued, uint32_t nowMs);
+		// True if a message of `bytes` may be queued now (no side effects, so it can be asked
+		// before serializing with an estimated size)
+		bool admit(PaceClass cls, size_t bytes, bool heapLow) const;
+		// Records a message handed to the library
+		void sent(size_t bytes, uint32_t nowMs);
+		// Records a message the client did not get because admit() refused it
+		void drop(PaceClass cls) { _dropped[cls]++; }
+
+		// Queue not empty and nothing drained for PACER_STALL_MS
+		bool stalled(uint32_t nowMs) const { return _count > 0 && (uint32_t)(nowMs - _lastDrainMs) > PACER_STALL_MS; }
+
+		float drainRate() const { return _drainRate; }		// bytes/s, measured
+		float sendRate() const { return _rate; }			// bytes/s, allowed
+		uint32_t queuedBytes() const { return _queuedBytes; }
+		int queued() const { return _count; }
+		uint32_t sentBytes() const { return _sentBytes; }
+		uint32_t dropped(PaceClass cls) const { return _dropped[cls]; }
+
+	private:
+		uint16_t	_sizes[PACER_MAX_QUEUE];	// FIFO of message sizes, mirrors the library's queue
+		uint32_t	_queuedMs[PACER_MAX_QUEUE];
+		int			_head;
+		int			_count;
+		uint32_t	_queuedBytes;
+
+		float		_rate;
+		float		_drainRate;
+		float		_tokens;					// Bytes; may go negative after a large message
+		uint32_t	_lastRefillMs;
+		uint32_t	_windowStartMs;
+		uint32_t	_windowBytes;				// Drained in the current window
+		bool		_windowBacklog;				// Oldest message was older than PACER_BACKLOG_MS in this window
+		uint32_t	_lastDrainMs;
+
+		uint32_t	_sentBytes;
+		uint32_t	_dropped[PACE_CLASS_COUNT];
+
+		void refill(uint32_t nowMs);
+		uint32_t queueLimit() const;
+};
+
+inline const char* paceClassName(PaceClass cls){
+    switch (cls) {
+        case PACE_CRITICAL: return "critical";
+        case PACE_FEATURES: return "features";
+        case PACE_SPECTRUM: return "spectrum";
+        default:            return "unk";
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,258 @@
+#if !defined(ARDUINO)
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include "ColumnStore.h"
+
+#define COLUMN_STORE_MAGIC 0x53434E50	// "PNCS"
+#define COLUMN_STORE_VERSION 1
+
+// Per-partition header file, mapped like the columns
+struct ColumnStore::Meta {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t columnCount;
+    uint32_t rowBytes;       // Sum of the column widths, a cheap schema check
+    uint32_t capacity;       // Rows the column files hold
+    uint32_t rows;           // Committed rows, written after the row's columns
+    uint32_t sealed;
+    uint64_t startMs;
+};
+
+uint32_t ColumnStore::Partition::rows() const {
+    return __atomic_load_n(&_meta->rows, __ATOMIC_ACQUIRE);
+}
+
+uint32_t ColumnStore::Partition::lowerBound(uint64_t timeMs) const {
+    const uint64_t* t = time();
+    return (uint32_t)(std::lower_bound(t, t + rows(), timeMs) - t);
+}
+
+ColumnStore::ColumnStore(const char* directory, const ColumnSpec_t* columns, int columnCount, uint32_t partitionSeconds, uint32_t partitionRows)
+	: _directory(directory), _columns(columns), _columnCount(columnCount), _partitionMs(1000ull * partitionSeconds), _partitionRows(partitionRows){
+}
+
+ColumnStore::~ColumnStore(){
+    for (Partition* p : _partitions) {
+        unmapPartition(p);
+        delete p;
+    }
+}
+
+int ColumnStore::columnIndex(const char* name) const {
+    for (int c = 0; c < _columnCount; c++) if (strcmp(_columns[c].name, name) == 0) return c;
+    return -1;
+}
+
+uint64_t ColumnStore::rows() const {
+    uint64_t n = 0;
+    for (const Partition* p : _partitions) n += p->rows();
+    return n;
+}
+
+size_t ColumnStore::mappedBytes() const {
+    size_t bytes = 0;
+    for (const Partition* p : _partitions) {
+        bytes += sizeof(Meta) + fileBytes(p, sizeof(uint64_t));
+        for (int c = 0; c < _columnCount; c++) bytes += fileBytes(p, _columns[c].width);
+    }
+    return bytes;
+}
+
+size_t ColumnStore::fileBytes(const Partition* p, int width) const {
+    return (size_t)p->_capacity * width;
+}
+
+// --- Mapping ---
+// Maps `bytes` of a file, creating / growing it when writable. nullptr on failure.
+static void* mapFile(const std::string& path, size_t bytes, bool writable){
+    int fd = open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && writable && (size_t)st.st_size != bytes) ok = ftruncate(fd, (off_t)bytes) == 0;
+    if (ok && !writable) ok = (size_t)st.st_size >= bytes;
+    void* p = (ok && bytes > 0) ? mmap(nullptr, bytes, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+    close(fd);
+    return (p == MAP_FAILED) ? nullptr : p;
+}
+
+bool ColumnStore::mapPartition(Partition* p, bool writable){
+    p->_meta = (Meta*)mapFile(p->_path + "/meta", sizeof(Meta), writable);
+    if (p->_meta == nullptr) return false;
+    if (p->_capacity == 0) return true;		// Sealed empty partition: nothing else to map
+    p->_time = (uint8_t*)mapFile(p->_path + "/time.col", fileBytes(p, sizeof(uint64_t)), writable);
+    p->_columns.assign(_columnCount, nullptr);
+    bool ok = p->_time != nullptr;
+    for (int c = 0; c < _columnCount && ok; c++) {
+        p->_columns[c] = (uint8_t*)mapFile(p->_path + "/" + _columns[c].name + ".col", fileBytes(p, _columns[c].width), writable);
+        ok = p->_columns[c] != nullptr;
+    }
+    return ok;
+}
+
+void ColumnStore::unmapPartition(Partition* p){
+    if (p->_time) munmap(p->_time, fileBytes(p, sizeof(uint64_t)));
+    for (int c = 0; c < (int)p->_columns.size(); c++) {
+        if (p->_columns[c]) munmap(p->_columns[c], fileBytes(p, _columns[c].width));
+    }
+    if (p->_meta) munmap(p->_meta, sizeof(Meta));
+    p->_time = nullptr;
+    p->_columns.clear();
+    p->_meta = nullptr;
+}
+
+// Cuts the files to the rows written and maps them read-only
+void ColumnStore::seal(Partition* p){
+    if (p->_sealed) return;
+    const uint32_t rows = p->rows();
+    p->_meta->capacity = rows;
+    p->_meta->sealed = 1;
+    msync(p->_meta, sizeof(Meta), MS_SYNC);
+    unmapPartition(p);
+    truncate((p->_path + "/time.col").c_str(), (off_t)rows * sizeof(uint64_t));
+    for (int c = 0; c < _columnCount; c++) truncate((p->_path + "/" + _columns[c].name + ".col").c_str(), (off_t)rows * _columns[c].width);
+    p->_capacity = rows;
+    p->_sealed = true;
+    mapPartition(p, false);
+}
+
+ColumnStore::Partition* ColumnStore::create(uint64_t startMs, int sequence){
+    char name[48];
+    snprintf(name, sizeof(name), "/%llu-%d", (unsigned long long)(startMs / 1000), sequence);
+    Partition* p = new Partition();
+    p->_path = _directory + name;
+    p->_startMs = startMs;
+    p->_sequence = sequence;
+    p->_capacity = _partitionRows;
+    if (mkdir(p->_path.c_str(), 0755) != 0 || !mapPartition(p, true)) {
+        unmapPartition(p);
+        delete p;
+        return nullptr;
+    }
+    uint32_t rowBytes = 0;
+    for (int c = 0; c < _columnCount; c++) rowBytes += _columns[c].width;
+    p->_meta->magic = COLUMN_STORE_MAGIC;
+    p->_meta->version = COLUMN_STORE_VERSION;
+    p->_meta->columnCount = (uint16_t)_columnCount;
+    p->_meta->rowBytes = rowBytes;
+    p->_meta->capacity = _partitionRows;
+    p->_meta->sealed = 0;
+    p->_meta->startMs = startMs;
+    __atomic_store_n(&p->_meta->rows, 0, __ATOMIC_RELEASE);
+    return p;
+}
+
+bool ColumnStore::open(){
+    mkdir(_directory.c_str(), 0755);
+    DIR* dir = opendir(_directory.c_str());
+    if (dir == nullptr) return false;
+
+    uint32_t rowBytes = 0;
+    for (int c = 0; c < _columnCount; c++) rowBytes += _columns[c].width;
+
+    // Partitions of an earlier run, ones with another schema are left alone
+    std::vector<Partition*> found;
+    while (struct dirent* entry = readdir(dir)) {
+        unsigned long long start;
+        int sequence;
+        if (sscanf(entry->d_name, "%llu-%d", &start, &sequence) != 2) continue;
+        std::string path = _directory + "/" + entry->d_name;
+        Meta* meta = (Meta*)mapFile(path + "/meta", sizeof(Meta), false);
+        if (meta == nullptr) continue;
+        bool usable = meta->magic == COLUMN_STORE_MAGIC && meta->version == COLUMN_STORE_VERSION
+                      && meta->columnCount == _columnCount && meta->rowBytes == rowBytes;
+        Partition* p = new Partition();
+        p->_path = path;
+        p->_startMs = meta->startMs;
+        p->_sequence = sequence;
+        p->_sealed = meta->sealed != 0;
+        p->_capacity = meta->capacity;
+        munmap(meta, sizeof(Meta));
+        if (!usable || !mapPartition(p, !p->_sealed)) {
+            fprintf(stderr, "%s: skipped (schema or files do not match)\n", path.c_str());
+            unmapPartition(p);
+            delete p;
+            continue;
+        }
+        found.push_back(p);
+    }
+    closedir(dir);
+
+    std::sort(found.begin(), found.end(), [](const Partition* a, const Partition* b){
+        return (a->_startMs != b->_startMs) ? a->_startMs < b->_startMs : a->_sequence < b->_sequence;
+    });
+    _partitions = found;
+    // Only the newest stays open for appends
+    for (size_t i = 0; i + 1 < _partitions.size(); i++) seal(_partitions[i]);
+    for (const Partition* p : _partitions) {
+        uint32_t n = p->rows();
+        if (n > 0) _lastTimeMs = std::max(_lastTimeMs, p->time()[n - 1]);
+    }
+    return true;
+}
+
+// --- Rows ---
+bool ColumnStore::append(uint64_t timeMs, const void* const* values){
+    if (timeMs < _lastTimeMs) timeMs = _lastTimeMs;		// Time never goes backwards within the store
+    const uint64_t startMs = timeMs - timeMs % _partitionMs;
+
+    Partition* p = _partitions.empty() ? nullptr : _partitions.back();
+    if (p == nullptr || p->_sealed || p->_startMs != startMs || p->rows() >= p->_capacity) {
+        int sequence = (p != nullptr && p->_startMs == startMs) ? p->_sequence + 1 : 0;
+        if (p != nullptr) seal(p);
+        p = create(startMs, sequence);
+        if (p == nullptr) return false;
+        _partitions.push_back(p);
+    }
+
+    const uint32_t row = p->rows();
+    memcpy(p->_time + sizeof(uint64_t) * row, &timeMs, sizeof(uint64_t));
+    for (int c = 0; c < _columnCount; c++) memcpy(p->_columns[c] + (size_t)_columns[c].width * row, values[c], _columns[c].width);
+    __atomic_store_n(&p->_meta->rows, row + 1, __ATOMIC_RELEASE);
+    _lastTimeMs = timeMs;
+    return true;
+}
+
+size_t ColumnStore::scan(uint64_t fromMs, uint64_t toMs, Visitor visit, void* ctx) const {
+    size_t visited = 0;
+    for (const Partition* p : _partitions) {
+        // Partitions are in time order, the binary search skips the rows before fromMs
+        if (p->_startMs >= toMs) break;
+        const uint32_t rows = p->rows();
+        const uint64_t* t = p->time();
+        for (uint32_t r = p->lowerBound(fromMs); r < rows && t[r] < toMs; r++) {
+            visited++;
+            if (!visit(*p, r, ctx)) return visited;
+        }
+    }
+    return visited;
+}
+
+int ColumnStore::dropBefore(uint64_t timeMs){
+    int dropped = 0;
+    // A partition is over once the next one has started; the newest never goes
+    while (_partitions.size() > 1 && _partitions[1]->_startMs <= timeMs) {
+        Partition* p = _partitions.front();
+        uint32_t rows = p->rows();
+        if (rows > 0 && p->time()[rows - 1] >= timeMs) break;
+        unmapPartition(p);
+        unlink((p->_path + "/meta").c_str());
+        unlink((p->_path + "/time.col").c_str());
+        for (int c = 0; c < _columnCount; c++) unlink((p->_path + "/" + _columns[c].name + ".col").c_str());
+        rmdir(p->_path.c_str());
+        _partitions.erase(_partitions.begin());
+        delete p;
+        dropped++;
+    }
+    return dropped;
+}
+
+#endif
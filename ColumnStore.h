@@ -0,0 +1,99 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#if !defined(ARDUINO)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// One fixed-width column of a table (width in bytes per row)
+typedef struct {
+    const char* name;
+    uint16_t    width;
+} ColumnSpec_t;
+
+// Append-only, time-partitioned columnar table on Linux (tools/Gateway).
+//
+// Rows carry a time (ms) that never goes backwards plus the fixed-width columns of the schema.
+// Partitions cover partitionSeconds of time each (aligned to multiples of it), or fewer when
+// they fill up: <directory>/<start s>-<n>/, one file per column plus "time.col" and "meta".
+// Column files are created at partitionRows rows (sparse) and memory-mapped, so an append is
+// a few stores into the page cache and a scan reads one column without touching the others.
+// The row count in "meta" is written last and is the commit point: a crash loses at most the
+// row being appended. A full or past partition is sealed: its files are cut to the rows it has
+// and mapped read-only. Old partitions are dropped whole (dropBefore).
+class ColumnStore {
+	private:
+		struct Meta;
+
+	public:
+		class Partition {
+			public:
+				uint64_t startMs() const { return _startMs; }
+				uint32_t rows() const;
+				const uint64_t* time() const { return (const uint64_t*)_time; }
+				const uint8_t* column(int c) const { return _columns[c]; }
+				// First row at or after timeMs (rows() if none)
+				uint32_t lowerBound(uint64_t timeMs) const;
+
+			private:
+				friend class ColumnStore;
+				std::string	_path;
+				uint64_t	_startMs = 0;
+				int			_sequence = 0;
+				bool		_sealed = false;
+				uint32_t	_capacity = 0;
+				Meta*		_meta = nullptr;
+				uint8_t*	_time = nullptr;
+				std::vector<uint8_t*> _columns;
+		};
+
+		// Visits one row; return false to stop the scan
+		typedef bool (*Visitor)(const Partition& partition, uint32_t row, void* ctx);
+
+		// columns must stay valid for the store's lifetime
+		ColumnStore(const char* directory, const ColumnSpec_t* columns, int columnCount, uint32_t partitionSeconds = 3600, uint32_t partitionRows = 65536);
+		~ColumnStore();
+
+		ColumnStore(const ColumnStore&) = delete;
+		ColumnStore& operator=(const ColumnStore&) = delete;
+
+		// Creates the directory, maps the partitions already there (appends continue in the newest)
+		bool open();
+
+		// values[c]: columns[c].width bytes. False if the partition could not be created.
+		bool append(uint64_t timeMs, const void* const* values);
+
+		// Rows with fromMs <= time < toMs, oldest first. Returns the rows visited.
+		size_t scan(uint64_t fromMs, uint64_t toMs, Visitor visit, void* ctx) const;
+
+		// Removes the partitions that end before timeMs. Returns how many went.
+		int dropBefore(uint64_t timeMs);
+
+		int columnIndex(const char* name) const;
+		int partitionCount() const { return (int)_partitions.size(); }
+		uint64_t rows() const;
+		uint64_t lastTimeMs() const { return _lastTimeMs; }
+		size_t mappedBytes() const;
+
+	private:
+		std::string	_directory;
+		const ColumnSpec_t* _columns;
+		int			_columnCount;
+		uint64_t	_partitionMs;
+		uint32_t	_partitionRows;
+		uint64_t	_lastTimeMs = 0;
+		std::vector<Partition*> _partitions;	// Oldest first, only the last one is open for appends
+
+		Partition* create(uint64_t startMs, int sequence);
+		bool mapPartition(Partition* p, bool writable);
+		void unmapPartition(Partition* p);
+		void seal(Partition* p);
+		size_t fileBytes(const Partition* p, int width) const;
+};
+
+#endif
+
+#endif
\ No newline at end of file
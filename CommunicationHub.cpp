@@ -1,98 +1,133 @@
-#include <Arduino.h>
-#include "CommunicationHub.h"
-
-CommunicationHub::CommunicationHub(int port, int max) : _tcpServer(port), _CommunicationPort(port), _MaxSensorsCount(max) {
-    _clients = new WiFiClient[_MaxSensorsCount];
-}
-
-void CommunicationHub::taskWrapper(void* pvParameters) {
-	CommunicationHub* instance = (CommunicationHub*) pvParameters; 
-    instance->connectionWorker();
-}
-
-void CommunicationHub::begin(QueueHandle_t vQ, QueueHandle_t cQ, const char* ssid, const char* password){
-	
-	WiFi.softAP(ssid, password);
-    Serial.print("Access Point Started. IP: "); 
-    Serial.println(WiFi.softAPIP());
-	
-	_vibQueue = vQ;
-	_curQueue = cQ;
-	
-	_tcpServer.begin();
-    _tcpServer.setNoDelay(true);
-	
-	xTaskCreatePinnedToCore(
-        taskWrapper,    // Function to run
-        "ConnTask",     // Name
-        10000,           // Stack size
-        this,           // PASSING THE INSTANCE
-        1,              // Priority
-        NULL,           // Task handle
-        0               // Core 0
-    );
-	
-}
-
-void CommunicationHub::connectionWorker() {
-    DataPacket_t tempPacket; 
-    InternalMessage_t qMsg;    
-
-    for(;;) {
-        // --- Accept New Clients ---
-        if (_tcpServer.hasClient()) {
-            WiFiClient newClient = _tcpServer.available();
-            bool assigned = false;
-            // Find an empty slot
-            for (int i = 0; i < _MaxSensorsCount; i++) {
-                if (!_clients[i] || !_clients[i].connected()) {
-                    _clients[i] = newClient;
-                    Serial.printf("Client connected to slot %d\n", i);
-                    assigned = true;
-                    break;
-                }
-            }
-            if (!assigned) {
-                newClient.stop(); // No room
-            }
-        }
-
-        // --- Read Data from Connected Clients ---
-        for (int i = 0; i < _MaxSensorsCount; i++) {
-            if (_clients[i] && _clients[i].connected()) {
-                
-                // Check if we have a FULL packet (1028 bytes)
-                if (_clients[i].available() >= sizeof(DataPacket_t)) {
-                    
-                    // Read the binary struct directly
-                    _clients[i].readBytes((char*)&tempPacket, sizeof(DataPacket_t));
-
-                    // Verify Header to ensure data integrity
-                    if (tempPacket.header == PACKET_HEADER) {
-                        
-                        // Map to internal message
-                        if (tempPacket.type == TYPE_VIBRATION) qMsg.type = TYPE_VIBRATION;
-                        else if (tempPacket.type == TYPE_CURRENT) qMsg.type = TYPE_CURRENT;
-                        else qMsg.type = TYPE_UNKNOWN;
-
-                        if (qMsg.type != TYPE_UNKNOWN) {
-                            memcpy(qMsg.data, tempPacket.data, sizeof(qMsg.data));
-                            
-                            QueueHandle_t target = (qMsg.type == TYPE_VIBRATION) ? _vibQueue : _curQueue;
-                            
-                            // Send to Queue with 0 wait time.
-                            // If Queue is full, we DROP the packet. This prevents lag.
-                            xQueueSend(target, &qMsg, 0);
-                        }
-                    } else {
-                        // Header mismatch: We lost sync. Flush the buffer.
-                        Serial.println("Sync Error: Flushing buffer...");
-                        while(_clients[i].available()) _clients[i].read();
-                    }
-                }
-            }
-        }
-        // Small yield to let WiFi stack process background tasks
-        vTaskDelay(2); 
-    }
-}
+#include <Arduino.h>
+#include "CommunicationHub.h"
+#include "lwip/sockets.h"
+
+// Longest the hub sleeps in select() before checking for new connections
+static const uint32_t ACCEPT_POLL_INTERVAL = 20;
+
+CommunicationHub::CommunicationHub(int port, int max) : _tcpServer(port), _CommunicationPort(port), _MaxSensorsCount(max) {
+}
+
+void CommunicationHub::taskWrapper(void* pvParameters) {
+	CommunicationHub* instance = (CommunicationHub*) pvParameters; 
+    instance->connectionWorker();
+}
+
+void CommunicationHub::begin(BatchRing* rings, BatchPool* pool, const DspScheduler* scheduler, const TaskHandle_t* workers, const char* ssid, const char* password){
+	
+	// Room for every sensor node plus dashboard viewers (ESP32 soft-AP limit is 10)
+	WiFi.softAP(ssid, password, 1, 0, min(_MaxSensorsCount + 2, 10));
+    Serial.print("Access Point Started. IP: "); 
+    Serial.println(WiFi.softAPIP());
+	
+	_rings = rings;
+	_pool = pool;
+	_scheduler = scheduler;
+	_workers = workers;
+	_clients = arenaNew<WiFiClient>(_MaxSensorsCount, MEM_FAST, "hub");
+	_links = arenaNew<SensorLink>(_MaxSensorsCount, MEM_FAST, "hub");
+	for (int i = 0; i < _MaxSensorsCount; i++) _links[i].attach(i, &_rings[i], _pool, &_enqueueStage);
+	
+	_tcpServer.begin();
+    _tcpServer.setNoDelay(true);
+	
+	_taskHandle = arenaTask(
+        taskWrapper,    // Function to run
+        "ConnTask",     // Name
+        HUB_TASK_STACK, // Stack size
+        this,           // PASSING THE INSTANCE
+        HUB_TASK_PRIORITY, // Priority
+        0               // Core 0
+    );
+	
+}
+
+void CommunicationHub::connectionWorker() {
+    for(;;) {
+        // --- Sleep until a client socket has data (or it is time to check for new clients) ---
+        waitForData(ACCEPT_POLL_INTERVAL);
+
+        // --- Accept New Clients ---
+        if (_tcpServer.hasClient()) {
+            WiFiClient newClient = _tcpServer.available();
+            bool assigned = false;
+            // Find an empty slot
+            for (int i = 0; i < _MaxSensorsCount; i++) {
+                if (!_clients[i] || !_clients[i].connected()) {
+                    _links[i].reset();
+                    _clients[i] = newClient;
+                    Serial.printf("Client connected to slot %d\n", i);
+                    assigned = true;
+                    break;
+                }
+            }
+            if (!assigned) {
+                newClient.stop(); // No room
+            }
+        }
+
+        // --- Read Data from Connected Clients ---
+        for (int i = 0; i < _MaxSensorsCount; i++) {
+            if (_clients[i] && _clients[i].connected()) {
+                serviceClient(i);
+            }
+        }
+    }
+}
+
+void CommunicationHub::waitForData(uint32_t timeoutMs){
+    fd_set readable;
+    FD_ZERO(&readable);
+    int maxFd = -1;
+
+    for (int i = 0; i < _MaxSensorsCount; i++) {
+        if (!_clients[i] || !_clients[i].connected()) continue;
+        // Bytes already buffered inside WiFiClient: no need to wait
+        if (_clients[i].available() > 0) return;
+        int fd = _clients[i].fd();
+        if (fd < 0) continue;
+        FD_SET(fd, &readable);
+        if (fd > maxFd) maxFd = fd;
+    }
+
+    if (maxFd < 0) {
+        // No sensors yet, just give the WiFi stack the core
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        return;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = timeoutMs * 1000;
+    lwip_select(maxFd + 1, &readable, NULL, NULL, &tv);
+}
+
+void CommunicationHub::serviceClient(int i){
+    WiFiClient& client = _clients[i];
+    SensorLink& link = _links[i];
+
+    // Consume whatever is there, the parser keeps partial packets between passes
+    int avail;
+    while ((avail = client.available()) > 0) {
+        uint32_t start = Perf::cycles();
+        size_t n = link.want();
+        if (n > (size_t)avail) n = avail;
+
+        int got = client.read(link.writePtr(), n);
+        if (got <= 0) break;
+
+        uint32_t droppedBefore = link.parser().droppedBytes();
+        PacketParser::Event event = link.commit(got);
+        _parseStage.add(Perf::cycles() - start);
+
+        if (event == PacketParser::EVENT_HEADER && link.parser().droppedBytes() != droppedBefore) {
+            Serial.printf("Sync Error: slot %d resynced\n", i);
+        }
+        if (event == PacketParser::EVENT_PACKET) {
+            uint32_t wake = _scheduler->wakeMask(i);
+            for (int w = 0; w < _scheduler->workerCount(); w++) {
+                if (wake & (1u << w)) xTaskNotifyGive(_workers[w]);
+            }
+        }
+    }
+}
@@ -1,30 +1,64 @@
-#ifndef COMMUNICATION_HUB_H
-#define COMMUNICATION_HUB_H
-
-#include <Arduino.h>
-#include <WiFi.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
-#include "freertos/task.h" 
-#include "Protocol.h"
-
-class CommunicationHub {
-    public:
-        CommunicationHub(int CommunicationPort = 8888, int MaxSensorsCount = 2);
-        void begin(QueueHandle_t vQ, QueueHandle_t cQ, const char* ssid = "ESP Server Access Point" , const char* password = "123456789");
-    
-    private:
-        int _CommunicationPort;
-        int _MaxSensorsCount;
-        WiFiServer _tcpServer;
-		WiFiClient* _clients;
-        
-        QueueHandle_t _vibQueue;
-        QueueHandle_t _curQueue;
-		
-        void connectionWorker();
-		
-        static void taskWrapper(void* pvParameters);
-};
-
+#ifndef COMMUNICATION_HUB_H
+#define COMMUNICATION_HUB_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h" 
+#include "Protocol.h"
+#include "BatchPool.h"
+#include "SensorLink.h"
+#include "PerfCounters.h"
+#include "MemoryArena.h"
+#include "DspScheduler.h"
+
+// Connection task stack, bytes. /metrics reports the lowest free stack (pnb_task_stack_free_bytes).
+#define HUB_TASK_STACK 8192
+// Above the DSP helper sharing core 0 (DSP_TASK_PRIORITY): sockets are served first
+#define HUB_TASK_PRIORITY 2
+
+class CommunicationHub {
+    public:
+        CommunicationHub(int CommunicationPort = 8888, int MaxSensorsCount = 2);
+        // Client slots and the task stack come from the caller's ArenaScope (see arenaBytes).
+        // After each handed-over batch the DSP workers the scheduler names are notified (workers[i] per worker).
+        void begin(BatchRing* rings, BatchPool* pool, const DspScheduler* scheduler, const TaskHandle_t* workers, const char* ssid = "ESP Server Access Point" , const char* password = "123456789");
+
+        // MemoryArena budget of begin() (MEM_FAST)
+        static constexpr size_t arenaBytes(int maxSensors){
+            return arenaRound(sizeof(WiFiClient) * maxSensors) + arenaRound(sizeof(SensorLink) * maxSensors) + arenaRound(HUB_TASK_STACK) + arenaRound(sizeof(StaticTask_t));
+        }
+
+        // --- Metrics (read by ProcessingCore for /metrics) ---
+        int maxClients() const { return _MaxSensorsCount; }
+        const PacketParser& parser(int i) const { return _links[i].parser(); }
+        uint32_t bytesReceived(int i) const { return _links[i].bytesReceived(); }
+        const PerfStage& parseStage() const { return _parseStage; }
+        const PerfStage& enqueueStage() const { return _enqueueStage; }
+        TaskHandle_t taskHandle() const { return _taskHandle; }
+    
+    private:
+        int _CommunicationPort;
+        int _MaxSensorsCount;
+        WiFiServer _tcpServer;
+		WiFiClient* _clients;
+		SensorLink* _links;			// Parser + BatchPool handoff per client slot
+        
+        BatchRing* _rings;				// One per client slot, carries BatchPool slot indices
+        BatchPool* _pool;
+        const DspScheduler* _scheduler;	// Whom to wake after every handed-over batch
+        const TaskHandle_t* _workers;
+        TaskHandle_t _taskHandle = NULL;
+
+        PerfStage _parseStage;			// Socket read + parser, per chunk
+        PerfStage _enqueueStage;		// Ring push + notify, per packet
+		
+        void connectionWorker();
+        void waitForData(uint32_t timeoutMs);
+        void serviceClient(int i);
+		
+        static void taskWrapper(void* pvParameters);
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include <math.h>
+#include <string.h>
+#include "CorrelationEngine.h"
+#include "RealFft.h"
+#include "MemoryArena.h"
+
+// Low bins left out of the peak search and the coherent power (DC leakage), as in FeatureExtractor
+static const int SKIP_BINS = 2;
+// Batches before a stream's clock offset is used
+static const int CLOCK_LOCK_BATCHES = 8;
+// A v2 timestamp this far off the expected one is a sensor restart: the offset filter starts over
+static const int32_t CLOCK_RESET_US = 1000000;
+// Order tracking: search +-10% around the nominal speed, the peak must stand out of that band
+static const float SPEED_SEARCH = 0.1f;
+static const float SPEED_PROMINENCE = 4.0f;
+
+CorrelationEngine::CorrelationEngine(DspPipeline& current, DspPipeline& vibration, int points, int hopSize) : _points(points){
+	_hopSize	= (hopSize <= 0 || hopSize > points) ? points / 2 : hopSize;
+	_samplingFrequency = current.samplingFrequency();
+	_binHz		= _samplingFrequency / points;
+	_hopUs		= (uint32_t)(1e6 * _hopSize / _samplingFrequency);
+	_streams[0].pipeline = &current;
+	_streams[1].pipeline = &vibration;
+
+	// Slack for lining up the two streams (they arrive up to a batch or so apart)
+	current.reserveHistory(2 * points);
+	vibration.reserveHistory(2 * points);
+
+	_window		= arenaNew<float>(points, MEM_FAST, "correlate");
+	_cos		= arenaNew<float>(points, MEM_FAST, "correlate");
+	_sin		= arenaNew<float>(points, MEM_FAST, "correlate");
+	_work		= arenaNew<float>(2 * points, MEM_FAST, "correlate");
+	_orderFrame	= arenaNew<float>(CORR_ORDER_BINS, MEM_FAST, "correlate");
+	_sxx		= arenaNew<float>(points / 2, MEM_BULK, "correlate");
+	_syy		= arenaNew<float>(points / 2, MEM_BULK, "correlate");
+	_sxyRe		= arenaNew<float>(points / 2, MEM_BULK, "correlate");
+	_sxyIm		= arenaNew<float>(points / 2, MEM_BULK, "correlate");
+	_orders		= arenaNew<float>(CORR_ORDER_BINS, MEM_BULK, "correlate");
+	RealFftDetail::buildComplexTables(points, _window, _cos, _sin);
+	reset();
+}
+
+CorrelationEngine::~CorrelationEngine(){
+	arenaDelete(_window); arenaDelete(_cos); arenaDelete(_sin); arenaDelete(_work); arenaDelete(_orderFrame);
+	arenaDelete(_sxx); arenaDelete(_syy); arenaDelete(_sxyRe); arenaDelete(_sxyIm); arenaDelete(_orders);
+}
+
+bool CorrelationEngine::compatible(const DspPipeline& current, const DspPipeline& vibration, int points){
+    return points >= 4 && (points & (points - 1)) == 0 && points <= current.fftSize() && points <= vibration.fftSize()
+        && current.samplingFrequency() == vibration.samplingFrequency();
+}
+
+void CorrelationEngine::reset(){
+    for (int i = 0; i < 2; i++) {
+        Stream& s = _streams[i];
+        s.sensorEndUs = 0;
+        s.countUs = 0;
+        s.offsetUs = 0;
+        s.bucketMin = 0;
+        s.previousMin = 0;
+        s.bucketCount = 0;
+        s.havePrevious = false;
+        s.locked = false;
+        s.started = false;
+        s.contiguous = 0;
+    }
+    memset(_sxx, 0, sizeof(float) * (_points / 2));
+    memset(_syy, 0, sizeof(float) * (_points / 2));
+    memset(_sxyRe, 0, sizeof(float) * (_points / 2));
+    memset(_sxyIm, 0, sizeof(float) * (_points / 2));
+    memset(_orders, 0, sizeof(float) * CORR_ORDER_BINS);
+    memset(&_summary, 0, sizeof(_summary));
+    _summary.runningHz = _trackedHz;
+    _haveFrame = false;
+    _skipped = 0;
+    _gaps = 0;
+}
+
+size_t CorrelationEngine::memoryBytes() const {
+    return sizeof(float) * (7 * (size_t)_points + 2 * CORR_ORDER_BINS);
+}
+
+bool CorrelationEngine::onBatch(const DspPipeline& source, const BatchInfo_t& info, uint32_t nowUs){
+    for (int i = 0; i < 2; i++) {
+        if (_streams[i].pipeline == &source) {
+            observe(_streams[i], info, nowUs);
+            return tryFrame();
+        }
+    }
+    return false;
+}
+
+// --- Timeline ---
+void CorrelationEngine::observe(Stream& s, const BatchInfo_t& info, uint32_t nowUs){
+    const int n = s.pipeline->batchSamples();
+    const double sampleUs = 1e6 / _samplingFrequency;
+    bool restart = !s.started;
+
+    uint32_t end;
+    if (info.version >= PACKET_VERSION_V2) {
+        end = info.timestampUs + (uint32_t)lround((n - 1) * sampleUs);
+        if (s.started) {
+            // Where this batch should have ended had nothing been lost in between
+            int32_t jump = (int32_t)(end - s.sensorEndUs - (uint32_t)lround(n * sampleUs));
+            if (fabs((double)jump) > 0.5 * n * sampleUs) {
+                s.contiguous = 0;
+                _gaps++;
+            }
+            if (jump > CLOCK_RESET_US || jump < -CLOCK_RESET_US) restart = true;
+        }
+    } else {
+        // No timestamp: the samples themselves are the clock (lost batches go unnoticed)
+        s.countUs += n * sampleUs;
+        if (s.countUs >= 4294967296.0) s.countUs -= 4294967296.0;
+        end = (uint32_t)s.countUs;
+    }
+    s.sensorEndUs = end;
+    s.started = true;
+    int limit = s.pipeline->ringSize();
+    s.contiguous = (s.contiguous + n < limit) ? s.contiguous + n : limit;
+
+    // Windowed minimum of hub - sensor: the least delayed batch of the last one to two windows
+    uint32_t sample = nowUs - end;
+    if (restart) {
+        s.bucketCount = 0;
+        s.havePrevious = false;
+    }
+    if (s.bucketCount == 0 || (int32_t)(sample - s.bucketMin) < 0) s.bucketMin = sample;
+    s.offsetUs = s.bucketMin;
+    if (s.havePrevious && (int32_t)(s.previousMin - s.offsetUs) < 0) s.offsetUs = s.previousMin;
+    s.locked = s.havePrevious || s.bucketCount + 1 >= CLOCK_LOCK_BATCHES;
+    if (++s.bucketCount == CORR_CLOCK_WINDOW) {
+        s.previousMin = s.bucketMin;
+        s.havePrevious = true;
+        s.bucketCount = 0;
+    }
+}
+
+bool CorrelationEngine::tryFrame(){
+    const Stream& x = _streams[0];
+    const Stream& y = _streams[1];
+    if (!x.locked || !y.locked) return false;
+
+    // Common end: the newest moment both streams have reached
+    const uint32_t endX = x.hubEndUs(), endY = y.hubEndUs();
+    const int32_t skew = (int32_t)(endX - endY);
+    const uint32_t common = (skew > 0) ? endY : endX;
+    if (_haveFrame && (int32_t)(common - _lastFrameUs) < (int32_t)_hopUs) return false;
+
+    // Sample age of `common` in each ring, exact and rounded
+    const double ax = (double)(int32_t)(endX - common) * _samplingFrequency * 1e-6;
+    const double ay = (double)(int32_t)(endY - common) * _samplingFrequency * 1e-6;
+    const int ageX = (int)lround(ax), ageY = (int)lround(ay);
+    const int haveX = (x.contiguous < x.pipeline->filled()) ? x.contiguous : x.pipeline->filled();
+    const int haveY = (y.contiguous < y.pipeline->filled()) ? y.contiguous : y.pipeline->filled();
+    if (haveX < _points || haveY < _points) return false;		// Starting up, or after a gap
+    if (ageX + _points > haveX || ageY + _points > haveY) {
+        // Too far apart for the ring slack: skip this hop
+        _skipped++;
+        _lastFrameUs = common;
+        _haveFrame = true;
+        return false;
+    }
+
+    compute(ageX, ageY, (float)((ax - ageX) - (ay - ageY)));
+    _lastFrameUs = common;
+    _haveFrame = true;
+    summarise(skew);
+    return true;
+}
+
+// --- Spectra ---
+// shift: how many samples later than y's window x's window was taken
+void CorrelationEngine::compute(int ageX, int ageY, float shift){
+    const int n = _points, half = n / 2;
+    const DspPipeline& px = *_streams[0].pipeline;
+    const DspPipeline& py = *_streams[1].pipeline;
+
+    // 1. Both windows, mean removed, packed as x + jy (oldest sample first)
+    float meanX = 0, meanY = 0;
+    for (int i = 0; i < n; i++) {
+        meanX += px.recentSample(ageX + i);
+        meanY += py.recentSample(ageY + i);
+    }
+    meanX /= n;
+    meanY /= n;
+    for (int i = 0; i < n; i++) {
+        _work[2 * i] = (px.recentSample(ageX + n - 1 - i) - meanX) * _window[i];
+        _work[2 * i + 1] = (py.recentSample(ageY + n - 1 - i) - meanY) * _window[i];
+    }
+    RealFftDetail::complexFft(n, _cos, _sin, _work);
+
+    // 2. Split X = (Z[k] + Z*[n-k]) / 2, Y = (Z[k] - Z*[n-k]) / 2j; fold into the averages.
+    // The cross term is turned back by the sub-sample shift: e^(j 2pi k shift / n).
+    const float weight = (_summary.frames < CORR_AVERAGE_FRAMES) ? 1.0f / (_summary.frames + 1) : 1.0f / CORR_AVERAGE_FRAMES;
+    const double step = 2.0 * M_PI * shift / n;
+    const double stepRe = cos(step), stepIm = sin(step);
+    double rotRe = 1.0, rotIm = 0.0;
+    for (int k = 0; k < half; k++) {
+        const float* a = &_work[2 * k];
+        const float* b = &_work[2 * ((n - k) & (n - 1))];
+        const float xr = 0.5f * (a[0] + b[0]), xi = 0.5f * (a[1] - b[1]);
+        const float yr = 0.5f * (a[1] + b[1]), yi = -0.5f * (a[0] - b[0]);
+        const float cr = xr * yr + xi * yi, ci = xr * yi - xi * yr;		// X* Y
+        const float sr = (float)(cr * rotRe - ci * rotIm), si = (float)(cr * rotIm + ci * rotRe);
+        const float pyy = yr * yr + yi * yi;
+
+        _sxx[k] += weight * (xr * xr + xi * xi - _sxx[k]);
+        _syy[k] += weight * (pyy - _syy[k]);
+        _sxyRe[k] += weight * (sr - _sxyRe[k]);
+        _sxyIm[k] += weight * (si - _sxyIm[k]);
+
+        double r = rotRe * stepRe - rotIm * stepIm;
+        rotIm = rotRe * stepIm + rotIm * stepRe;
+        rotRe = r;
+        // Z[k / 2] is used up: keep this frame's vibration power for the order spectrum
+        _work[k] = pyy;
+    }
+
+    // 3. Order spectrum on this frame's speed
+    _trackedHz = trackSpeed(_work);
+    if (_trackedHz <= 0) return;
+    memset(_orderFrame, 0, sizeof(float) * CORR_ORDER_BINS);
+    const float ordersPerBin = _binHz / _trackedHz * CORR_ORDER_RESOLUTION;
+    for (int k = SKIP_BINS; k < half; k++) {
+        const float o = k * ordersPerBin;
+        const int i = (int)o;
+        if (i + 1 >= CORR_ORDER_BINS) break;
+        const float f = o - i;
+        _orderFrame[i] += (1.0f - f) * _work[k];
+        _orderFrame[i + 1] += f * _work[k];
+    }
+    for (int i = 0; i < CORR_ORDER_BINS; i++) _orders[i] += weight * (_orderFrame[i] - _orders[i]);
+}
+
+// 1x peak within SPEED_SEARCH of the nominal speed (interpolated), else the last tracked speed
+float CorrelationEngine::trackSpeed(const float* power) const {
+    if (_nominalHz <= 0) return 0;
+    int lo = (int)floorf((1.0f - SPEED_SEARCH) * _nominalHz / _binHz);
+    int hi = (int)ceilf((1.0f + SPEED_SEARCH) * _nominalHz / _binHz);
+    if (lo < SKIP_BINS) lo = SKIP_BINS;
+    if (hi > _points / 2 - 2) hi = _points / 2 - 2;
+    if (hi <= lo) return _trackedHz;
+
+    int peak = lo;
+    float sum = 0;
+    for (int k = lo; k <= hi; k++) {
+        sum += power[k];
+        if (power[k] > power[peak]) peak = k;
+    }
+    if (power[peak] < SPEED_PROMINENCE * sum / (hi - lo + 1)) return _trackedHz;
+
+    const float l = sqrtf(power[peak - 1]), c = sqrtf(power[peak]), r = sqrtf(power[peak + 1]);
+    const float d = l - 2.0f * c + r;
+    const float delta = (d != 0) ? 0.5f * (l - r) / d : 0.0f;
+    return (peak + delta) * _binHz;
+}
+
+void CorrelationEngine::summarise(int32_t skewUs){
+    float total = 0, coherent = 0;
+    int peak = SKIP_BINS;
+    for (int k = SKIP_BINS; k < _points / 2; k++) {
+        total += _syy[k];
+        coherent += coherence(k) * _syy[k];
+        if (_syy[k] > _syy[peak]) peak = k;
+    }
+    _summary.frames++;
+    _summary.coherentPower = (total > 0) ? coherent / total : 0;
+    _summary.peakHz = peak * _binHz;
+    _summary.peakCoherence = coherence(peak);
+    _summary.peakPhaseDeg = phaseDeg(peak);
+    _summary.runningHz = _trackedHz;
+    _summary.skewUs = skewUs;
+
+    CorrelationVerdict verdict = CORR_UNDECIDED;
+    if (_summary.frames >= CORR_AVERAGE_FRAMES) {
+        if (_summary.peakCoherence >= CORR_ELECTRICAL_COHERENCE) verdict = CORR_ELECTRICAL;
+        else if (_summary.peakCoherence <= CORR_MECHANICAL_COHERENCE) verdict = CORR_MECHANICAL;
+    }
+    _summary.verdict = (uint8_t)verdict;
+}
+
+float CorrelationEngine::coherence(int bin) const {
+    const float d = _sxx[bin] * _syy[bin];
+    if (d <= 0) return 0;
+    const float g = (_sxyRe[bin] * _sxyRe[bin] + _sxyIm[bin] * _sxyIm[bin]) / d;
+    return (g > 1.0f) ? 1.0f : g;
+}
+
+float CorrelationEngine::phaseDeg(int bin) const {
+    return atan2f(_sxyIm[bin], _sxyRe[bin]) * (float)(180.0 / M_PI);
+}
+
+float CorrelationEngine::crossMagnitude(int bin) const {
+    return sqrtf(sqrtf(_sxyRe[bin] * _sxyRe[bin] + _sxyIm[bin] * _sxyIm[bin]));
+}
+
+float CorrelationEngine::orderMagnitude(int bin) const {
+    return sqrtf(_orders[bin]);
+}
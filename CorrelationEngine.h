@@ -0,0 +1,148 @@
+#ifndef CORRELATION_ENGINE_H
+#define CORRELATION_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "DspPipeline.h"
+
+// Frames averaged into the cross / auto spectra (linear until then, exponential after)
+#define CORR_AVERAGE_FRAMES 16
+// Order spectrum: CORR_ORDER_BINS bins of 1 / CORR_ORDER_RESOLUTION order (0 .. 16x running speed)
+#define CORR_ORDER_RESOLUTION 8
+#define CORR_ORDER_BINS 128
+// Batches per half of the windowed-minimum clock offset filter (two halves, ~16 s each at 1 kHz)
+#define CORR_CLOCK_WINDOW 64
+// Peak coherence above / below which the strongest vibration line is called electrical / mechanical
+#define CORR_ELECTRICAL_COHERENCE 0.7f
+#define CORR_MECHANICAL_COHERENCE 0.3f
+
+enum CorrelationVerdict {
+    CORR_UNDECIDED = 0,      // Not enough frames, or coherence in between
+    CORR_MECHANICAL,         // The vibration peak is not explained by the current
+    CORR_ELECTRICAL          // It moves with the current (e.g. 2x line frequency magnetic forces)
+};
+
+inline const char* correlationVerdictName(CorrelationVerdict verdict){
+    switch (verdict) {
+        case CORR_MECHANICAL: return "mechanical";
+        case CORR_ELECTRICAL: return "electrical";
+        default:              return "undecided";
+    }
+}
+
+// Result of the latest frame, averaged spectra behind it
+typedef struct {
+    uint32_t frames;
+    float    coherentPower;  // Share of the vibration power linearly explained by the current, 0..1
+    float    peakHz;         // Strongest averaged vibration bin (DC bins skipped)
+    float    peakCoherence;
+    float    peakPhaseDeg;   // Vibration relative to current at peakHz
+    float    runningHz;      // Tracked speed the order spectrum is built on
+    int32_t  skewUs;         // Hub-time gap between the two streams' newest samples
+    uint8_t  verdict;        // CorrelationVerdict
+} CorrelationSummary_t;
+
+// Relates a current channel (x) to a vibration channel (y) from the same moment, even when the
+// two come from different sensor nodes with their own clocks.
+//
+// Timeline: every stream's sensor clock (the v2 batch timestamp, or its sample count for v1
+// nodes) is mapped onto the hub clock with the smallest hub - sensor offset seen over the last
+// 1-2 CORR_CLOCK_WINDOWs, i.e. the batch that waited least. That follows the slow drift of the
+// sensor crystal and ignores queueing jitter. Lost batches (v2 timestamp jumps) restart a stream's
+// contiguous history, windows never straddle them.
+//
+// Frames: every hopSize samples of common time both pipelines' rings are read back over the
+// same `points` samples. The later stream's newest samples are skipped to line up with the
+// earlier one; the constructor grows both rings to 2 x points for that slack. The two real
+// windows go through one complex FFT (x + jy) and are split afterwards. The remaining
+// sub-sample offset is removed as a phase ramp. The engine keeps Welch averages of |X|^2, |Y|^2 and X* Y, which give coherence and
+// phase per bin, plus an order spectrum of the vibration: bins mapped to multiples of the running
+// speed, tracked per frame around the nominal one from the 1x peak.
+//
+// Platform neutral. Reads the rings only, so it adds nothing to the channels' own FFT work.
+class CorrelationEngine {
+	public:
+		// points: power of two, at most the smaller fftSize. hopSize 0 = points / 2. Both
+		// pipelines must run at the same sample rate (check with compatible()). Grows both rings
+		// (reserveHistory), so neither pipeline may be running a batch meanwhile.
+		CorrelationEngine(DspPipeline& current, DspPipeline& vibration, int points, int hopSize = 0);
+		~CorrelationEngine();
+
+		CorrelationEngine(const CorrelationEngine&) = delete;
+		CorrelationEngine& operator=(const CorrelationEngine&) = delete;
+
+		static bool compatible(const DspPipeline& current, const DspPipeline& vibration, int points);
+
+		// After every pushBatch of either pipeline: the batch's metadata and the hub clock (us) now.
+		// Returns true when a new frame went into the averages.
+		bool onBatch(const DspPipeline& source, const BatchInfo_t& info, uint32_t nowUs);
+
+		// Nominal running speed, the order tracker searches +-10% around it
+		void setRunningHz(float hz) { _nominalHz = hz; _trackedHz = hz; }
+		void reset();
+
+		int bins() const { return _points / 2; }
+		float binHz() const { return _binHz; }
+		float coherence(int bin) const;				// 0..1
+		float phaseDeg(int bin) const;				// Vibration relative to current
+		float crossMagnitude(int bin) const;		// sqrt|Sxy|, same scale as DspPipeline::spectrum()
+		float orderMagnitude(int bin) const;		// bin / CORR_ORDER_RESOLUTION orders
+		const CorrelationSummary_t& summary() const { return _summary; }
+		uint32_t skipped() const { return _skipped; }		// Frames not taken: streams too far apart or a gap
+		uint32_t gaps() const { return _gaps; }
+		int32_t clockOffsetUs(int stream) const { return (int32_t)_streams[stream].offsetUs; }
+		size_t memoryBytes() const;
+
+	private:
+		// One input's sensor clock mapped onto the hub clock
+		struct Stream {
+			const DspPipeline*	pipeline;
+			uint32_t	sensorEndUs;		// Sensor clock at the newest ring sample
+			double		countUs;			// v1: sample-count clock
+			uint32_t	offsetUs;			// Hub - sensor, windowed minimum
+			uint32_t	bucketMin;
+			uint32_t	previousMin;
+			int			bucketCount;
+			bool		havePrevious;
+			bool		locked;				// Enough batches seen to trust offsetUs
+			bool		started;
+			int			contiguous;			// Newest ring samples without a gap
+			uint32_t	hubEndUs() const { return sensorEndUs + offsetUs; }
+		};
+
+		Stream		_streams[2];			// 0 = current (x), 1 = vibration (y)
+		int			_points;
+		int			_hopSize;
+		float		_samplingFrequency;
+		float		_binHz;
+		uint32_t	_hopUs;
+		uint32_t	_lastFrameUs = 0;
+		bool		_haveFrame = false;
+
+		float*		_window;
+		float*		_cos;					// W_2N^k, k < N, for RealFftDetail::complexFft
+		float*		_sin;
+		float*		_work;					// N complex values
+		float*		_orderFrame;			// CORR_ORDER_BINS, this frame's power per order bin
+
+		float*		_sxx;					// Averages, N / 2 each (MEM_BULK)
+		float*		_syy;
+		float*		_sxyRe;
+		float*		_sxyIm;
+		float*		_orders;
+
+		float		_nominalHz = 0;
+		float		_trackedHz = 0;
+		uint32_t	_skipped = 0;
+		uint32_t	_gaps = 0;
+		CorrelationSummary_t _summary;
+
+		void observe(Stream& s, const BatchInfo_t& info, uint32_t nowUs);
+		bool tryFrame();
+		void compute(int ageX, int ageY, float shift);
+		float trackSpeed(const float* power) const;
+		void summarise(int32_t skewUs);
+};
+
+#endif
\ No newline at end of file
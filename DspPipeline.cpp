@@ -0,0 +1,173 @@
+#include <math.h>
+#include <string.h>
+#include "DspPipeline.h"
+#include "ZoomFft.h"
+#include "MemoryArena.h"
+
+// Ring writes for either sample type: a straight copy (at most two runs when it wraps)...
+template<typename T>
+static void writeRing(T* ring, int size, int pos, const T* batch, int n){
+    int first = size - pos;
+    if (first > n) first = n;
+    memcpy(&ring[pos], batch, sizeof(T) * first);
+    if (first < n) memcpy(ring, batch + first, sizeof(T) * (n - first));
+}
+
+// ...or a per-sample conversion when the batch does not match the ring
+template<typename Out, typename In, typename Convert>
+static void writeRing(Out* ring, int size, int pos, const In* batch, int n, Convert convert){
+    for (int i = 0; i < n; i++) ring[(pos + i) & (size - 1)] = convert(batch[i]);
+}
+
+static inline int16_t quantize(float v, float scale, float offset){
+    long q = lrintf((v - offset) / scale);
+    if (q > 32767) q = 32767;
+    if (q < -32768) q = -32768;
+    return (int16_t)q;
+}
+
+DspPipeline::DspPipeline(int batchSamples, int aggregationFactor, float samplingFrequency, int hopSize, DspSampleFormat format) : _batchSamples(batchSamples), _aggregationFactor(aggregationFactor), _samplingFrequency(samplingFrequency), _format(format){
+
+	_fftSize = aggregationFactor * batchSamples;
+	_hopSize = (hopSize <= 0 || hopSize > _fftSize) ? _fftSize : hopSize;
+
+	allocateRing(_fftSize);
+	if (format == DSP_Q15) {
+		_fftQ15		= arenaCreate<RealFftQ15>(MEM_FAST, "fft", _fftSize);
+	} else {
+		_fft		= createRealFftPlan(_fftSize);	// Window + twiddles are built here, once
+		if (_fft == nullptr) _fft = createRealFftPlan(_fftSize, REAL_FFT_PORTABLE);	// Backend out of memory
+	}
+	_spectrum	= arenaNew<float>(_fftSize / 2, MEM_FAST, "spectrum");
+}
+
+DspPipeline::~DspPipeline(){
+	clearAnalyses();
+	arenaDelete(_timeData);
+	arenaDelete(_timeCodes);
+	arenaDelete(_spectrum);
+	arenaDestroy(_fft);
+	arenaDestroy(_fftQ15);
+}
+
+// (Re)allocates an empty ring; everything reading it starts over
+void DspPipeline::allocateRing(int size){
+    arenaDelete(_timeData);
+    arenaDelete(_timeCodes);
+    _timeData = nullptr;
+    _timeCodes = nullptr;
+    // Zeroed by arenaNew
+    if (_format == DSP_Q15) _timeCodes = arenaNew<int16_t>(size, MEM_FAST, "ring");
+    else _timeData = arenaNew<float>(size, MEM_FAST, "ring");
+    _ringSize = size;
+    _writePos = 0;
+    _filled = 0;
+    _sinceLast = 0;
+    for (int i = 0; i < _analysisCount; i++) _analyses[i]->reset();
+}
+
+void DspPipeline::restart(){
+    if (_format == DSP_Q15) memset(_timeCodes, 0, sizeof(int16_t) * _ringSize);
+    else memset(_timeData, 0, sizeof(float) * _ringSize);
+    memset(_spectrum, 0, sizeof(float) * (_fftSize / 2));
+    _writePos = 0;
+    _filled = 0;
+    _sinceLast = 0;
+    _haveScale = false;
+    for (int i = 0; i < _analysisCount; i++) _analyses[i]->reset();
+}
+
+size_t DspPipeline::memoryBytes() const {
+    size_t bytes = sizeof(float) * (_fftSize / 2);
+    for (int i = 0; i < _analysisCount; i++) bytes += _analyses[i]->memoryBytes();
+    if (_format == DSP_Q15) return bytes + sizeof(int16_t) * _ringSize + 6 * (size_t)_fftSize;
+    return bytes + sizeof(float) * _ringSize + 12 * (size_t)_fftSize;
+}
+
+static inline bool powerOfTwo(int n){ return n >= 4 && (n & (n - 1)) == 0; }
+
+int DspPipeline::addFftAnalysis(int points, int hopSize){
+    if (!powerOfTwo(points)) return -1;
+    return addAnalysis(arenaCreate<FftAnalysis>(MEM_FAST, "analysis", *this, points, hopSize));
+}
+
+int DspPipeline::addZoomAnalysis(float centerHz, int points, int decimation, int hopSize){
+    if (!powerOfTwo(points) || decimation < 2 || centerHz <= 0 || centerHz >= 0.5f * _samplingFrequency) return -1;
+    return addAnalysis(arenaCreate<ZoomFft>(MEM_FAST, "analysis", centerHz, points, decimation, _samplingFrequency, hopSize));
+}
+
+int DspPipeline::addAnalysis(SpectrumAnalysis* analysis){
+    if (analysis == nullptr) return -1;
+    if (_analysisCount >= DSP_MAX_ANALYSES) {
+        arenaDestroy(analysis);
+        return -1;
+    }
+    _analyses[_analysisCount] = analysis;
+
+    // The ring must hold the longest history anyone reads back
+    int size = _ringSize;
+    while (size < analysis->ringSamples(_batchSamples)) size <<= 1;
+    if (size != _ringSize) allocateRing(size);
+    return _analysisCount++;
+}
+
+void DspPipeline::reserveHistory(int samples){
+    int size = _ringSize;
+    while (size < samples) size <<= 1;
+    if (size != _ringSize) allocateRing(size);
+}
+
+void DspPipeline::clearAnalyses(){
+    for (int i = 0; i < _analysisCount; i++) arenaDestroy(_analyses[i]);
+    _analysisCount = 0;
+}
+
+bool DspPipeline::pushBatch(const float* batch){
+    // 1. Write the batch into the ring
+    if (_format == DSP_Q15) {
+        const float scale = _scale, offset = _offset;
+        writeRing(_timeCodes, _ringSize, _writePos, batch, _batchSamples, [=](float v){ return quantize(v, scale, offset); });
+    } else {
+        writeRing(_timeData, _ringSize, _writePos, batch, _batchSamples);
+    }
+    return advance();
+}
+
+bool DspPipeline::pushCodes(const int16_t* codes, float scale, float offset){
+    if (_format == DSP_Q15) {
+        if (!_haveScale) { _scale = scale; _offset = offset; _haveScale = true; }
+        if (scale == _scale && offset == _offset) {
+            writeRing(_timeCodes, _ringSize, _writePos, codes, _batchSamples);
+        } else {
+            const float toScale = _scale, toOffset = _offset;
+            writeRing(_timeCodes, _ringSize, _writePos, codes, _batchSamples, [=](int16_t q){ return quantize(offset + scale * q, toScale, toOffset); });
+        }
+    } else {
+        writeRing(_timeData, _ringSize, _writePos, codes, _batchSamples, [=](int16_t q){ return offset + scale * q; });
+    }
+    return advance();
+}
+
+bool DspPipeline::advance(){
+    _writePos = (_writePos + _batchSamples) & (_ringSize - 1);
+
+    if (_filled < _ringSize) _filled += _batchSamples;
+    _sinceLast += _batchSamples;
+
+    // 2. Extra analyses read the new samples from the ring on their own schedule
+    for (int i = 0; i < _analysisCount; i++) _analyses[i]->update(*this, _batchSamples);
+
+    // 3. Run FFT once the window is full and a hop worth of new samples arrived
+    if (_filled < _fftSize || _sinceLast < _hopSize) return false;
+
+    process();
+    _sinceLast = 0;
+    return true;
+}
+
+void DspPipeline::process(){
+    // DC removal, Hann window, real FFT and magnitude in one pass, read straight from the ring
+    const int start = recentStart(_fftSize);
+    if (_format == DSP_Q15) _fftQ15->magnitude(_timeCodes, _spectrum, start, _scale, _ringSize);
+    else _fft->magnitude(_timeData, _spectrum, start, _ringSize);
+}
@@ -0,0 +1,116 @@
+#ifndef DSP_PIPELINE_H
+#define DSP_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "RealFft.h"
+#include "RealFftQ15.h"
+#include "SpectrumAnalysis.h"
+
+#define DSP_MAX_ANALYSES 4
+
+// Sample type kept in the window ring and fed to the FFT
+enum DspSampleFormat {
+    DSP_FLOAT32 = 0,         // float ring + RealFftPlan
+    DSP_Q15 = 1              // int16 ADC codes + RealFftQ15 (half the memory), for integer encodings
+};
+
+// Platform-neutral signal chain used by ProcessingCore:
+// aggregation -> DC removal -> Hann window -> FFT -> magnitude.
+// No Arduino / FreeRTOS dependencies so it also builds on Linux (see bench/).
+//
+// Batches go into a ring buffer of fftSize samples. Once the first window is full a new
+// spectrum is computed every `hopSize` samples (checked per batch), e.g. 256 with a 1024
+// window = 75% overlap. hopSize 0 (or >= fftSize) keeps non-overlapping blocks.
+//
+// A DSP_Q15 pipeline keeps the raw codes plus one scale / offset and runs the fixed-point
+// FFT; spectrum() and timeSample() are in value units either way. Both push calls work on
+// both formats (converting per sample), the cheap path is the one matching the format.
+//
+// Up to DSP_MAX_ANALYSES extra analyses (other FFT sizes, zoom FFTs) can run over the same
+// input ring, which then grows to the longest history any of them needs. spectrum() and
+// friends always refer to the pipeline's own fftSize analysis.
+class DspPipeline {
+	public:
+		DspPipeline(int batchSamples = BATCH_SAMPLES, int aggregationFactor = 4, float samplingFrequency = 1000.0f, int hopSize = 0, DspSampleFormat format = DSP_FLOAT32);
+		~DspPipeline();
+
+		DspPipeline(const DspPipeline&) = delete;
+		DspPipeline& operator=(const DspPipeline&) = delete;
+
+		// Appends one batch. Returns true when a new spectrum is ready.
+		bool pushBatch(const float* batch);
+		// Same for raw codes, value = offset + code * scale. A Q15 pipeline adopts the first
+		// scale / offset and requantises batches that use a different one.
+		bool pushCodes(const int16_t* codes, float scale, float offset);
+
+		// Runs the FFT chain on the current window.
+		void process();
+		// Drops the input history (the stream restarts, e.g. a new sensor took the channel)
+		void restart();
+
+		// i = 0 is the oldest sample of the current window
+		float timeSample(int i) const { return ringSample((_writePos - _fftSize + i) & (_ringSize - 1)); }
+		const float* spectrum() const { return _spectrum; }
+		int fftSize() const { return _fftSize; }
+		int hopSize() const { return _hopSize; }
+		int bins() const { return _fftSize / 2; }
+		int batchSamples() const { return _batchSamples; }
+		float samplingFrequency() const { return _samplingFrequency; }
+		DspSampleFormat format() const { return _format; }
+		// Memory owned by this pipeline (ring, spectrum, FFT tables and work buffer, analyses)
+		size_t memoryBytes() const;
+
+		// --- Extra analyses over the shared ring ---
+		// Return the analysis index, or -1 if the table is full / the parameters are invalid.
+		// Growing the ring restarts it, so add analyses before data arrives where possible.
+		int addFftAnalysis(int points, int hopSize = 0);
+		int addZoomAnalysis(float centerHz, int points, int decimation, int hopSize = 0);
+		void clearAnalyses();
+		int analysisCount() const { return _analysisCount; }
+		const SpectrumAnalysis& analysis(int i) const { return *_analyses[i]; }
+
+		// --- Shared input ring, read by the analyses ---
+		int ringSize() const { return _ringSize; }
+		int filled() const { return _filled; }						// Valid samples, up to ringSize()
+		int recentStart(int count) const { return (_writePos - count) & (_ringSize - 1); }	// Oldest of the newest count
+		float recentSample(int age) const { return ringSample((_writePos - 1 - age) & (_ringSize - 1)); }	// age 0 = newest
+		const float* ringData() const { return _timeData; }			// DSP_FLOAT32
+		const int16_t* ringCodes() const { return _timeCodes; }		// DSP_Q15
+		float codeScale() const { return _scale; }
+		// Keeps at least `samples` of history for readers outside the pipeline (CorrelationEngine).
+		// Growing the ring restarts it, like adding an analysis.
+		void reserveHistory(int samples);
+
+	private:
+		int			_batchSamples;
+		int			_aggregationFactor;
+		int			_fftSize;
+		float		_samplingFrequency;
+		int			_hopSize;
+		int			_ringSize;			// Power of two >= _fftSize
+		int			_writePos = 0;		// Next ring slot to write
+		int			_filled = 0;		// Samples in the ring, up to _ringSize
+		int			_sinceLast = 0;		// Samples received since the last spectrum
+		DspSampleFormat _format;
+
+		float*		_timeData = nullptr;	// Ring buffer, _ringSize samples (DSP_FLOAT32)
+		int16_t*	_timeCodes = nullptr;	// Ring buffer of codes (DSP_Q15)
+		float		_scale = 1.0f;		// Code -> value of _timeCodes
+		float		_offset = 0.0f;
+		bool		_haveScale = false;
+		float*		_spectrum;
+		RealFftPlan* _fft = nullptr;
+		RealFftQ15*	_fftQ15 = nullptr;
+
+		SpectrumAnalysis* _analyses[DSP_MAX_ANALYSES];
+		int			_analysisCount = 0;
+
+		float ringSample(int k) const { return (_format == DSP_Q15) ? _offset + _scale * _timeCodes[k] : _timeData[k]; }
+		void allocateRing(int size);
+		int addAnalysis(SpectrumAnalysis* analysis);
+		bool advance();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "DspScheduler.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <thread>
+#endif
+
+DspScheduler::DspScheduler(BatchRing* rings, int laneCount, int workerCount)
+	: _rings(rings),
+	  _laneCount(laneCount > DSP_MAX_LANES ? DSP_MAX_LANES : laneCount),
+	  _workerCount(workerCount < 1 ? 1 : (workerCount > DSP_MAX_WORKERS ? DSP_MAX_WORKERS : workerCount)){
+	for (int lane = 0; lane < DSP_MAX_LANES; lane++) {
+		_home[lane] = (int8_t)(lane % _workerCount);
+		_owner[lane].store(-1, std::memory_order_relaxed);
+	}
+	for (int w = 0; w < DSP_MAX_WORKERS; w++) {
+		_stealBacklog[w] = 1;
+		_next[w] = 0;
+	}
+}
+
+bool DspScheduler::tryClaim(int worker, int lane){
+    int8_t free = -1;
+    if (!_owner[lane].compare_exchange_strong(free, (int8_t)worker, std::memory_order_acquire, std::memory_order_relaxed)) return false;
+    // pause() sets the flag before it checks the owners, so one of the two sides sees the other
+    if (_paused.load(std::memory_order_seq_cst)) {
+        _owner[lane].store(-1, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+int DspScheduler::claim(int worker){
+    if (_paused.load(std::memory_order_relaxed)) return -1;
+
+    // Home lanes first, round robin so one chatty sensor cannot starve the others
+    for (int i = 0; i < _laneCount; i++) {
+        const int lane = (_next[worker] + i) % _laneCount;
+        if (_home[lane] != worker || _rings[lane].empty()) continue;
+        if (tryClaim(worker, lane)) {
+            _next[worker] = (lane + 1) % _laneCount;
+            _claims[worker]++;
+            return lane;
+        }
+    }
+
+    // Nothing at home: help with the most backed-up lane of another worker
+    int best = -1;
+    size_t bestDepth = 0;
+    for (int lane = 0; lane < _laneCount; lane++) {
+        if (_home[lane] == worker || _owner[lane].load(std::memory_order_relaxed) != -1) continue;
+        const size_t depth = _rings[lane].size();
+        if (depth >= (size_t)_stealBacklog[worker] && depth > bestDepth) {
+            best = lane;
+            bestDepth = depth;
+        }
+    }
+    if (best >= 0 && tryClaim(worker, best)) {
+        _claims[worker]++;
+        _steals[worker]++;
+        return best;
+    }
+    return -1;
+}
+
+void DspScheduler::release(int lane){
+    _owner[lane].store(-1, std::memory_order_release);
+}
+
+uint32_t DspScheduler::wakeMask(int lane) const {
+    uint32_t mask = 1u << _home[lane];
+    const size_t depth = _rings[lane].size();
+    for (int w = 0; w < _workerCount; w++) {
+        if (depth >= (size_t)_stealBacklog[w]) mask |= 1u << w;
+    }
+    return mask;
+}
+
+void DspScheduler::pause(){
+    _paused.store(true, std::memory_order_seq_cst);
+    for (int lane = 0; lane < _laneCount; lane++) {
+        while (_owner[lane].load(std::memory_order_seq_cst) != -1) {
+#if defined(ARDUINO)
+            vTaskDelay(1);
+#else
+            std::this_thread::yield();
+#endif
+        }
+    }
+    _pauses++;
+}
+
+void DspScheduler::resume(){
+    _paused.store(false, std::memory_order_release);
+}
@@ -0,0 +1,79 @@
+#ifndef DSP_SCHEDULER_H
+#define DSP_SCHEDULER_H
+
+#include <atomic>
+#include <stdint.h>
+#include "BatchPool.h"
+
+// Limits of the bit masks / fixed tables below
+#define DSP_MAX_LANES 32
+#define DSP_MAX_WORKERS BATCH_POOL_CONSUMERS
+
+// Hands queued sensor batches to several DSP workers (one task per core on the ESP32,
+// std::thread in bench/SchedulerBenchmark).
+//
+// A lane is one sensor's BatchRing. A worker claims a whole lane, pops one batch, processes
+// it and releases the lane, so a sensor's batches are handled in order and its channels
+// (pipeline, detector, features) are only ever touched by one worker at a time; the claim
+// (acquire) and release (release) carry that state from one worker to the next.
+//
+// Each lane has a home worker that serves it first, round robin over its lanes. A worker with
+// nothing at home steals the most backed-up lane of another worker, if that lane holds at least
+// the thief's steal backlog (1 = anything queued, 2 = only when the home worker is falling
+// behind). Workers block on their own wakeup (task notification / condition variable); the
+// producer asks wakeMask() whom to wake after each push.
+//
+// pause() gives the caller every lane at once, for the changes that touch all channels
+// (learning, bands, analyses, pairing channels). Lock-free otherwise, platform neutral.
+class DspScheduler {
+	public:
+		DspScheduler(BatchRing* rings, int laneCount, int workerCount);
+
+		int laneCount() const { return _laneCount; }
+		int workerCount() const { return _workerCount; }
+
+		// Lane -> worker that serves it first (default lane % workers)
+		void setHome(int lane, int worker) { _home[lane] = (int8_t)worker; }
+		int home(int lane) const { return _home[lane]; }
+		// Queued batches a lane needs before this worker steals it (default 1)
+		void setStealBacklog(int worker, int backlog) { _stealBacklog[worker] = backlog; }
+
+		// --- Worker side ---
+		// Claims a lane with a queued batch for `worker`, -1 if there is none (or paused).
+		// The caller pops from rings[lane] and hands the lane back with release().
+		int claim(int worker);
+		void release(int lane);
+
+		// --- Producer side ---
+		// Workers to wake after a push on `lane` (bit per worker): its home worker, and the
+		// workers that would steal it at its current backlog
+		uint32_t wakeMask(int lane) const;
+
+		// --- Exclusive access ---
+		// Stops new claims and waits until every lane is released. Not from a worker holding a lane.
+		void pause();
+		void resume();
+
+		// --- Counters (per worker, written by that worker) ---
+		uint32_t claims(int worker) const { return _claims[worker]; }
+		uint32_t steals(int worker) const { return _steals[worker]; }
+		uint32_t pauses() const { return _pauses; }
+
+	private:
+		BatchRing*	_rings;
+		int			_laneCount;
+		int			_workerCount;
+		int8_t		_home[DSP_MAX_LANES];
+		int			_stealBacklog[DSP_MAX_WORKERS];
+		int			_next[DSP_MAX_WORKERS];			// Round-robin cursor over the lanes, per worker
+		std::atomic<int8_t> _owner[DSP_MAX_LANES];	// Worker holding the lane, -1 = free
+		std::atomic<bool> _paused{false};
+
+		uint32_t	_claims[DSP_MAX_WORKERS] = {};
+		uint32_t	_steals[DSP_MAX_WORKERS] = {};
+		uint32_t	_pauses = 0;
+
+		bool tryClaim(int worker, int lane);
+};
+
+#endif
\ No newline at end of file
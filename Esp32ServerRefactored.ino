@@ -1,41 +1,101 @@
-#include <WiFi.h>
-#include <AsyncTCP.h>
-#include <ESPAsyncWebServer.h>
-#include <arduinoFFT.h>
-#include "esp_task_wdt.h" 
-
-#include "Protocol.h"
-#include "CommunicationHub.h"
-#include "ProcessingCore.h"
-#include "WebCode.h"
-
-#define AGGREGATION_FACTOR 4  
-
-const int TCP_PORT = 8888;
-const int MAX_SENSORS = 2;
-
-const int EVENT_PORT = 80;
-const char* EVENT_PATH = "/events";
-
-CommunicationHub SensHub;		//internal initialization (2 max @ 8888)
-ProcessingCore SignalProcessor; //4 * 256 samples to "/events" @ 80
-
-QueueHandle_t vibQueue; 
-QueueHandle_t curQueue; 
-
-
-void setup() {
-    Serial.begin(115200);
-
-    vibQueue = xQueueCreate(AGGREGATION_FACTOR, sizeof(InternalMessage_t));
-    curQueue = xQueueCreate(AGGREGATION_FACTOR, sizeof(InternalMessage_t));
-
-	SensHub.begin(vibQueue, curQueue);			// Begin Task 01 (Connection)
-    SignalProcessor.begin(vibQueue, curQueue);	// Begin Task 02 (Processing)
-
-}
-
-void loop() { 
-    vTaskDelete(NULL);	// The loop is empty because we use FreeRTOS tasks.
-}
-
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include "esp_task_wdt.h" 
+
+#include "Protocol.h"
+#include "BatchPool.h"
+#include "CommunicationHub.h"
+#include "ProcessingCore.h"
+#include "PartitionFlashStore.h"
+#include "CaptureLog.h"
+#include "MemoryArena.h"
+#include "MemoryPlan.h"
+#include "GatewayLink.h"
+#include "WebCode.h"
+
+#define AGGREGATION_FACTOR 4  
+#define POOL_SLOTS (MAX_SENSORS * (BATCH_RING_DEPTH + 1) + DSP_WORKERS)	// Queued batches + one being received per sensor, + one being processed per DSP worker
+
+const int TCP_PORT = 8888;
+const int MAX_SENSORS = 8;
+
+const int EVENT_PORT = 80;
+const char* EVENT_PATH = "/events";
+
+CommunicationHub SensHub(TCP_PORT, MAX_SENSORS);	//8 max @ 8888
+ProcessingCore SignalProcessor(EVENT_PORT, EVENT_PATH, BATCH_SAMPLES, AGGREGATION_FACTOR, 256, MAX_SENSORS); //4 * 256 samples, new spectrum every 256 (75% overlap) to "/events" @ 80
+
+BatchPool* BatchSlots;				// Sample batches, filled by the hub straight from the socket (created in the arena)
+BatchRing SensorRings[MAX_SENSORS];	// Lock-free hub -> DSP handoff, one per sensor
+
+PartitionFlashStore CaptureFlash("spiffs");	// Unused SPIFFS partition of the default scheme
+CaptureLog Capture(&CaptureFlash);			// Raw batches + spectra around each alarm, GET /capture
+
+// --- Gateway uplink (optional): the hub also joins the plant WiFi and forwards to tools/Gateway ---
+const char* GATEWAY_HOST = "";				// Gateway address, empty = no uplink
+const uint16_t GATEWAY_PORT = UPLINK_DEFAULT_PORT;
+const uint16_t HUB_ID = 1;					// Unique per hub on the line
+const char* HUB_NAME = "hub-1";
+const char* PLANT_SSID = "";
+const char* PLANT_PASSWORD = "";
+const bool FORWARD_RAW = false;				// Raw batches instead of features / spectra (the gateway runs the DSP)
+GatewayLink Uplink(GATEWAY_HOST, GATEWAY_PORT, HUB_ID, HUB_NAME);
+
+// --- Memory: every DSP / network buffer is carved at startup from two regions sized here ---
+// Channels budgeted up front, at the worst case (float samples, current channel with the line zoom).
+// Channels beyond these still run, their buffers come from the heap (see the arena report).
+#define ARENA_CHANNELS 2
+#define FFT_SIZE (AGGREGATION_FACTOR * BATCH_SAMPLES)
+#define CAPTURE_SECTORS 352		// 'spiffs' partition of the default scheme (1.375 MB)
+#define ARENA_FAST_BYTES (MemoryPlan::pool(POOL_SLOTS) + CommunicationHub::arenaBytes(MAX_SENSORS) + ProcessingCore::arenaFastBytes(MAX_SENSORS) \
+                          + ARENA_CHANNELS * MemoryPlan::channelFast(FFT_SIZE, DSP_FLOAT32, LINE_ZOOM_POINTS, LINE_ZOOM_DECIMATION) \
+                          + MemoryPlan::correlationFast(FFT_SIZE, DSP_FLOAT32))
+#define ARENA_BULK_BYTES (ProcessingCore::arenaBulkBytes(FFT_SIZE) + ARENA_CHANNELS * MemoryPlan::channelBulk(FFT_SIZE) + MemoryPlan::correlationBulk(FFT_SIZE) \
+                          + MemoryPlan::capture(CAPTURE_SECTORS, 256) + GatewayLink::arenaBytes(FFT_SIZE))
+
+alignas(ARENA_ALIGN) static uint8_t FastArena[ARENA_FAST_BYTES];	// .bss = internal DRAM, the linker checks it fits
+MemoryArena Arena;
+
+
+void setup() {
+    Serial.begin(115200);
+
+    // Bulk region in PSRAM if the board has one, else one internal block before anything fragments the heap
+    const size_t bulkBytes = ARENA_BULK_BYTES + ARENA_ALIGN;	// Slack for aligning the base
+    void* bulk = psramFound() ? ps_malloc(bulkBytes) : nullptr;
+    const bool bulkInPsram = (bulk != nullptr);
+    if (bulk == nullptr) bulk = heap_caps_malloc(bulkBytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    Arena.begin(MEM_FAST, FastArena, sizeof(FastArena));
+    Arena.begin(MEM_BULK, bulk, (bulk != nullptr) ? bulkBytes : 0);
+    ArenaScope scope(&Arena);		// Everything allocated below, including the task stacks
+    SignalProcessor.setArena(&Arena);	// Channels are added later by the processing task
+
+    BatchSlots = arenaCreate<BatchPool>(MEM_FAST, "pool", POOL_SLOTS);
+
+    if (Capture.begin()) SignalProcessor.setCapture(&Capture);
+    else Serial.println("Capture log disabled: no 'spiffs' partition");
+
+    if (GATEWAY_HOST[0] != '\0') {
+        WiFi.begin(PLANT_SSID, PLANT_PASSWORD);		// Station next to the sensors' access point (AP follows its channel)
+        Uplink.begin(MAX_SENSORS, FFT_SIZE);
+        Uplink.setForwardRaw(FORWARD_RAW);
+        SignalProcessor.setUplink(&Uplink);
+    }
+
+    SignalProcessor.begin(SensorRings, MAX_SENSORS, BatchSlots);					// Begin Task 02 (Processing, DSP_WORKERS tasks)
+	SensHub.begin(SensorRings, BatchSlots, SignalProcessor.scheduler(), SignalProcessor.workerTasks());	// Begin Task 01 (Connection)
+    SignalProcessor.setHub(&SensHub);												// Hub counters in /metrics
+
+    // Startup footprint
+    char report[768];
+    Arena.report(report, sizeof(report));
+    Serial.print(report);
+    Serial.printf("Bulk region in %s, %u channels budgeted, free heap %u bytes (largest block %u)\n", bulkInPsram ? "PSRAM" : "internal RAM",
+                  ARENA_CHANNELS, ESP.getFreeHeap(), ESP.getMaxAllocHeap());
+}
+
+void loop() { 
+    vTaskDelete(NULL);	// The loop is empty because we use FreeRTOS tasks.
+}
+
@@ -0,0 +1,99 @@
+#include <math.h>
+#include <string.h>
+#include "FeatureExtractor.h"
+#include "MemoryArena.h"
+
+static const uint8_t FEATURE_NO_BAND = 0xFF;
+
+FeatureExtractor::FeatureExtractor(int bins, float binHz, int skipBins) : _bins(bins), _binHz(binHz), _skipBins(skipBins){
+	_bandOfBin = arenaNew<uint8_t>(_bins, MEM_FAST, "features");
+	memset(_bandOfBin, FEATURE_NO_BAND, _bins);
+}
+
+FeatureExtractor::~FeatureExtractor(){
+	arenaDelete(_bandOfBin);
+}
+
+void FeatureExtractor::setBands(const FeatureBand_t* bands, int count){
+    if (count > FEATURE_MAX_BANDS) count = FEATURE_MAX_BANDS;
+    _bandCount = count;
+    memcpy(_bands, bands, sizeof(FeatureBand_t) * count);
+
+    // Resolve the bands to bins once, so extract() needs a single lookup per bin
+    memset(_bandOfBin, FEATURE_NO_BAND, _bins);
+    for (int i = 0; i < _bins; i++) {
+        float hz = i * _binHz;
+        for (int b = 0; b < count; b++) {
+            if (hz >= bands[b].lowHz && hz < bands[b].highHz) {
+                _bandOfBin[i] = (uint8_t)b;
+                break;
+            }
+        }
+    }
+}
+
+void FeatureExtractor::setHarmonicBands(float runningHz, int harmonics, float halfWidth){
+    FeatureBand_t bands[FEATURE_MAX_BANDS];
+    if (harmonics > FEATURE_MAX_BANDS) harmonics = FEATURE_MAX_BANDS;
+    for (int h = 0; h < harmonics; h++) {
+        float center = (h + 1) * runningHz;
+        float width = fmaxf(halfWidth * center, _binHz);
+        bands[h].lowHz = center - width;
+        bands[h].highHz = center + width;
+    }
+    setBands(bands, harmonics);
+}
+
+void FeatureExtractor::extract(const DspPipeline& pipeline, FeatureVector_t* out){
+    // --- Time domain: mean, RMS, peak, crest factor, kurtosis in one pass ---
+    const int n = pipeline.fftSize();
+    const float shift = _haveShift ? _shift : pipeline.timeSample(0);
+    float s1 = 0, s2 = 0, s3 = 0, s4 = 0;
+    float lo = pipeline.timeSample(0), hi = lo;
+    for (int i = 0; i < n; i++) {
+        float x = pipeline.timeSample(i);
+        float d = x - shift;
+        float d2 = d * d;
+        s1 += d; s2 += d2; s3 += d2 * d; s4 += d2 * d2;
+        if (x < lo) lo = x;
+        if (x > hi) hi = x;
+    }
+    const float inv = 1.0f / n;
+    const float m = s1 * inv;                      // Mean relative to the shift
+    const float m2 = fmaxf(s2 * inv - m * m, 0.0f);
+    const float m4 = s4 * inv - 4.0f * m * s3 * inv + 6.0f * m * m * s2 * inv - 3.0f * m * m * m * m;
+    const float mean = shift + m;
+    _shift = mean;
+    _haveShift = true;
+
+    out->rms = sqrtf(m2);
+    out->peak = fmaxf(hi - mean, mean - lo);
+    out->crestFactor = (out->rms > 0) ? out->peak / out->rms : 0;
+    out->kurtosis = (m2 > 0) ? fmaxf(m4, 0.0f) / (m2 * m2) : 0;
+
+    // --- Spectrum: peak bin and band energies in one pass ---
+    const float* fft = pipeline.spectrum();
+    const int bins = (pipeline.bins() < _bins) ? pipeline.bins() : _bins;
+    float energy[FEATURE_MAX_BANDS] = { 0 };
+    int best = -1;
+    float bestMag = 0;
+    for (int i = _skipBins; i < bins; i++) {
+        float mag = fft[i];
+        if (mag > bestMag) { bestMag = mag; best = i; }
+        uint8_t b = _bandOfBin[i];
+        if (b != FEATURE_NO_BAND) energy[b] += mag * mag;
+    }
+
+    // Parabolic interpolation between the neighbouring bins
+    float peakBin = (float)best;
+    if (best > _skipBins && best < bins - 1) {
+        float a = fft[best - 1], c = fft[best + 1];
+        float denom = a - 2.0f * bestMag + c;
+        if (denom < 0) peakBin += 0.5f * (a - c) / denom;
+    }
+    out->peakHz = (best >= 0) ? peakBin * _binHz : 0;
+    out->peakMagnitude = bestMag;
+
+    out->bandCount = (uint8_t)_bandCount;
+    memcpy(out->bandEnergy, energy, sizeof(energy));
+}
@@ -0,0 +1,62 @@
+#ifndef FEATURE_EXTRACTOR_H
+#define FEATURE_EXTRACTOR_H
+
+#include <stdint.h>
+#include "DspPipeline.h"
+
+#define FEATURE_MAX_BANDS 8
+
+// Frequency band for the band-energy features, [lowHz, highHz)
+typedef struct {
+    float lowHz;
+    float highHz;
+} FeatureBand_t;
+
+// Condition-monitoring summary of one frame, a few dozen bytes instead of the whole spectrum
+typedef struct {
+    float   rms;            // AC RMS of the time window
+    float   peak;           // Largest deviation from the mean
+    float   crestFactor;    // peak / rms
+    float   kurtosis;       // 3 for Gaussian noise, higher for impacts
+    float   peakHz;         // Strongest bin (interpolated), DC bins skipped
+    float   peakMagnitude;
+    uint8_t bandCount;
+    float   bandEnergy[FEATURE_MAX_BANDS];  // Sum of squared magnitudes per band
+} FeatureVector_t;
+
+// Runs after the FFT on every spectrum:
+// one pass over the time window (moments about the previous frame's mean, so a large DC
+// offset costs no precision) and one pass over the spectrum (peak bin + band energies
+// through a precomputed bin -> band map).
+class FeatureExtractor {
+	public:
+		FeatureExtractor(int bins, float binHz, int skipBins = 2);
+		~FeatureExtractor();
+
+		FeatureExtractor(const FeatureExtractor&) = delete;
+		FeatureExtractor& operator=(const FeatureExtractor&) = delete;
+
+		// Bands must not overlap (a bin belongs to the first band that contains it)
+		void setBands(const FeatureBand_t* bands, int count);
+		// 1x, 2x, ... running speed, band n at n * runningHz +/- halfWidth * n * runningHz (at least
+		// one bin): a speed change moves the nth harmonic n times as far. Up to FEATURE_MAX_BANDS of
+		// them never overlap for halfWidth < 1 / (2 * FEATURE_MAX_BANDS - 1).
+		void setHarmonicBands(float runningHz, int harmonics, float halfWidth = 0.05f);
+
+		void extract(const DspPipeline& pipeline, FeatureVector_t* out);
+
+		int bandCount() const { return _bandCount; }
+		const FeatureBand_t& band(int i) const { return _bands[i]; }
+
+	private:
+		int				_bins;
+		float			_binHz;
+		int				_skipBins;
+		FeatureBand_t	_bands[FEATURE_MAX_BANDS];
+		int				_bandCount = 0;
+		uint8_t*		_bandOfBin;			// FEATURE_NO_BAND or band index
+		float			_shift = 0;			// Previous frame's mean
+		bool			_haveShift = false;
+};
+
+#endif
\ No newline at end of file
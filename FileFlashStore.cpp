@@ -0,0 +1,60 @@
+#if !defined(ARDUINO)
+
+#include <string.h>
+#include "FileFlashStore.h"
+
+FileFlashStore::~FileFlashStore(){
+	if (_file) fclose(_file);
+}
+
+bool FileFlashStore::begin(){
+    // Reuse an existing image (reboot), otherwise start from erased flash
+    _file = fopen(_path, "r+b");
+    if (_file == nullptr) {
+        _file = fopen(_path, "w+b");
+        if (_file == nullptr) return false;
+    }
+    fseek(_file, 0, SEEK_END);
+    long have = ftell(_file);
+    if (have < (long)_size) {
+        uint8_t erased[256];
+        memset(erased, 0xFF, sizeof(erased));
+        for (long left = (long)_size - have; left > 0; left -= sizeof(erased)) {
+            fwrite(erased, 1, (left < (long)sizeof(erased)) ? left : sizeof(erased), _file);
+        }
+    }
+    return fflush(_file) == 0;
+}
+
+bool FileFlashStore::erase(uint32_t offset, uint32_t len){
+    if (!inRange(offset, len) || offset % sectorSize() || len % sectorSize()) return false;
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    fseek(_file, offset, SEEK_SET);
+    for (uint32_t done = 0; done < len; done += sizeof(erased)) fwrite(erased, 1, sizeof(erased), _file);
+    return fflush(_file) == 0;
+}
+
+bool FileFlashStore::write(uint32_t offset, const void* src, uint32_t len){
+    if (!inRange(offset, len)) return false;
+    const uint8_t* in = (const uint8_t*)src;
+    uint8_t chunk[256];
+    for (uint32_t done = 0; done < len; ) {
+        uint32_t n = (len - done < sizeof(chunk)) ? len - done : sizeof(chunk);
+        // NOR flash can only clear bits
+        if (!read(offset + done, chunk, n)) return false;
+        for (uint32_t i = 0; i < n; i++) chunk[i] &= in[done + i];
+        fseek(_file, offset + done, SEEK_SET);
+        if (fwrite(chunk, 1, n, _file) != n) return false;
+        done += n;
+    }
+    return fflush(_file) == 0;
+}
+
+bool FileFlashStore::read(uint32_t offset, void* dst, uint32_t len){
+    if (!inRange(offset, len)) return false;
+    fseek(_file, offset, SEEK_SET);
+    return fread(dst, 1, len, _file) == len;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef FILE_FLASH_STORE_H
+#define FILE_FLASH_STORE_H
+
+#if !defined(ARDUINO)
+
+#include <stdio.h>
+#include "FlashStore.h"
+
+// FlashStore over an image file on Linux, so CaptureLog runs off-target (tools/).
+// Keeps flash semantics: a new image is all 0xFF and writes AND into what is there.
+class FileFlashStore : public FlashStore {
+	public:
+		FileFlashStore(const char* path, uint32_t size) : _path(path), _size(size) {}
+		~FileFlashStore();
+
+		bool begin() override;
+		uint32_t size() const override { return _size; }
+
+		bool erase(uint32_t offset, uint32_t len) override;
+		bool write(uint32_t offset, const void* src, uint32_t len) override;
+		bool read(uint32_t offset, void* dst, uint32_t len) override;
+
+	private:
+		const char*	_path;
+		uint32_t	_size;
+		FILE*		_file = nullptr;
+
+		bool inRange(uint32_t offset, uint32_t len) const { return _file && offset <= _size && len <= _size - offset; }
+};
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef FLASH_STORE_H
+#define FLASH_STORE_H
+
+#include <stdint.h>
+
+// Raw NOR-flash style storage used by CaptureLog.
+// Same rules as the ESP32 SPI flash: erase works on whole sectors (bytes become 0xFF),
+// writes can only clear bits, so the log only ever appends page-aligned pages to erased space.
+//   ESP32: PartitionFlashStore (a data partition)
+//   Linux: FileFlashStore (an image file, for off-target runs)
+class FlashStore {
+	public:
+		virtual ~FlashStore() {}
+
+		virtual bool begin() = 0;
+		virtual uint32_t size() const = 0;
+		virtual uint32_t sectorSize() const { return 4096; }
+		virtual uint32_t pageSize() const { return 256; }
+
+		// offset / len are sector aligned
+		virtual bool erase(uint32_t offset, uint32_t len) = 0;
+		virtual bool write(uint32_t offset, const void* src, uint32_t len) = 0;
+		virtual bool read(uint32_t offset, void* dst, uint32_t len) = 0;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#if defined(ARDUINO)
+
+#include "GatewayLink.h"
+
+GatewayLink::GatewayLink(const char* host, uint16_t port, uint16_t hubId, const char* name) : _host(host), _port(port), _name(name), _encoder(hubId){
+	_client.setNoDelay(true);
+	_client.onConnect([this](void*, AsyncClient*){
+		_connects++;
+		_helloDue = true;
+		_connecting = false;
+		_connected = true;
+	});
+	_client.onDisconnect([this](void*, AsyncClient*){
+		_connected = false;
+		_connecting = false;
+	});
+	_client.onError([this](void*, AsyncClient*, err_t){
+		_connecting = false;
+	});
+}
+
+void GatewayLink::begin(int maxSensors, int fftSize){
+	_maxSensors = maxSensors;
+	_fftSize = fftSize;
+	_frameCapacity = UplinkEncoder::maxFrameBytes(fftSize);
+	_frame = arenaNew<uint8_t>(_frameCapacity, MEM_BULK, "uplink");
+}
+
+void GatewayLink::service(uint32_t nowMs){
+    if (_frame == nullptr) return;
+    if (!_connected) {
+        if (_connecting || (_attempted && nowMs - _lastAttemptMs < GATEWAY_RETRY_MS)) return;
+        _attempted = true;
+        _lastAttemptMs = nowMs;
+        _encoder.restart();
+        _connecting = _client.connect(_host, _port);
+        return;
+    }
+    if (_helloDue) {
+        size_t len = _encoder.hello(_frame, _frameCapacity, _name, _maxSensors, _fftSize, nowMs);
+        _helloDue = false;
+        if (!queue(UPLINK_HELLO, len)) _client.close();		// Could not even say hello: start over
+    }
+}
+
+// Whole frame onto the socket, or dropped (frames are only built while connected and greeted)
+bool GatewayLink::queue(UplinkKind kind, size_t len){
+    if (len == 0) return false;
+    if (_client.space() < len) {
+        _dropped++;
+        return false;
+    }
+    if (_client.add((const char*)_frame, len) != len) {
+        _dropped++;
+        return false;
+    }
+    _client.send();
+    _frames[kind]++;
+    _bytes += len;
+    return true;
+}
+
+void GatewayLink::sendFeatures(const ProcessingChannel& channel){
+    if (!ready() || _forwardRaw) return;
+    queue(UPLINK_FEATURES, _encoder.features(_frame, _frameCapacity, channel, millis()));
+}
+
+void GatewayLink::sendSpectrum(const ProcessingChannel& channel){
+    if (!ready() || _forwardRaw) return;
+    queue(UPLINK_SPECTRUM, _encoder.spectrum(_frame, _frameCapacity, channel, millis()));
+}
+
+void GatewayLink::sendAlarm(const ProcessingChannel& channel, const AlarmEvent_t& alarm){
+    if (!ready()) return;
+    queue(UPLINK_ALARM, _encoder.alarm(_frame, _frameCapacity, channel, alarm, millis()));
+}
+
+void GatewayLink::sendRaw(const InternalMessage_t& batch){
+    if (!ready() || !_forwardRaw) return;
+    queue(UPLINK_RAW, _encoder.raw(_frame, _frameCapacity, batch, millis()));
+}
+
+#endif
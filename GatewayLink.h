@@ -0,0 +1,82 @@
+#ifndef GATEWAY_LINK_H
+#define GATEWAY_LINK_H
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include "Protocol.h"
+#include "ProcessingChannel.h"
+#include "UplinkCodec.h"
+#include "MemoryArena.h"
+
+// Time between connection attempts while the gateway is unreachable
+#define GATEWAY_RETRY_MS 5000
+
+// Hub side of the uplink to the Linux gateway (tools/Gateway): one TCP connection, fed by the
+// processing task. Each frame is encoded into one buffer and queued on the socket whole or not
+// at all. When the send window is full the frame is dropped and counted, so a slow or absent
+// gateway never stalls the DSP; the gateway sees the gap in the frame sequence.
+//
+// Default: features for every spectrum, the spectrum at the dashboard's throttle, alarms.
+// setForwardRaw(true): every batch as it arrived instead of features / spectra (alarms still go),
+// for gateways that run the DSP themselves.
+class GatewayLink {
+	public:
+		GatewayLink(const char* host, uint16_t port, uint16_t hubId, const char* name);
+		// Frame buffer from the caller's ArenaScope (budget: arenaBytes)
+		void begin(int maxSensors, int fftSize);
+
+		static constexpr size_t arenaBytes(int fftSize){
+			return arenaRound(UplinkEncoder::maxFrameBytes(fftSize));
+		}
+
+		void setForwardRaw(bool raw) { _forwardRaw = raw; }
+		bool forwardRaw() const { return _forwardRaw; }
+
+		// --- Processing task only ---
+		// (Re)connects every GATEWAY_RETRY_MS and sends the HELLO of a new connection
+		void service(uint32_t nowMs);
+		void sendFeatures(const ProcessingChannel& channel);
+		void sendSpectrum(const ProcessingChannel& channel);
+		void sendAlarm(const ProcessingChannel& channel, const AlarmEvent_t& alarm);
+		void sendRaw(const InternalMessage_t& batch);
+
+		// --- Metrics ---
+		bool connected() const { return _connected; }
+		uint32_t frames(UplinkKind kind) const { return _frames[kind]; }
+		uint32_t dropped() const { return _dropped; }		// Send window full
+		uint32_t bytesSent() const { return _bytes; }
+		uint32_t connects() const { return _connects; }
+
+	private:
+		const char*	_host;
+		uint16_t	_port;
+		const char*	_name;
+		UplinkEncoder _encoder;
+		AsyncClient	_client;
+		uint8_t*	_frame = nullptr;
+		size_t		_frameCapacity = 0;
+		int			_maxSensors = 0;
+		int			_fftSize = 0;
+		bool		_forwardRaw = false;
+
+		// Set by the AsyncTCP task's callbacks
+		volatile bool _connected = false;
+		volatile bool _connecting = false;
+		volatile bool _helloDue = false;
+		uint32_t	_lastAttemptMs = 0;
+		bool		_attempted = false;
+
+		uint32_t	_frames[UPLINK_KIND_COUNT] = {};
+		uint32_t	_dropped = 0;
+		uint32_t	_bytes = 0;
+		uint32_t	_connects = 0;
+
+		bool ready() const { return _frame != nullptr && _connected && !_helloDue; }
+		bool queue(UplinkKind kind, size_t len);
+};
+
+#endif
+
+#endif
\ No newline at end of file
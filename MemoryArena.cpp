@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(ARDUINO)
+#include <malloc.h>
+#endif
+#include "MemoryArena.h"
+
+static thread_local MemoryArena* s_active = nullptr;
+static MemoryArena* s_installed = nullptr;
+
+MemoryArena* MemoryArena::active(){ return s_active; }
+MemoryArena* MemoryArena::installed(){ return s_installed; }
+
+void MemoryArena::begin(MemRegion region, void* base, size_t bytes){
+    uintptr_t start = (uintptr_t)base;
+    uintptr_t aligned = (start + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    size_t lost = (size_t)(aligned - start);
+    _base[region] = (base != nullptr && bytes > lost) ? (uint8_t*)aligned : nullptr;
+    _size[region] = (_base[region] != nullptr) ? bytes - lost : 0;
+    _used[region] = 0;
+    s_installed = this;
+}
+
+void* MemoryArena::take(MemRegion region, size_t bytes){
+    if (_size[region] - _used[region] < bytes) return nullptr;
+    void* p = _base[region] + _used[region];
+    _used[region] += bytes;
+    return p;
+}
+
+void* MemoryArena::allocate(size_t bytes, MemRegion region, const char* tag){
+    bytes = arenaRound(bytes);
+    // Cold data may take fast memory, never the other way round
+    MemRegion landed = region;
+    void* p = take(region, bytes);
+    if (p == nullptr && region == MEM_BULK) {
+        landed = MEM_FAST;
+        p = take(MEM_FAST, bytes);
+    }
+    if (p != nullptr) account(tag, landed, bytes);
+    return p;
+}
+
+bool MemoryArena::owns(const void* p) const {
+    for (int r = 0; r < MEM_REGION_COUNT; r++) {
+        if (_base[r] != nullptr && (const uint8_t*)p >= _base[r] && (const uint8_t*)p < _base[r] + _size[r]) return true;
+    }
+    return false;
+}
+
+void MemoryArena::noteFallback(size_t bytes, const char* tag){
+    _fallbackBytes += bytes;
+    account(tag, MEM_REGION_COUNT, bytes);
+}
+
+void MemoryArena::account(const char* tag, int column, size_t bytes){
+    if (tag == nullptr) tag = "other";
+    int i = 0;
+    while (i < _tagCount && strcmp(_tags[i].tag, tag) != 0) i++;
+    if (i == _tagCount) {
+        if (_tagCount == ARENA_MAX_TAGS) i = ARENA_MAX_TAGS - 1;	// Table full: lumped into the last tag
+        else _tags[_tagCount++].tag = tag;
+    }
+    _tags[i].bytes[column] += bytes;
+}
+
+size_t MemoryArena::report(char* out, size_t outSize) const {
+    size_t len = 0;
+    // snprintf returns what it wanted to write; stop appending once the buffer is full
+    auto append = [&](int n){ if (n > 0) len = (len + (size_t)n < outSize) ? len + (size_t)n : (outSize > 0 ? outSize - 1 : 0); };
+
+    for (int r = 0; r < MEM_REGION_COUNT; r++) {
+        append(snprintf(out + len, outSize - len, "%s%s %u / %u bytes", (r == 0) ? "Arena: " : ", ", memRegionName((MemRegion)r), (unsigned)_used[r], (unsigned)_size[r]));
+    }
+    append(snprintf(out + len, outSize - len, ", heap fallback %u bytes\n", (unsigned)_fallbackBytes));
+    for (int i = 0; i < _tagCount; i++) {
+        append(snprintf(out + len, outSize - len, "  %-10s fast %7u  bulk %7u  heap %7u\n", _tags[i].tag,
+                        (unsigned)_tags[i].bytes[MEM_FAST], (unsigned)_tags[i].bytes[MEM_BULK], (unsigned)_tags[i].bytes[MEM_REGION_COUNT]));
+    }
+    return len;
+}
+
+ArenaScope::ArenaScope(MemoryArena* arena) : _previous(s_active){
+	s_active = arena;
+}
+
+ArenaScope::~ArenaScope(){
+	s_active = _previous;
+}
+
+static void* heapAllocate(size_t bytes){
+#if defined(ARDUINO)
+    return memalign(ARENA_ALIGN, bytes);
+#else
+    void* p = nullptr;
+    return (posix_memalign(&p, ARENA_ALIGN, bytes) == 0) ? p : nullptr;
+#endif
+}
+
+void* arenaAllocate(size_t bytes, MemRegion region, const char* tag){
+    if (bytes == 0) bytes = 1;
+    MemoryArena* arena = s_active;
+    if (arena != nullptr) {
+        void* p = arena->allocate(bytes, region, tag);
+        if (p != nullptr) return p;
+        arena->noteFallback(arenaRound(bytes), tag);
+    }
+    return heapAllocate(bytes);
+}
+
+void arenaFree(void* p){
+    if (p == nullptr) return;
+    // The task's own arena first: a host process can run several (tools/LoadGen --hubs)
+    if (s_active != nullptr && s_active->owns(p)) s_active->release(p);
+    else if (s_installed != nullptr && s_installed->owns(p)) s_installed->release(p);
+    else free(p);
+}
+
+#if defined(ARDUINO)
+TaskHandle_t arenaTask(TaskFunction_t function, const char* name, uint32_t stackBytes, void* param, UBaseType_t priority, BaseType_t core){
+    MemoryArena* arena = s_active;
+    if (arena != nullptr) {
+        // Straight from MEM_FAST: a stack must not spill to the heap or PSRAM
+        StackType_t* stack = (StackType_t*)arena->allocate(stackBytes, MEM_FAST, "stack");
+        StaticTask_t* tcb = (stack != nullptr) ? (StaticTask_t*)arena->allocate(sizeof(StaticTask_t), MEM_FAST, "stack") : nullptr;
+        if (tcb != nullptr) return xTaskCreateStaticPinnedToCore(function, name, stackBytes, param, priority, stack, tcb, core);
+        arena->noteFallback(stackBytes, "stack");
+    }
+    TaskHandle_t handle = NULL;
+    xTaskCreatePinnedToCore(function, name, stackBytes, param, priority, &handle, core);
+    return handle;
+}
+#endif
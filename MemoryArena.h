@@ -0,0 +1,142 @@
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+#if defined(ARDUINO)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// Every arena block starts on and is rounded up to this (the esp-dsp kernels want 16-byte aligned buffers)
+#define ARENA_ALIGN 16
+// Distinct tags the footprint report breaks usage down by
+#define ARENA_MAX_TAGS 16
+
+inline constexpr size_t arenaRound(size_t bytes){ return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1); }
+
+enum MemRegion {
+    MEM_FAST = 0,           // Internal DRAM: touched for every batch (pool slots, rings, FFT tables, task stacks)
+    MEM_BULK,               // PSRAM when the board has one: touched per spectrum or less (averages, serializer buffers, capture history)
+    MEM_REGION_COUNT
+};
+
+inline const char* memRegionName(MemRegion region){
+    switch (region) {
+        case MEM_FAST: return "fast";
+        case MEM_BULK: return "bulk";
+        default:       return "unk";
+    }
+}
+
+// Fixed-size bump allocator for the buffers that live as long as the program (or their channel).
+// Each region is one block handed over at startup, sized at compile time (see MemoryPlan.h).
+// Nothing is freed: giving a block back only counts it in released(). A full MEM_BULK region
+// spills into MEM_FAST, a full MEM_FAST region into the heap (counted per tag as fallback).
+//
+// Classes allocate through arenaNew / arenaCreate below. They draw from the arena the calling
+// task opened with ArenaScope and from the heap otherwise, so the same class can be built into
+// the arena at startup and on the heap for buffers that come and go (e.g. /analysis/add).
+// Platform neutral; the regions' backing memory is the caller's choice.
+class MemoryArena {
+	public:
+		// Hands a region its memory (base is rounded up to ARENA_ALIGN)
+		void begin(MemRegion region, void* base, size_t bytes);
+
+		// nullptr if neither the region nor its spill region has room
+		void* allocate(size_t bytes, MemRegion region, const char* tag);
+		bool owns(const void* p) const;
+		void release(const void* p) { if (owns(p)) _released++; }
+		// A block the arena could not hold went to the heap
+		void noteFallback(size_t bytes, const char* tag);
+
+		size_t used(MemRegion region) const { return _used[region]; }
+		size_t capacity(MemRegion region) const { return _size[region]; }
+		size_t fallbackBytes() const { return _fallbackBytes; }
+		uint32_t released() const { return _released; }
+
+		// Multi-line footprint per region and tag. Returns the length written.
+		size_t report(char* out, size_t outSize) const;
+
+		// Arena the helpers use on the calling task (nullptr = heap)
+		static MemoryArena* active();
+		// Arena the last begin() set up, the one arenaDelete / arenaDestroy check ownership against
+		// when the block is not the active arena's
+		static MemoryArena* installed();
+
+	private:
+		struct TagUsage {
+			const char*	tag;
+			size_t		bytes[MEM_REGION_COUNT + 1];	// Per region, then heap fallback
+		};
+
+		uint8_t*	_base[MEM_REGION_COUNT] = {};
+		size_t		_size[MEM_REGION_COUNT] = {};
+		size_t		_used[MEM_REGION_COUNT] = {};
+		size_t		_fallbackBytes = 0;
+		uint32_t	_released = 0;
+		TagUsage	_tags[ARENA_MAX_TAGS] = {};
+		int			_tagCount = 0;
+
+		void* take(MemRegion region, size_t bytes);
+		void account(const char* tag, int column, size_t bytes);
+};
+
+// Opens `arena` for the arenaNew / arenaCreate calls of this task until the scope ends.
+// nullptr opens nothing (heap). Scopes nest.
+class ArenaScope {
+	public:
+		explicit ArenaScope(MemoryArena* arena);
+		~ArenaScope();
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+	private:
+		MemoryArena*	_previous;
+};
+
+// Raw ARENA_ALIGN-aligned block from the active arena, else the heap. nullptr when out of memory.
+void* arenaAllocate(size_t bytes, MemRegion region, const char* tag);
+// Frees a heap block, counts an arena block as released
+void arenaFree(void* p);
+
+// T[count] (value-initialised). Free with arenaDelete.
+template<typename T>
+T* arenaNew(size_t count, MemRegion region, const char* tag){
+    T* items = static_cast<T*>(arenaAllocate(sizeof(T) * count, region, tag));
+    if (items == nullptr) return nullptr;
+    for (size_t i = 0; i < count; i++) new (&items[i]) T();
+    return items;
+}
+
+template<typename T>
+void arenaDelete(T* items){
+    static_assert(std::is_trivially_destructible<T>::value, "arenaDelete does not run element destructors");
+    arenaFree(items);
+}
+
+// One object. Free with arenaDestroy (virtual destructors work through a base pointer).
+template<typename T, typename... Args>
+T* arenaCreate(MemRegion region, const char* tag, Args&&... args){
+    void* p = arenaAllocate(sizeof(T), region, tag);
+    return (p != nullptr) ? new (p) T(std::forward<Args>(args)...) : nullptr;
+}
+
+template<typename T>
+void arenaDestroy(T* object){
+    if (object == nullptr) return;
+    object->~T();
+    arenaFree(object);
+}
+
+#if defined(ARDUINO)
+// xTaskCreatePinnedToCore with the stack and TCB taken from the active arena's MEM_FAST region
+// (task stacks must stay in internal RAM). Without room there the task gets a heap stack as before.
+TaskHandle_t arenaTask(TaskFunction_t function, const char* name, uint32_t stackBytes, void* param, UBaseType_t priority, BaseType_t core);
+#endif
+
+#endif
\ No newline at end of file
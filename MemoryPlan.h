@@ -0,0 +1,81 @@
+#ifndef MEMORY_PLAN_H
+#define MEMORY_PLAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MemoryArena.h"
+#include "Protocol.h"
+#include "BatchPool.h"
+#include "CaptureLog.h"
+#include "ProcessingChannel.h"
+#include "ZoomFft.h"
+#include "CorrelationEngine.h"
+
+// Compile-time MemoryArena budget, from the channel / FFT configuration. Each function mirrors
+// the arena allocations of the class it is named after, every block rounded to ARENA_ALIGN.
+// If one drifts, the arena report shows the difference as heap fallback.
+namespace MemoryPlan {
+
+constexpr size_t block(size_t bytes){ return arenaRound(bytes); }
+constexpr size_t pow2AtLeast(size_t n, size_t p = 1){ return (p >= n) ? p : pow2AtLeast(n, 2 * p); }
+
+// RealFftPlan (any backend; 64 covers the largest plan object) or RealFftQ15 of n points:
+// window, work, cos and sin tables
+constexpr size_t fftPlan(int n, DspSampleFormat format){
+    return (format == DSP_Q15) ? block(sizeof(RealFftQ15)) + 2 * block(sizeof(int16_t) * n) + 2 * block(sizeof(int16_t) * (n / 2))
+                               : block(64) + 2 * block(sizeof(float) * n) + 2 * block(sizeof(float) * (n / 2));
+}
+
+// DspPipeline window ring of n samples
+constexpr size_t ring(size_t n, DspSampleFormat format){
+    return block(((format == DSP_Q15) ? sizeof(int16_t) : sizeof(float)) * n);
+}
+
+// ZoomFft: filter taps, complex baseband and work buffers, spectrum, window, twiddles
+constexpr size_t zoom(int points, int decimation){
+    return block(sizeof(ZoomFft)) + 2 * block(sizeof(float) * ZOOM_TAPS_PER_DECIMATION * decimation)
+         + 2 * block(sizeof(float) * 2 * points) + 4 * block(sizeof(float) * points);
+}
+
+// One ProcessingChannel, MEM_FAST part: the object, window ring, spectrum, FFT plan, detector
+// mask and band map, plus the zoom analysis (zoomPoints 0 = none). A zoom that reads more
+// history than the window (taps plus a batch) reallocates the ring, the first one is not reused.
+constexpr size_t channelFast(int fftSize, DspSampleFormat format, int zoomPoints = 0, int zoomDecimation = 0){
+    return block(sizeof(ProcessingChannel)) + ring(fftSize, format) + block(sizeof(float) * (fftSize / 2)) + fftPlan(fftSize, format)
+         + block(sizeof(float) * (fftSize / 2)) + block(fftSize / 2)
+         + ((zoomPoints > 0) ? zoom(zoomPoints, zoomDecimation) : 0)
+         + ((zoomPoints > 0 && ZOOM_TAPS_PER_DECIMATION * zoomDecimation + BATCH_SAMPLES > fftSize)
+            ? ring(pow2AtLeast(ZOOM_TAPS_PER_DECIMATION * zoomDecimation + BATCH_SAMPLES), format) : 0);
+}
+
+// ...MEM_BULK part: the spectrum averages and the detector's simulation frame
+constexpr size_t channelBulk(int fftSize){
+    return AVG_MODE_COUNT * block(sizeof(float) * (fftSize / 2)) + block(sizeof(float) * (fftSize / 2));
+}
+
+// CorrelationEngine over two channels of fftSize points, MEM_FAST part: the object, window,
+// twiddles, work buffer and order frame, plus the two rings it grows to 2 x fftSize (the first
+// ones are not reused)
+constexpr size_t correlationFast(int fftSize, DspSampleFormat format){
+    return block(sizeof(CorrelationEngine)) + 3 * block(sizeof(float) * fftSize) + block(sizeof(float) * 2 * fftSize)
+         + block(sizeof(float) * CORR_ORDER_BINS) + 2 * ring(2 * fftSize, format);
+}
+
+// ...MEM_BULK part: the cross / auto spectrum and order averages
+constexpr size_t correlationBulk(int fftSize){
+    return 4 * block(sizeof(float) * (fftSize / 2)) + block(sizeof(float) * CORR_ORDER_BINS);
+}
+
+// BatchPool object, slots and free stack (MEM_FAST)
+constexpr size_t pool(int capacity){
+    return block(sizeof(BatchPool)) + block(sizeof(InternalMessage_t) * capacity) + block(capacity);
+}
+
+// CaptureLog sector table, page buffer and RAM history (MEM_BULK)
+constexpr size_t capture(int sectors, int pageSize){
+    return block(sizeof(uint32_t) * sectors) + block(pageSize) + block(sizeof(InternalMessage_t) * CAPTURE_PRE_BATCHES) + block(sizeof(uint32_t) * CAPTURE_PRE_BATCHES);
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include <string.h>
+#include "PacketParser.h"
+
+static const size_t V1_HEADER_BYTES = sizeof(PacketHeader_t);
+static const size_t V2_HEADER_BYTES = sizeof(PacketHeaderV2_t);
+static const size_t V1_PAYLOAD_BYTES = sizeof(float) * BATCH_SAMPLES;
+// A v2 sequence this far behind the last one is a sensor that restarted, not a late packet
+static const int32_t SEQUENCE_RESTART = 64;
+
+void PacketParser::reset(){
+    _state = STATE_HEADER;
+    _headerFill = 0;
+    _headerNeed = V1_HEADER_BYTES;
+    _carry = 0;
+    _type = TYPE_UNKNOWN;
+    _dst = nullptr;
+    _codes = nullptr;
+    _payload = nullptr;
+    _payloadFill = 0;
+    _payloadBytes = 0;
+    _haveSequence = false;
+    _inSync = true;
+}
+
+size_t PacketParser::want() const {
+    switch (_state) {
+        case STATE_HEADER:
+            return _headerNeed - _headerFill;
+        case STATE_PAYLOAD: {
+            size_t left = _payloadBytes - _payloadFill;
+            if (_payload == nullptr && left > sizeof(_scratch)) left = sizeof(_scratch);
+            return left;
+        }
+        default:
+            return 1;	// STATE_WAIT_PAYLOAD: caller must beginPayload() first
+    }
+}
+
+uint8_t* PacketParser::writePtr(){
+    if (_state == STATE_HEADER) return &_header[_headerFill];
+    if (_state == STATE_PAYLOAD && _payload != nullptr) return _payload + _payloadFill;
+    return _scratch;
+}
+
+static inline bool knownType(int type){
+    return type == TYPE_VIBRATION || type == TYPE_CURRENT;
+}
+
+bool PacketParser::acceptV1(){
+    PacketHeader_t h;
+    memcpy(&h, _header, sizeof(h));
+    if (h.header != PACKET_HEADER || !knownType(h.type)) return false;
+
+    _type = (SensorDataType)h.type;
+    _info.version = 1;
+    _info.sensorId = 0;
+    _info.encoding = ENC_FLOAT32;
+    _info.sampleRateHz = 0;
+    _info.sequence = 0;
+    _info.timestampUs = 0;
+    _info.scale = 1.0f;
+    _info.offset = 0.0f;
+    _payloadBytes = V1_PAYLOAD_BYTES;
+    return true;
+}
+
+bool PacketParser::acceptV2(){
+    PacketHeaderV2_t h;
+    memcpy(&h, _header, sizeof(h));
+    if (h.check != SampleCodec::headerCheck(h)) return false;
+    if (!knownType(h.type) || h.sampleCount != BATCH_SAMPLES) return false;
+
+    // Float payloads go straight to the destination, the rest must fit the staging buffer
+    size_t maxBytes = SampleCodec::maxPayloadBytes(h.encoding, h.sampleCount);
+    if (maxBytes == 0 || h.payloadBytes == 0 || h.payloadBytes > maxBytes) return false;
+    if (h.encoding == ENC_FLOAT32 && h.payloadBytes != sizeof(float) * BATCH_SAMPLES) return false;	// Short = stale samples in the slot
+    if (h.encoding != ENC_FLOAT32 && h.payloadBytes > sizeof(_staging)) return false;
+
+    _type = (SensorDataType)h.type;
+    _info.version = h.version;
+    _info.sensorId = h.sensorId;
+    _info.encoding = h.encoding;
+    _info.sampleRateHz = h.sampleRateHz;
+    _info.sequence = h.sequence;
+    _info.timestampUs = h.timestampUs;
+    _info.scale = h.scale;
+    _info.offset = h.offset;
+    _payloadBytes = h.payloadBytes;
+    return true;
+}
+
+// Drops bytes from the front of the header window until it starts with a possible
+// header byte again, keeping whatever already arrived after it.
+void PacketParser::slideHeader(){
+    const uint8_t lead = (uint8_t)(PACKET_HEADER & 0xFF);
+    size_t skip = 1;
+    while (skip < _headerFill && _header[skip] != lead) skip++;
+    memmove(_header, _header + skip, _headerFill - skip);
+    _headerFill -= skip;
+    _droppedBytes += skip;
+}
+
+PacketParser::Event PacketParser::evaluateHeader(){
+    for (;;) {
+        if (_headerFill < V1_HEADER_BYTES) {
+            _headerNeed = V1_HEADER_BYTES;
+            return EVENT_NONE;
+        }
+
+        uint16_t magic = (uint16_t)(_header[0] | (_header[1] << 8));
+        size_t headerBytes = 0;
+
+        if (magic == PACKET_HEADER && acceptV1()) {
+            headerBytes = V1_HEADER_BYTES;
+        } else if (magic == PACKET_HEADER_V2 && _header[2] == PACKET_VERSION_V2) {
+            if (_headerFill < V2_HEADER_BYTES) {
+                _headerNeed = V2_HEADER_BYTES;
+                return EVENT_NONE;
+            }
+            if (acceptV2()) headerBytes = V2_HEADER_BYTES;
+        }
+
+        if (headerBytes > 0) {
+            // Bytes read past the header while resyncing already belong to the payload
+            _carry = _headerFill - headerBytes;
+            _headerFill = 0;
+            _headerNeed = V1_HEADER_BYTES;
+            _inSync = true;
+            _state = STATE_WAIT_PAYLOAD;
+            return EVENT_HEADER;
+        }
+
+        // Lost sync: count it once per episode, then rescan what we have
+        if (_inSync) { _resyncs++; _inSync = false; }
+        slideHeader();
+    }
+}
+
+void PacketParser::trackSequence(){
+    if (_info.version < PACKET_VERSION_V2) return;
+    if (_haveSequence) {
+        int32_t delta = (int32_t)(_info.sequence - _lastSequence);
+        if (delta > 1) _lost += (uint32_t)(delta - 1);
+        else if (delta <= 0 && delta > -SEQUENCE_RESTART) { _reordered++; return; }
+        // Further back: follow the new count, like UplinkParser does on HELLO
+    }
+    _lastSequence = _info.sequence;
+    _haveSequence = true;
+}
+
+PacketParser::Event PacketParser::commit(size_t n){
+    if (n == 0) return EVENT_NONE;
+
+    switch (_state) {
+        case STATE_HEADER:
+            _headerFill += n;
+            if (_headerFill < _headerNeed) return EVENT_NONE;
+            return evaluateHeader();
+
+        case STATE_PAYLOAD: {
+            _payloadFill += n;
+            if (_payloadFill < _payloadBytes) return EVENT_NONE;
+            _state = STATE_HEADER;
+
+            if (_dst == nullptr && _codes == nullptr) { _skipped++; return EVENT_SKIPPED; }
+
+            // Integer encodings were staged, expand them into the destination now
+            if (_payload == _staging) {
+                bool ok = (_codes != nullptr) ? SampleCodec::decodeCodes(_info.encoding, _staging, _payloadBytes, BATCH_SAMPLES, _codes)
+                                              : SampleCodec::decode(_info.encoding, _staging, _payloadBytes, BATCH_SAMPLES, _info.scale, _info.offset, _dst);
+                if (!ok) {
+                    _decodeErrors++;
+                    _skipped++;
+                    return EVENT_SKIPPED;
+                }
+            }
+            trackSequence();
+            _packets++;
+            return EVENT_PACKET;
+        }
+
+        default:
+            return EVENT_NONE;
+    }
+}
+
+void PacketParser::beginPayload(float* dst){
+    _dst = dst;
+    _codes = nullptr;
+    if (dst == nullptr) _payload = nullptr;
+    else if (_info.encoding == ENC_FLOAT32) _payload = (uint8_t*)dst;
+    else _payload = _staging;
+    startPayload();
+}
+
+void PacketParser::beginPayloadCodes(int16_t* dst){
+    _dst = nullptr;
+    _codes = SampleCodec::isIntegerEncoding(_info.encoding) ? dst : nullptr;
+    if (_codes == nullptr) _payload = nullptr;
+    else if (_info.encoding == ENC_INT16 && _payloadBytes == sizeof(int16_t) * BATCH_SAMPLES) _payload = (uint8_t*)_codes;	// Wire order == ESP32 / x86 order
+    else _payload = _staging;
+    startPayload();
+}
+
+void PacketParser::startPayload(){
+    _payloadFill = 0;
+    _state = STATE_PAYLOAD;
+
+    // Hand over payload bytes picked up while scanning for the header
+    if (_carry > 0) {
+        size_t headerBytes = (_info.version >= PACKET_VERSION_V2) ? V2_HEADER_BYTES : V1_HEADER_BYTES;
+        size_t carry = (_carry < _payloadBytes) ? _carry : _payloadBytes;
+        if (_payload != nullptr) memcpy(_payload, _header + headerBytes, carry);
+        _payloadFill = carry;
+        _carry = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef PACKET_PARSER_H
+#define PACKET_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "SampleCodec.h"
+
+// Incremental, allocation-free parser for the packet stream of one client.
+// Accepts v1 frames (DataPacket_t) and v2 frames (PacketHeaderV2_t + encoded samples).
+// It consumes whatever bytes are available, and on a bad header it slides forward
+// one byte at a time looking for the 0xA5 lead byte instead of flushing the socket.
+//
+// The caller reads straight into the parser's destination:
+//     n = client.read(parser.writePtr(), min(available, parser.want()));
+//     switch (parser.commit(n)) { ... }
+// On EVENT_HEADER the caller chooses where the BATCH_SAMPLES floats go with beginPayload()
+// (e.g. a BatchPool slot) or passes nullptr to skip them. Float payloads land there
+// directly; integer encodings are staged and decoded into it when the packet completes.
+// For integer encodings beginPayloadCodes() keeps the raw int16 codes instead (the Q15
+// pipeline), and ENC_INT16 payloads then land in the destination without a copy.
+class PacketParser {
+	public:
+		enum Event {
+			EVENT_NONE = 0,
+			EVENT_HEADER,		// Header accepted, call beginPayload()
+			EVENT_PACKET,		// Samples complete in the beginPayload() buffer
+			EVENT_SKIPPED		// Payload consumed but discarded (nullptr buffer or bad encoding)
+		};
+
+		PacketParser() { reset(); }
+		void reset();
+
+		// Bytes the parser wants next (never 0) and where to write them
+		size_t want() const;
+		uint8_t* writePtr();
+
+		// Tell the parser n bytes were written to writePtr()
+		Event commit(size_t n);
+
+		// After EVENT_HEADER: destination for BATCH_SAMPLES floats, or nullptr to drop them
+		void beginPayload(float* dst);
+		// After EVENT_HEADER of an integer encoding: destination for BATCH_SAMPLES raw codes
+		// (info().scale / info().offset convert them). Float payloads are skipped.
+		void beginPayloadCodes(int16_t* dst);
+
+		// Valid from EVENT_HEADER until the next header
+		SensorDataType type() const { return _type; }
+		const BatchInfo_t& info() const { return _info; }
+
+		// --- Counters ---
+		uint32_t packets() const { return _packets; }
+		uint32_t skippedPackets() const { return _skipped; }
+		uint32_t droppedBytes() const { return _droppedBytes; }	// Bytes discarded while resyncing
+		uint32_t resyncs() const { return _resyncs; }			// Times the header check failed
+		uint32_t decodeErrors() const { return _decodeErrors; }
+		uint32_t lostPackets() const { return _lost; }			// v2 sequence gaps
+		uint32_t reordered() const { return _reordered; }		// v2 packets a little older than the last one
+
+	private:
+		enum State { STATE_HEADER, STATE_WAIT_PAYLOAD, STATE_PAYLOAD };
+
+		State		_state;
+		uint8_t		_header[sizeof(PacketHeaderV2_t)];
+		size_t		_headerFill;
+		size_t		_headerNeed;		// 4 until the magic says v2, then sizeof(PacketHeaderV2_t)
+		size_t		_carry;				// Payload bytes already sitting in _header after a resync
+
+		SensorDataType _type;
+		BatchInfo_t	_info;
+		size_t		_payloadBytes;
+
+		float*		_dst;				// Float destination, or
+		int16_t*	_codes;				// raw code destination; both nullptr while skipping
+		uint8_t*	_payload;			// Where wire bytes go: _dst, _codes, _staging or _scratch
+		size_t		_payloadFill;
+		uint8_t		_staging[3 * BATCH_SAMPLES];	// Encoded integer payloads (DELTA8 worst case fits)
+		uint8_t		_scratch[64];		// Sink for skipped payloads
+
+		bool		_haveSequence = false;
+		uint32_t	_lastSequence = 0;
+
+		uint32_t	_packets = 0;
+		uint32_t	_skipped = 0;
+		uint32_t	_droppedBytes = 0;
+		uint32_t	_resyncs = 0;
+		uint32_t	_decodeErrors = 0;
+		uint32_t	_lost = 0;
+		uint32_t	_reordered = 0;
+		bool		_inSync = true;
+
+		Event evaluateHeader();
+		bool acceptV1();
+		bool acceptV2();
+		void slideHeader();
+		void trackSequence();
+		void startPayload();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#if defined(ARDUINO)
+
+#include "PartitionFlashStore.h"
+
+bool PartitionFlashStore::begin(){
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, _label);
+    return _partition != nullptr;
+}
+
+bool PartitionFlashStore::erase(uint32_t offset, uint32_t len){
+    return _partition && esp_partition_erase_range(_partition, offset, len) == ESP_OK;
+}
+
+bool PartitionFlashStore::write(uint32_t offset, const void* src, uint32_t len){
+    return _partition && esp_partition_write(_partition, offset, src, len) == ESP_OK;
+}
+
+bool PartitionFlashStore::read(uint32_t offset, void* dst, uint32_t len){
+    return _partition && esp_partition_read(_partition, offset, dst, len) == ESP_OK;
+}
+
+#endif
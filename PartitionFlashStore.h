@@ -0,0 +1,29 @@
+#ifndef PARTITION_FLASH_STORE_H
+#define PARTITION_FLASH_STORE_H
+
+#if defined(ARDUINO)
+
+#include "esp_partition.h"
+#include "FlashStore.h"
+
+// FlashStore over a raw data partition. The default "spiffs" partition exists in the
+// standard Arduino partition schemes and is otherwise unused by this project.
+class PartitionFlashStore : public FlashStore {
+	public:
+		PartitionFlashStore(const char* label = "spiffs") : _label(label) {}
+
+		bool begin() override;
+		uint32_t size() const override { return _partition ? _partition->size : 0; }
+
+		bool erase(uint32_t offset, uint32_t len) override;
+		bool write(uint32_t offset, const void* src, uint32_t len) override;
+		bool read(uint32_t offset, void* dst, uint32_t len) override;
+
+	private:
+		const char*				_label;
+		const esp_partition_t*	_partition = nullptr;
+};
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// Cheap hot-path timing for the /metrics endpoint.
+// On the ESP32 this is the CPU cycle counter (one register read), on Linux a steady
+// clock in nanoseconds. Differences are taken in 32 bits, so one scope may last up to
+// ~17 s at 240 MHz.
+namespace Perf {
+#if defined(ARDUINO)
+	inline uint32_t cycles() { return ESP.getCycleCount(); }
+	inline uint32_t cyclesPerUs() { return getCpuFrequencyMhz(); }
+#else
+	inline uint32_t cycles() {
+		return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	inline uint32_t cyclesPerUs() { return 1000; }
+#endif
+}
+
+// Timing of one pipeline stage. Written by a single task; readers on another task may
+// see a slightly stale (or, for the 64-bit sum, torn) value, which is fine for monitoring.
+struct PerfStage {
+	uint32_t count = 0;
+	uint64_t totalCycles = 0;
+	uint32_t maxCycles = 0;
+
+	void add(uint32_t cycles){
+		count++;
+		totalCycles += cycles;
+		if (cycles > maxCycles) maxCycles = cycles;
+	}
+};
+
+// Adds the lifetime of the scope to a stage
+class PerfScope {
+	public:
+		explicit PerfScope(PerfStage& stage) : _stage(stage), _start(Perf::cycles()) {}
+		~PerfScope() { _stage.add(Perf::cycles() - _start); }
+
+		PerfScope(const PerfScope&) = delete;
+		PerfScope& operator=(const PerfScope&) = delete;
+
+	private:
+		PerfStage&	_stage;
+		uint32_t	_start;
+};
+
+#endif
\ No newline at end of file
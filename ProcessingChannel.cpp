@@ -0,0 +1,19 @@
+#include <string.h>
+#include "ProcessingChannel.h"
+
+ProcessingChannel::ProcessingChannel(uint8_t slot, SensorDataType type, int batchSamples, int aggregationFactor, float samplingFrequency, int hopSize, uint32_t publishIntervalMs, DspSampleFormat format) : _slot(slot), _type(type), _pipeline(batchSamples, aggregationFactor, samplingFrequency, hopSize, format), _detector(type, _pipeline.bins(), samplingFrequency / _pipeline.fftSize()), _extractor(_pipeline.bins(), samplingFrequency / _pipeline.fftSize(), (type == TYPE_CURRENT) ? 5 : 2), _averager(_pipeline.bins()), _publishIntervalMs(publishIntervalMs){
+	memset(&_features, 0, sizeof(_features));
+}
+
+bool ProcessingChannel::publishDue(uint32_t nowMs){
+    if (_published && (uint32_t)(nowMs - _lastPublishMs) <= _publishIntervalMs) return false;
+    _lastPublishMs = nowMs;
+    _published = true;
+    return true;
+}
+
+void ProcessingChannel::bindStream(const InternalMessage_t& msg){
+    _connection = msg.connection;
+    _haveSensorId = msg.info.version >= PACKET_VERSION_V2;
+    _sensorId = msg.info.sensorId;
+}
@@ -0,0 +1,94 @@
+#ifndef PROCESSING_CHANNEL_H
+#define PROCESSING_CHANNEL_H
+
+#include <stdint.h>
+#include "Protocol.h"
+#include "DspPipeline.h"
+#include "AnomalyDetector.h"
+#include "FeatureExtractor.h"
+#include "SpectrumAverager.h"
+
+// Short name used in the dashboard JSON ("vib" / "cur")
+inline const char* sensorTypeName(SensorDataType type){
+    switch (type) {
+        case TYPE_VIBRATION: return "vib";
+        case TYPE_CURRENT:   return "cur";
+        default:             return "unk";
+    }
+}
+
+// One sensor stream, keyed by CommunicationHub slot + data type. A new client in the slot takes
+// the channel over (ProcessingCore::takeOver) unless it needs another pipeline.
+// Owns its own aggregation ring / FFT plan, anomaly detector, feature extractor,
+// spectrum averages and dashboard publish throttle, so a busy stream cannot starve another one's updates.
+class ProcessingChannel {
+	public:
+		ProcessingChannel(uint8_t slot, SensorDataType type, int batchSamples, int aggregationFactor, float samplingFrequency, int hopSize, uint32_t publishIntervalMs, DspSampleFormat format = DSP_FLOAT32);
+
+		bool matches(uint8_t slot, SensorDataType type) const { return _slot == slot && _type == type && !_retired; }
+
+		// --- The client feeding the slot ---
+		// Takes the hub connection (and v2 sensor id) of msg as the channel's current one
+		void bindStream(const InternalMessage_t& msg);
+		// msg comes from the connection the channel is bound to
+		bool sameStream(const InternalMessage_t& msg) const { return msg.connection == _connection; }
+		// msg comes from the sensor the channel was bound to (v2 only: v1 nodes carry no id)
+		bool sameSensor(const InternalMessage_t& msg) const {
+			return _haveSensorId && msg.info.version >= PACKET_VERSION_V2 && msg.info.sensorId == _sensorId;
+		}
+		// The slot's new client needs another pipeline: lookups skip this channel from now on
+		void retire() { _retired = true; }
+		bool retired() const { return _retired; }
+
+		// Returns true when a new spectrum is ready
+		bool pushBatch(const InternalMessage_t& msg) {
+			if (msg.format == BATCH_CODES) return _pipeline.pushCodes(msg.codes, msg.info.scale, msg.info.offset);
+			return _pipeline.pushBatch(msg.data);
+		}
+
+		// Runs the detector on the latest spectrum. Returns true when the alarm state changed.
+		bool analyse(AlarmEvent_t* event) { return _detector.update(_pipeline, event); }
+
+		// Summarises the latest spectrum into features()
+		void extractFeatures() { _extractor.extract(_pipeline, &_features); }
+
+		// Folds the latest spectrum into the averages / peak hold
+		void accumulate() { _averager.update(_pipeline.spectrum()); }
+
+		// Returns true (and restarts the throttle) if this channel may publish at nowMs
+		bool publishDue(uint32_t nowMs);
+		// Makes the next publishDue() true
+		void requestPublish() { _published = false; }
+
+		uint8_t slot() const { return _slot; }
+		SensorDataType type() const { return _type; }
+		const char* typeName() const { return sensorTypeName(_type); }
+		DspPipeline& pipeline() { return _pipeline; }
+		const DspPipeline& pipeline() const { return _pipeline; }
+		AnomalyDetector& detector() { return _detector; }
+		const AnomalyDetector& detector() const { return _detector; }
+		FeatureExtractor& extractor() { return _extractor; }
+		const FeatureVector_t& features() const { return _features; }
+		SpectrumAverager& averager() { return _averager; }
+		const SpectrumAverager& averager() const { return _averager; }
+
+	private:
+		uint8_t			_slot;
+		SensorDataType	_type;
+		DspPipeline		_pipeline;
+		AnomalyDetector	_detector;
+		FeatureExtractor _extractor;
+		FeatureVector_t	_features;
+		SpectrumAverager _averager;
+
+		uint8_t			_connection = 0;
+		uint8_t			_sensorId = 0;
+		bool			_haveSensorId = false;
+		volatile bool	_retired = false;
+
+		uint32_t		_publishIntervalMs;
+		uint32_t		_lastPublishMs = 0;
+		bool			_published = false;
+};
+
+#endif
\ No newline at end of file
@@ -1,150 +1,1254 @@
-#include <Arduino.h>
-#include "ProcessingCore.h"
-#include "WebCode.h"
-#include "Protocol.h"
-
-ProcessingCore::ProcessingCore(int eventPort, const char* eventPath, int batchSamples, int aggregationFactor) : _webServer(eventPort), _events(eventPath), _batchSamples(batchSamples), _aggregationFactor(aggregationFactor){
-	
-	
-	_fftPools = aggregationFactor * batchSamples;
-	
-	_latestVibData	= new float[_fftPools];
-	_latestCurData	= new float[_fftPools];
-	_latestVibFft	= new float[_fftPools / 2];
-	_latestCurFft	= new float[_fftPools / 2];
-	
-	_vReal	= new float[_fftPools];
-	_vImag	= new float[_fftPools];
-	_FFT	= new ArduinoFFT<float> (_vReal, _vImag, _fftPools, 1000.0, false);
-}
-
-void ProcessingCore::begin(QueueHandle_t vQ, QueueHandle_t cQ){
-	_vibQueue = vQ; _curQueue = cQ;
-	
-    _webServer.on("/", HTTP_GET, [](AsyncWebServerRequest *req){ 
-        req->send_P(200, "text/html", index_html);
-    });
-    _events.onConnect([](AsyncEventSourceClient *client){
-        client->send("Connected", NULL, millis(), 1000);
-    });
-    _webServer.addHandler(&_events);
-    _webServer.begin();
-	
-	xTaskCreatePinnedToCore(
-        taskWrapper,    // Function to run
-        "ProcTask",     // Name
-        30000,           // Stack size
-        this,           // PASSING THE INSTANCE
-        1,              // Priority
-        NULL,           // Task handle
-        1               // Core 1
-    );
-}
-
-void ProcessingCore::taskWrapper(void* pvParameters){
-	ProcessingCore* instance = (ProcessingCore*) pvParameters; 
-    instance->processingWorker();
-}
-
-void ProcessingCore::processingWorker(){
-    InternalMessage_t incoming;
-    static char jsonBuffer[8192]; // Large buffer for JSON string
-    
-    // Throttling variables to prevent flooding the web browser
-    unsigned long lastWebUpdate = 0;
-    const unsigned long WEB_UPDATE_INTERVAL = 200; // 200ms = 5 Updates per second max
-
-    for(;;) {
-        // -------------------------
-        // --- PROCESS VIBRATION ---
-        // -------------------------
-        if (xQueueReceive(_vibQueue, &incoming, 0) == pdPASS) {
-            
-            // 1. Copy data into the large FFT buffer
-            memcpy(&_latestVibData[_vibCount * _batchSamples], incoming.data, sizeof(float)*_batchSamples);
-            _vibCount++;
-
-            // 2. If we have 4 batches (1024 samples), run FFT
-            if (_vibCount == _aggregationFactor) {
-                
-                // Prepare FFT arrays
-                memcpy(_vReal, _latestVibData, sizeof(_vReal));
-                memset(_vImag, 0, sizeof(_vImag));
-                
-                // Execute FFT
-                _FFT->dcRemoval();
-                _FFT->windowing(FFTWindow::Hann, FFTDirection::Forward, false);
-                _FFT->compute(FFTDirection::Forward);
-                _FFT->complexToMagnitude();
-                
-                // Store Result
-                memcpy(_latestVibFft, _vReal, sizeof(_latestVibFft));
-
-                // 3. Send to Web (Throttled)
-                if (millis() - lastWebUpdate > WEB_UPDATE_INTERVAL) {
-                    
-                    // Manually build JSON string for speed
-                    int len = sprintf(jsonBuffer, "{\"type\":\"vib\",\"fft\":[");
-                    
-                    // Add 512 FFT points
-                    for (int i = 0; i < 512; i++) {
-                        len += sprintf(jsonBuffer + len, "%.2f%s", _latestVibFft[i], (i<511)?",":"]");
-                    }
-                    
-                    // Add Time Domain Data
-                    // IMPORTANT: We skip every 4th sample to save bandwidth (1024 -> 256 points)
-                    len += sprintf(jsonBuffer + len, ",\"time\":[");
-                    for (int i = 0; i < 1024; i+=4) { 
-                        len += sprintf(jsonBuffer + len, "%.2f%s", _latestVibData[i], (i<1020)?",":"]}");
-                    }
-
-                    // Send via SSE
-                    _events.send(jsonBuffer, "update", millis());
-                    lastWebUpdate = millis();
-                }
-                _vibCount = 0; // Reset counter
-            }
-        }
-        
-        // -----------------------
-        // --- PROCESS CURRENT ---
-        // -----------------------
-        if (xQueueReceive(_curQueue, &incoming, 0) == pdPASS) {
-            
-            // 1. Copy data
-            memcpy(&_latestCurData[_curCount * _batchSamples], incoming.data, sizeof(float)*_batchSamples);
-            _curCount++;
-
-            // 2. If aggregated, run FFT
-            if (_curCount == _aggregationFactor) {
-                memcpy(_vReal, _latestCurData, sizeof(_vReal));
-                memset(_vImag, 0, sizeof(_vImag));
-                _FFT->dcRemoval();
-                _FFT->windowing(FFTWindow::Hann, FFTDirection::Forward, false);
-                _FFT->compute(FFTDirection::Forward);
-                _FFT->complexToMagnitude();
-                memcpy(_latestCurFft, _vReal, sizeof(_latestCurFft));
-
-                // 3. Send to Web (Throttled)
-                if (millis() - lastWebUpdate > WEB_UPDATE_INTERVAL) {
-                    
-                    int len = sprintf(jsonBuffer, "{\"type\":\"cur\",\"fft\":[");
-                    for (int i = 0; i < 512; i++) {
-                        len += sprintf(jsonBuffer + len, "%.2f%s", _latestCurFft[i], (i<511)?",":"]");
-                    }
-                    len += sprintf(jsonBuffer + len, ",\"time\":[");
-                    for (int i = 0; i < 1024; i+=4) { 
-                        len += sprintf(jsonBuffer + len, "%.2f%s", _latestCurData[i], (i<1020)?",":"]}");
-                    }
-
-                    _events.send(jsonBuffer, "update", millis());
-                    lastWebUpdate = millis();
-                }
-                _curCount = 0;
-            }
-        }
-
-        // Small yield to allow other tasks to run if needed
-        vTaskDelay(5); 
-    }
-}
+#include <Arduino.h>
+#include <memory>
+#include "ProcessingCore.h"
+#include "CommunicationHub.h"
+#include "WebCode.h"
+#include "Protocol.h"
+
+// Full spectrum + time trace per channel. Features go out with every spectrum instead,
+// the full frame only every 5 s (or right away when the dashboard asks via /spectrum).
+static const uint32_t WEB_UPDATE_INTERVAL = 5000;
+
+// Default band features: 1x..3x running speed (1500 rpm), changed with /bands?hz=
+static const float DEFAULT_RUNNING_HZ = 25.0f;
+static const int RUNNING_HARMONICS = 3;
+
+// Sample rate of v1 sensor nodes (v2 packets carry their own)
+static const float DEFAULT_SAMPLE_RATE = 1000.0f;
+
+// Spectra per channel used to learn the baseline (~13 s at 1 kHz with a 256 hop)
+static const int LEARN_FRAMES = 50;
+
+// Current channels zoom on the line frequency (LINE_ZOOM_POINTS / LINE_ZOOM_DECIMATION)
+static const float LINE_FREQUENCY_HZ = 50.0f;
+
+// Limits for /analysis/add (a 4096-point float FFT analysis adds about 70 KB, including the larger ring)
+static const int MAX_ANALYSIS_POINTS = 4096;
+static const int MAX_ZOOM_DECIMATION = 64;
+
+// Longest the processing task sleeps without data before doing housekeeping
+static const uint32_t HOUSEKEEPING_INTERVAL = 1000;
+
+// Heap protection for the dashboard streams: below LOW only alarms / status are queued,
+// below CRITICAL the SSE viewer holding the most queued bytes is disconnected.
+// MIN_BLOCK leaves room for a full-spectrum event (about 8 KB, copied once per viewer).
+static const uint32_t HEAP_LOW_BYTES = 32 * 1024;
+static const uint32_t HEAP_CRITICAL_BYTES = 16 * 1024;
+static const uint32_t HEAP_MIN_BLOCK_BYTES = 12 * 1024;
+
+static bool heapLow(){
+    return ESP.getFreeHeap() < HEAP_LOW_BYTES || ESP.getMaxAllocHeap() < HEAP_MIN_BLOCK_BYTES;
+}
+
+// Stack buffer the JSON arrays of the HTTP responses are streamed through (see toResponse)
+static const size_t RESPONSE_CHUNK_BYTES = 256;
+
+// TextWriter sink: appends each chunk to the response stream
+static bool toResponse(const char* data, size_t len, void* ctx){
+    return ((AsyncResponseStream*)ctx)->write((const uint8_t*)data, len) == len;
+}
+
+// Holds a mutex for the scope (the worker-shared sinks: capture log, uplink, correlation)
+class LockScope {
+	public:
+		explicit LockScope(SemaphoreHandle_t lock) : _lock(lock) { xSemaphoreTake(_lock, portMAX_DELAY); }
+		~LockScope() { xSemaphoreGive(_lock); }
+
+		LockScope(const LockScope&) = delete;
+		LockScope& operator=(const LockScope&) = delete;
+
+	private:
+		SemaphoreHandle_t _lock;
+};
+
+// /metrics names of ProcessingCore::Stage, in order
+static const char* STAGE_NAMES[] = {
+    "aggregate", "fft", "detect", "features", "average", "capture", "correlate",
+    "serialize_json", "serialize_binary", "sse_send", "ws_send", "uplink"
+};
+
+// Bytes AsyncEventSource queues for one event sent with send() ("id: ...\r\nevent: ...\r\ndata: ...\r\n\r\n")
+static size_t eventBytes(size_t jsonLen, const char* event){
+    return jsonLen + (event ? strlen(event) : 0) + 32;
+}
+
+ProcessingCore::ProcessingCore(int eventPort, const char* eventPath, int batchSamples, int aggregationFactor, int hopSize, int maxChannels) : _webServer(eventPort), _events(eventPath), _ws("/ws"), _batchSamples(batchSamples), _aggregationFactor(aggregationFactor), _hopSize(hopSize), _maxChannels(maxChannels){
+	
+	
+	_fftPools = aggregationFactor * batchSamples;
+	_frameCapacity	= SpectrumCodec::frameSize(_fftPools / 2, _fftPools / TIME_STRIDE);
+	_analysisLock = xSemaphoreCreateMutex();
+	_channelLock = xSemaphoreCreateMutex();
+	_sinkLock = xSemaphoreCreateMutex();
+	_correlationLock = xSemaphoreCreateMutex();
+	_averageLock = xSemaphoreCreateMutex();
+	_detectorLock = xSemaphoreCreateMutex();
+
+	for (int i = 0; i < MAX_SSE_CLIENTS; i++) _sse[i].client = nullptr;
+	_sseLock = xSemaphoreCreateRecursiveMutex();
+	_updateBytes = 8192;
+}
+
+void ProcessingCore::begin(BatchRing* rings, int ringCount, BatchPool* pool){
+	_rings = rings;
+	_ringCount = ringCount;
+	_pool = pool;
+
+	// Kept for good, from the caller's ArenaScope (budget: arenaFastBytes / arenaBulkBytes)
+	_channels		= arenaNew<ProcessingChannel*>(_maxChannels, MEM_FAST, "core");
+	_scheduler		= arenaCreate<DspScheduler>(MEM_FAST, "core", rings, ringCount, DSP_WORKERS);
+	for (int w = 0; w < DSP_WORKERS; w++) {
+		_workers[w].core = this;
+		_workers[w].index = w;
+		if (w == 0) snprintf(_workers[w].name, sizeof(_workers[w].name), "ProcTask");
+		else snprintf(_workers[w].name, sizeof(_workers[w].name), "DspTask%d", w);
+		_workers[w].frameBuffer	= arenaNew<uint8_t>(_frameCapacity, MEM_BULK, "serialize");
+		_workers[w].jsonBuffer	= arenaNew<char>(PROC_JSON_BYTES, MEM_BULK, "serialize");
+	}
+	// Every sensor is served by core 1; the core 0 workers only take batches that are queued up
+	for (int lane = 0; lane < _scheduler->laneCount(); lane++) _scheduler->setHome(lane, 0);
+	for (int w = 1; w < DSP_WORKERS; w++) _scheduler->setStealBacklog(w, DSP_HELPER_BACKLOG);
+	
+    _webServer.on("/", HTTP_GET, [](AsyncWebServerRequest *req){ 
+        req->send_P(200, "text/html", index_html);
+    });
+    _events.onConnect([this](AsyncEventSourceClient *client){
+        addSseClient(client);
+    });
+    // --- Anomaly detection control ---
+    _webServer.on("/learn", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        _learnRequested = true;
+        req->send(202, "text/plain", "Learning");
+    });
+    _webServer.on("/simulate", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        static const char* faults[] = { "vib", "jam", "dry", "arc" };
+        String fault = req->hasParam("fault") ? req->getParam("fault")->value() : "";
+        for (int i = 0; i < 4; i++) {
+            if (fault == faults[i]) {
+                _simulateRequested = i;
+                req->send(202, "text/plain", "Simulating");
+                return;
+            }
+        }
+        req->send(400, "text/plain", "fault=vib|jam|dry|arc");
+    });
+    _webServer.on("/model", HTTP_GET, [this](AsyncWebServerRequest *req){
+        sendModel(req);
+    });
+    // --- Dashboard output control ---
+    _webServer.on("/spectrum", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        _spectrumRequested = true;
+        req->send(202, "text/plain", "Spectrum requested");
+    });
+    _webServer.on("/bands", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        float hz = req->hasParam("hz") ? req->getParam("hz")->value().toFloat() : 0;
+        if (hz <= 0) {
+            req->send(400, "text/plain", "hz=<running speed>");
+            return;
+        }
+        _runningHzRequested = hz;
+        req->send(202, "text/plain", "Bands updated");
+    });
+    // --- Spectrum averages (registered before /average, which would also match its sub-path) ---
+    _webServer.on("/average/reset", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        _averageAlpha = req->hasParam("alpha") ? req->getParam("alpha")->value().toFloat() : 0;
+        _averageFrames = req->hasParam("frames") ? req->getParam("frames")->value().toInt() : -1;
+        _averageResetRequested = true;
+        req->send(202, "text/plain", "Averages reset");
+    });
+    _webServer.on("/average", HTTP_GET, [this](AsyncWebServerRequest *req){
+        sendAverage(req);
+    });
+    // --- Extra analyses (add / clear registered before /analysis, which would also match them) ---
+    _webServer.on("/analysis/add", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        requestAnalysis(req, false);
+    });
+    _webServer.on("/analysis/clear", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        requestAnalysis(req, true);
+    });
+    _webServer.on("/analysis", HTTP_GET, [this](AsyncWebServerRequest *req){
+        sendAnalysis(req);
+    });
+    // --- Post-mortem capture (trigger registered before /capture, which would also match it) ---
+    _webServer.on("/capture/trigger", HTTP_ANY, [this](AsyncWebServerRequest *req){
+        _captureRequested = true;
+        req->send(202, "text/plain", "Capture triggered");
+    });
+    _webServer.on("/capture", HTTP_GET, [this](AsyncWebServerRequest *req){
+        sendCapture(req);
+    });
+    // --- Current vs vibration correlation ---
+    _webServer.on("/correlation", HTTP_GET, [this](AsyncWebServerRequest *req){
+        sendCorrelation(req);
+    });
+    _webServer.on("/metrics", HTTP_GET, [this](AsyncWebServerRequest *req){
+        sendMetrics(req);
+    });
+    _webServer.addHandler(&_events);
+    _webServer.addHandler(&_ws);
+    _webServer.begin();
+	
+	for (int w = 0; w < DSP_WORKERS; w++) {
+		_workerTasks[w] = arenaTask(
+	        taskWrapper,        // Function to run
+	        _workers[w].name,   // Name
+	        PROC_TASK_STACK,    // Stack size
+	        &_workers[w],       // PASSING THE WORKER
+	        DSP_TASK_PRIORITY,  // Priority
+	        w ? 0 : 1           // ProcTask on core 1, helpers on core 0
+	    );
+	}
+}
+
+void ProcessingCore::taskWrapper(void* pvParameters){
+	Worker* worker = (Worker*) pvParameters; 
+    worker->core->processingWorker(*worker);
+}
+
+// v2 packets carry the sensor's sample rate, v1 nodes are assumed to run at 1 kHz
+static float streamRate(const InternalMessage_t& msg){
+    return (msg.info.sampleRateHz > 0) ? (float)msg.info.sampleRateHz : DEFAULT_SAMPLE_RATE;
+}
+
+// Integer encodings (12-bit ADC nodes) get the Q15 pipeline: half the buffer memory
+static DspSampleFormat streamFormat(const InternalMessage_t& msg){
+    return (msg.format == BATCH_CODES) ? DSP_Q15 : DSP_FLOAT32;
+}
+
+// A slot's channels are only created (and taken over) by the worker holding that slot's lane, so
+// the lookup needs no lock; the lock only orders appends from workers on different lanes.
+ProcessingChannel* ProcessingCore::channelFor(uint8_t slot, SensorDataType type, const InternalMessage_t& first){
+    const int count = __atomic_load_n(&_channelCount, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        if (!_channels[i]->matches(slot, type)) continue;
+        if (_channels[i]->sameStream(first) || takeOver(*_channels[i], first)) return _channels[i];
+        break;		// Retired: the new client gets a channel of its own
+    }
+    LockScope locked(_channelLock);
+    const int index = _channelCount;
+    if (index >= _maxChannels) return nullptr;	// Table full: drop the stream
+
+    // New (slot, type): allocate its buffers and FFT plan once
+    float samplingFrequency = streamRate(first);
+    DspSampleFormat format = streamFormat(first);
+    ArenaScope scope(_arena);	// Channels live for good; analyses added later come from the heap
+    ProcessingChannel* channel = arenaCreate<ProcessingChannel>(MEM_FAST, "channel", slot, type, _batchSamples, _aggregationFactor, samplingFrequency, _hopSize, WEB_UPDATE_INTERVAL, format);
+    channel->extractor().setHarmonicBands(DEFAULT_RUNNING_HZ, RUNNING_HARMONICS);
+    if (type == TYPE_CURRENT) channel->pipeline().addZoomAnalysis(LINE_FREQUENCY_HZ, LINE_ZOOM_POINTS, LINE_ZOOM_DECIMATION);
+    channel->bindStream(first);
+    Serial.printf("Channel %d: slot %d, %s, %s\n", index, slot, sensorTypeName(type), (format == DSP_Q15) ? "q15" : "float");
+    _channels[index] = channel;
+    __atomic_store_n(&_channelCount, index + 1, __ATOMIC_RELEASE);
+    if (_correlation == nullptr || _correlated[0]->retired() || _correlated[1]->retired()) _pairRequested = true;
+    if (_arena != nullptr) Serial.printf("Arena: fast %u / %u bytes, heap fallback %u bytes\n", (unsigned)_arena->used(MEM_FAST), (unsigned)_arena->capacity(MEM_FAST), (unsigned)_arena->fallbackBytes());
+    return channel;
+}
+
+// A new client took the channel's hub slot. Its samples do not continue the old stream, so the
+// input restarts; a different sensor (or a v1 node, which carries no id) also starts without the
+// old one's model and averages. A client at another sample rate or sample format needs another
+// pipeline: the channel is retired and channelFor builds a new one. Returns false then.
+bool ProcessingCore::takeOver(ProcessingChannel& channel, const InternalMessage_t& msg){
+    DspPipeline& pipeline = channel.pipeline();
+    if (streamRate(msg) != pipeline.samplingFrequency() || streamFormat(msg) != pipeline.format()) {
+        channel.retire();
+        Serial.printf("Channel slot %d %s: new client at another rate / format, retired\n", channel.slot(), channel.typeName());
+        return false;
+    }
+
+    const bool sameSensor = channel.sameSensor(msg);
+    channel.bindStream(msg);
+    // The engine reads the paired rings: restart between two of its frames
+    CorrelationEngine* correlation = _correlation;
+    bool paired = correlation != nullptr && (&channel == _correlated[0] || &channel == _correlated[1]);
+    if (paired) xSemaphoreTake(_correlationLock, portMAX_DELAY);
+    pipeline.restart();
+    if (paired) {
+        correlation->reset();
+        xSemaphoreGive(_correlationLock);
+    }
+    if (!sameSensor) {
+        {
+            LockScope locked(_detectorLock);
+            channel.detector().reset();
+        }
+        {
+            LockScope locked(_averageLock);
+            channel.averager().reset();
+        }
+        publishStatus(channel);
+    }
+    Serial.printf("Channel slot %d %s: new client, %s\n", channel.slot(), channel.typeName(), sameSensor ? "same sensor" : "model cleared");
+    return true;
+}
+
+// The first current and the first vibration channel, once both exist at the same sample rate.
+// The engine grows both pipelines' rings, so ProcTask builds it with the workers paused
+// (serviceRequests). From the arena: it lives as long as the channels. A pair with a retired
+// channel is replaced; the old engine stays allocated, a /correlation reply may still read it.
+void ProcessingCore::pairChannels(){
+    if (_correlation != nullptr && !_correlated[0]->retired() && !_correlated[1]->retired()) return;
+    ProcessingChannel* current = nullptr;
+    ProcessingChannel* vibration = nullptr;
+    for (int i = 0; i < _channelCount; i++) {
+        if (_channels[i]->retired()) continue;
+        if (current == nullptr && _channels[i]->type() == TYPE_CURRENT) current = _channels[i];
+        if (vibration == nullptr && _channels[i]->type() == TYPE_VIBRATION) vibration = _channels[i];
+    }
+    if (current == nullptr || vibration == nullptr) return;
+    if (!CorrelationEngine::compatible(current->pipeline(), vibration->pipeline(), _fftPools)) {
+        Serial.println("Correlation: current and vibration sample rates differ, not paired");
+        return;
+    }
+    ArenaScope scope(_arena);
+    CorrelationEngine* engine = arenaCreate<CorrelationEngine>(MEM_FAST, "correlate", current->pipeline(), vibration->pipeline(), _fftPools);
+    if (engine == nullptr) return;
+    engine->setRunningHz(DEFAULT_RUNNING_HZ);
+    _correlated[0] = current;
+    _correlated[1] = vibration;
+    _correlation = engine;
+    Serial.printf("Correlation: current slot %d with vibration slot %d\n", current->slot(), vibration->slot());
+}
+
+// due: the channel's throttle (or /spectrum) says everyone gets this spectrum. Otherwise it only
+// goes to SSE viewers that were refused an earlier one and can take it now (drop-to-latest).
+void ProcessingCore::publish(Worker& worker, const ProcessingChannel& channel, bool due){
+    // Only pay for the encodings someone is listening to
+    if (due && _ws.count() > 0 && !heapLow()) publishBinary(worker, channel);
+    if (_sseCount > 0) {
+        uint32_t targets = spectrumTargets(channelBit(channel), due);
+        if (targets != 0) publishJson(worker, channel, targets);
+    }
+}
+
+void ProcessingCore::publishBinary(Worker& worker, const ProcessingChannel& channel){
+    size_t len;
+    {
+        PerfScope timed(worker.stages[STAGE_BINARY]);
+        len = SpectrumCodec::encode(worker.frameBuffer, _frameCapacity, channel.type(), channel.slot(), channel.pipeline(), TIME_STRIDE);
+    }
+    if (len > 0) {
+        PerfScope timed(worker.stages[STAGE_WS]);
+        xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+        _ws.binaryAll(worker.frameBuffer, len);
+        xSemaphoreGiveRecursive(_sseLock);
+    }
+}
+
+// WebSocket text frame to every client; the workers take turns on the client list
+void ProcessingCore::sendText(const char* text, size_t len){
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    _ws.textAll(text, len);
+    xSemaphoreGiveRecursive(_sseLock);
+}
+
+void ProcessingCore::publishJson(Worker& worker, const ProcessingChannel& channel, uint32_t targets){
+    // Serialized once, straight into the SSE wire format every viewer is sent
+    uint32_t start = Perf::cycles();
+    uint32_t now = millis();
+    TextWriter out(worker.jsonBuffer, PROC_JSON_BYTES);
+    SseFrame::open(out, "update", now);
+    SpectrumCodec::writeJson(out, channel.typeName(), channel.slot(), channel.pipeline(), TIME_STRIDE);
+    SseFrame::close(out);
+    worker.stages[STAGE_JSON].add(Perf::cycles() - start);
+    if (out.overflowed()) {
+        _jsonOverflows++;
+        return;
+    }
+
+    _updateBytes = out.length();
+
+    // Send via SSE, to the viewers spectrumTargets() picked
+    PerfScope timed(worker.stages[STAGE_SSE]);
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    uint32_t refused = sendFrame(out.data(), out.length(), PACE_SPECTRUM, now, targets);
+    uint32_t bit = channelBit(channel);
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (!(targets & (1u << i))) continue;
+        if (refused & (1u << i)) _sse[i].staleChannels |= bit;
+        else _sse[i].staleChannels &= ~bit;
+    }
+    xSemaphoreGiveRecursive(_sseLock);
+}
+
+void ProcessingCore::handleBatch(Worker& worker, uint8_t index){
+    PerfStage* stages = worker.stages;
+    worker.batches++;
+
+    // Aggregate straight from the pool slot, then hand it back to the hub
+    const InternalMessage_t* incoming = _pool->slot(index);
+    ProcessingChannel* channel = channelFor(incoming->sensorSlot, incoming->type, *incoming);
+    // The engine reads both paired windows: their batches take turns from pushBatch to onBatch
+    CorrelationEngine* correlation = _correlation;
+    bool paired = channel != nullptr && correlation != nullptr && (channel == _correlated[0] || channel == _correlated[1]);
+    if (paired) xSemaphoreTake(_correlationLock, portMAX_DELAY);
+    bool ready = false;
+    if (channel != nullptr) {
+        uint32_t start = Perf::cycles();
+        ready = channel->pushBatch(*incoming);
+        stages[ready ? STAGE_FFT : STAGE_AGGREGATE].add(Perf::cycles() - start);
+    }
+    // Every batch of a paired channel moves its clock, now = hub time it is seen here
+    bool correlated = false;
+    CorrelationSummary_t summary;
+    if (paired) {
+        {
+            PerfScope timed(stages[STAGE_CORRELATE]);
+            correlated = correlation->onBatch(channel->pipeline(), incoming->info, micros());
+        }
+        if (correlated) summary = correlation->summary();
+        xSemaphoreGive(_correlationLock);
+    }
+    if (_capture != nullptr || (channel != nullptr && _uplink != nullptr && _uplink->forwardRaw())) {
+        LockScope locked(_sinkLock);
+        if (_capture != nullptr) {
+            PerfScope timed(stages[STAGE_CAPTURE]);
+            _capture->recordBatch(*incoming, millis());
+        }
+        if (channel != nullptr && _uplink != nullptr && _uplink->forwardRaw()) {
+            PerfScope timed(stages[STAGE_UPLINK]);
+            _uplink->sendRaw(*incoming);
+        }
+    }
+    _pool->release(index, worker.index);
+    if (correlated) publishCorrelation(summary);
+
+    // FFT ran once a hop worth of new samples was collected
+    if (ready) {
+
+        // Every spectrum is checked, only the dashboard output is throttled
+        AnomalyDetector::State before = channel->detector().state();
+        int progress = channel->detector().learningPercent();
+        AlarmEvent_t alarm;
+        uint32_t start = Perf::cycles();
+        bool changed;
+        {
+            LockScope locked(_detectorLock);
+            changed = channel->analyse(&alarm);
+        }
+        stages[STAGE_DETECT].add(Perf::cycles() - start);
+        if (changed) {
+            publishAlarm(*channel, alarm);
+            if (_uplink != nullptr) {
+                LockScope locked(_sinkLock);
+                PerfScope timed(stages[STAGE_UPLINK]);
+                _uplink->sendAlarm(*channel, alarm);
+            }
+            if (alarm.code != ALARM_NONE) triggerCapture(worker, *channel, alarm);
+        }
+        if (_capture != nullptr) {
+            LockScope locked(_sinkLock);
+            if (_capture->capturing()) {
+                PerfScope timed(stages[STAGE_CAPTURE]);
+                _capture->recordSpectrum(channel->slot(), channel->type(), channel->pipeline(), millis());
+            }
+        }
+        if (channel->detector().state() != before || channel->detector().learningPercent() / 10 != progress / 10) {
+            publishStatus(*channel);
+        }
+
+        // Features: every spectrum, a few dozen bytes
+        {
+            PerfScope timed(stages[STAGE_FEATURES]);
+            channel->extractFeatures();
+        }
+        publishFeatures(*channel);
+        {
+            PerfScope timed(stages[STAGE_AVERAGE]);
+            LockScope locked(_averageLock);
+            channel->accumulate();
+        }
+
+        // Full spectrum: throttled per channel, or on request; viewers that missed one get the next.
+        // The gateway gets features every spectrum and the spectrum at the same throttle.
+        bool due = channel->publishDue(millis());
+        if (_uplink != nullptr) {
+            LockScope locked(_sinkLock);
+            PerfScope timed(stages[STAGE_UPLINK]);
+            _uplink->sendFeatures(*channel);
+            if (due) _uplink->sendSpectrum(*channel);
+        }
+        publish(worker, *channel, due);
+    }
+}
+
+void ProcessingCore::publishAlarm(const ProcessingChannel& channel, const AlarmEvent_t& alarm){
+    uint32_t now = millis();
+    char frame[224];
+    TextWriter out(frame, sizeof(frame));
+    size_t body = SseFrame::open(out, "alarm", now);
+    out.text("{\"type\":\"").text(channel.typeName()).text("\",\"slot\":").integer(channel.slot())
+       .text(",\"code\":").integer(alarm.code).text(",\"text\":\"").text(alarmText(alarm.code))
+       .text("\",\"hz\":").fixed(alarm.frequencyHz, 1).text(",\"value\":").fixed(alarm.value, 2)
+       .text(",\"limit\":").fixed(alarm.limit, 2).put('}');
+    size_t bodyEnd = out.length();
+    SseFrame::close(out);
+    sendFrame(frame, out.length(), PACE_CRITICAL, now);
+    sendText(frame + body, bodyEnd - body);
+}
+
+void ProcessingCore::triggerCapture(Worker& worker, const ProcessingChannel& channel, const AlarmEvent_t& alarm){
+    if (_capture == nullptr) return;
+    CaptureTrigger_t info;
+    info.alarmCode = alarm.code;
+    info.type = channel.type();
+    info.frequencyHz = alarm.frequencyHz;
+    info.value = alarm.value;
+    info.limit = alarm.limit;
+
+    LockScope locked(_sinkLock);
+    PerfScope timed(worker.stages[STAGE_CAPTURE]);
+    if (_capture->trigger(channel.slot(), info, millis())) {
+        Serial.printf("Capture %u: slot %d, %s\n", _capture->lastCaptureId(), channel.slot(), alarmText(alarm.code));
+    }
+}
+
+void ProcessingCore::publishFeatures(const ProcessingChannel& channel){
+    if ((_ws.count() == 0 && _sseCount == 0) || heapLow()) return;
+
+    const FeatureVector_t& f = channel.features();
+    uint32_t now = millis();
+    char frame[352];
+    TextWriter out(frame, sizeof(frame));
+    size_t body = SseFrame::open(out, "features", now);
+    out.text("{\"type\":\"").text(channel.typeName()).text("\",\"slot\":").integer(channel.slot())
+       .text(",\"rms\":").fixed(f.rms, 3).text(",\"peak\":").fixed(f.peak, 3)
+       .text(",\"crest\":").fixed(f.crestFactor, 2).text(",\"kurt\":").fixed(f.kurtosis, 2)
+       .text(",\"hz\":").fixed(f.peakHz, 1).text(",\"mag\":").fixed(f.peakMagnitude, 2).text(",\"bands\":[");
+    for (int i = 0; i < f.bandCount; i++) {
+        if (i) out.put(',');
+        out.fixed(f.bandEnergy[i], 2);
+    }
+    out.text("]}");
+    size_t bodyEnd = out.length();
+    SseFrame::close(out);
+    if (out.overflowed()) {
+        _jsonOverflows++;
+        return;
+    }
+
+    if (_sseCount > 0) sendFrame(frame, out.length(), PACE_FEATURES, now);
+    if (_ws.count() > 0) sendText(frame + body, bodyEnd - body);
+}
+
+void ProcessingCore::publishCorrelation(const CorrelationSummary_t& c){
+    if ((_ws.count() == 0 && _sseCount == 0) || heapLow()) return;
+
+    uint32_t now = millis();
+    char frame[320];
+    TextWriter out(frame, sizeof(frame));
+    size_t body = SseFrame::open(out, "correlation", now);
+    out.text("{\"type\":\"corr\",\"cur\":").integer(_correlated[0]->slot()).text(",\"vib\":").integer(_correlated[1]->slot())
+       .text(",\"frames\":").uinteger(c.frames).text(",\"coherent\":").fixed(c.coherentPower, 3)
+       .text(",\"hz\":").fixed(c.peakHz, 2).text(",\"coh\":").fixed(c.peakCoherence, 3).text(",\"phase\":").fixed(c.peakPhaseDeg, 1)
+       .text(",\"running\":").fixed(c.runningHz, 2).text(",\"skewUs\":").integer(c.skewUs)
+       .text(",\"verdict\":\"").text(correlationVerdictName((CorrelationVerdict)c.verdict)).text("\"}");
+    size_t bodyEnd = out.length();
+    SseFrame::close(out);
+    if (out.overflowed()) {
+        _jsonOverflows++;
+        return;
+    }
+
+    if (_sseCount > 0) sendFrame(frame, out.length(), PACE_FEATURES, now);
+    if (_ws.count() > 0) sendText(frame + body, bodyEnd - body);
+}
+
+void ProcessingCore::publishStatus(const ProcessingChannel& channel){
+    static const char* states[] = { "uncalibrated", "learning", "monitoring" };
+    uint32_t now = millis();
+    char frame[128];
+    TextWriter out(frame, sizeof(frame));
+    size_t body = SseFrame::open(out, "status", now);
+    out.text("{\"type\":\"").text(channel.typeName()).text("\",\"slot\":").integer(channel.slot())
+       .text(",\"state\":\"").text(states[channel.detector().state()])
+       .text("\",\"progress\":").integer(channel.detector().learningPercent()).put('}');
+    size_t bodyEnd = out.length();
+    SseFrame::close(out);
+    sendFrame(frame, out.length(), PACE_CRITICAL, now);
+    sendText(frame + body, bodyEnd - body);
+}
+
+// --- SSE viewers ---
+// AsyncEventSource has no per-client send queue limit (32 messages) or disconnect callback, so
+// each client is tracked here with its own pacer. The library's disconnect handler is replaced
+// by one that frees the slot first and then runs the library's cleanup.
+void ProcessingCore::addSseClient(AsyncEventSourceClient* client){
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    SseClient* slot = nullptr;
+    for (int i = 0; i < MAX_SSE_CLIENTS && slot == nullptr; i++) {
+        if (_sse[i].client == nullptr) slot = &_sse[i];
+    }
+    if (slot == nullptr) {
+        _sseRejected++;
+        client->send("Too many viewers", "busy", millis(), 60000);
+        xSemaphoreGiveRecursive(_sseLock);
+        return;
+    }
+
+    uint32_t now = millis();
+    slot->core = this;
+    slot->pacer.reset(now);
+    slot->staleChannels = 0xFFFFFFFF;		// First spectrum of every channel as soon as it fits
+    slot->client = client;
+    _sseCount++;
+    client->client()->onDisconnect([](void* arg, AsyncClient* c){
+        SseClient* s = (SseClient*)arg;
+        s->core->removeSseClient(s);
+        delete c;
+    }, slot);
+
+    client->send("Connected", NULL, now, 1000);
+    slot->pacer.sent(eventBytes(9, NULL), now);
+    xSemaphoreGiveRecursive(_sseLock);
+}
+
+void ProcessingCore::removeSseClient(SseClient* slot){
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    AsyncEventSourceClient* client = slot->client;
+    if (client != nullptr) {
+        slot->client = nullptr;
+        _sseCount--;
+        client->_onDisconnect();		// Library cleanup, deletes the client
+    }
+    xSemaphoreGiveRecursive(_sseLock);
+}
+
+// Viewers that should get this channel's spectrum now (bit per SSE slot)
+uint32_t ProcessingCore::spectrumTargets(uint32_t channelBit, bool due){
+    uint32_t now = millis(), targets = 0;
+    bool low = heapLow();
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        SseClient& c = _sse[i];
+        if (c.client == nullptr || !(due || (c.staleChannels & channelBit))) continue;
+        c.pacer.observe(c.client->packetsWaiting(), now);
+        if (c.pacer.admit(PACE_SPECTRUM, _updateBytes, low)) {
+            targets |= 1u << i;
+        } else {
+            if (due) c.pacer.drop(PACE_SPECTRUM);
+            c.staleChannels |= channelBit;
+        }
+    }
+    xSemaphoreGiveRecursive(_sseLock);
+    return targets;
+}
+
+// Queues a finished SSE frame (see SseFrame) for each viewer in targets whose pacer admits it.
+// write() copies the bytes as they are; send() would rebuild the frame as a String per viewer.
+// Returns the refused ones.
+uint32_t ProcessingCore::sendFrame(const char* frame, size_t len, PaceClass cls, uint32_t now, uint32_t targets){
+    uint32_t refused = 0;
+    bool low = heapLow();
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        SseClient& c = _sse[i];
+        if (c.client == nullptr || !(targets & (1u << i))) continue;
+        c.pacer.observe(c.client->packetsWaiting(), now);
+        if (c.pacer.admit(cls, len, low)) {
+            c.client->write(frame, len);
+            c.pacer.sent(len, now);
+        } else {
+            c.pacer.drop(cls);
+            refused |= 1u << i;
+        }
+    }
+    xSemaphoreGiveRecursive(_sseLock);
+    return refused;
+}
+
+// Disconnects viewers that stopped draining, and the worst one when the heap runs out
+void ProcessingCore::servicePacing(){
+    if (_sseCount == 0) return;
+    uint32_t now = millis();
+    bool critical = ESP.getFreeHeap() < HEAP_CRITICAL_BYTES;
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    SseClient* worst = nullptr;
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        SseClient& c = _sse[i];
+        if (c.client == nullptr) continue;
+        c.pacer.observe(c.client->packetsWaiting(), now);
+        if (c.pacer.stalled(now)) {
+            _sseStallClosed++;
+            c.client->close();			// Runs removeSseClient() before returning
+            continue;
+        }
+        if (critical && c.pacer.queuedBytes() > 0 && (worst == nullptr || c.pacer.queuedBytes() > worst->pacer.queuedBytes())) worst = &c;
+    }
+    if (worst != nullptr) {
+        _sseHeapClosed++;
+        Serial.printf("Heap low (%u bytes): closing SSE viewer with %u bytes queued\n", ESP.getFreeHeap(), worst->pacer.queuedBytes());
+        worst->client->close();
+    }
+    xSemaphoreGiveRecursive(_sseLock);
+}
+
+uint32_t ProcessingCore::channelBit(const ProcessingChannel& channel) const {
+    for (int i = 0; i < _channelCount; i++) {
+        if (_channels[i] == &channel) return 1u << i;
+    }
+    return 0;
+}
+
+// Requests that change channel state the workers use
+bool ProcessingCore::requestsPending() const {
+    return _spectrumRequested || _averageResetRequested || _analysisRequested || _runningHzRequested > 0
+           || _learnRequested || _simulateRequested >= 0 || _pairRequested;
+}
+
+void ProcessingCore::serviceRequests(Worker& worker){
+    // Manual capture, attributed to the first channel; erase ahead while idle
+    if (_capture != nullptr) {
+        if (_captureRequested && _channelCount > 0) {
+            _captureRequested = false;
+            AlarmEvent_t manual;
+            memset(&manual, 0, sizeof(manual));
+            triggerCapture(worker, *_channels[0], manual);
+        }
+        LockScope locked(_sinkLock);
+        _capture->maintain();
+    }
+
+    // The rest touches every channel: ProcTask takes all sensors while it applies it
+    if (!requestsPending()) return;
+    _scheduler->pause();
+
+    if (_pairRequested) {
+        _pairRequested = false;
+        pairChannels();
+    }
+
+    // Every channel sends its next spectrum regardless of the throttle
+    if (_spectrumRequested) {
+        _spectrumRequested = false;
+        for (int i = 0; i < _channelCount; i++) _channels[i]->requestPublish();
+    }
+
+    if (_averageResetRequested) {
+        _averageResetRequested = false;
+        LockScope locked(_averageLock);
+        for (int i = 0; i < _channelCount; i++) {
+            _channels[i]->averager().configure(_averageAlpha, _averageFrames);
+            _channels[i]->averager().reset();
+        }
+    }
+
+    if (_analysisRequested) {
+        const AnalysisRequest& r = _analysisRequest;
+        DspPipeline& pipeline = r.channel->pipeline();
+        xSemaphoreTake(_analysisLock, portMAX_DELAY);
+        int index = -1;
+        if (r.clear) pipeline.clearAnalyses();
+        else if (r.zoomHz > 0) index = pipeline.addZoomAnalysis(r.zoomHz, r.points, r.decimation, r.hopSize);
+        else index = pipeline.addFftAnalysis(r.points, r.hopSize);
+        xSemaphoreGive(_analysisLock);
+        if (!r.clear) Serial.printf("Analysis %d on slot %d %s: %s\n", index, r.channel->slot(), r.channel->typeName(), (index < 0) ? "rejected" : "added");
+        _analysisRequested = false;
+    }
+
+    float runningHz = _runningHzRequested;
+    if (runningHz > 0) {
+        _runningHzRequested = 0;
+        for (int i = 0; i < _channelCount; i++) _channels[i]->extractor().setHarmonicBands(runningHz, RUNNING_HARMONICS);
+        if (_correlation != nullptr) _correlation->setRunningHz(runningHz);
+    }
+    if (_learnRequested) {
+        _learnRequested = false;
+        for (int i = 0; i < _channelCount; i++) {
+            {
+                LockScope locked(_detectorLock);
+                _channels[i]->detector().startLearning(LEARN_FRAMES);
+            }
+            publishStatus(*_channels[i]);
+        }
+    }
+    int fault = _simulateRequested;
+    if (fault >= 0) {
+        _simulateRequested = -1;
+        AlarmEvent_t alarm;
+        for (int i = 0; i < _channelCount; i++) {
+            bool raised;
+            {
+                LockScope locked(_detectorLock);
+                raised = _channels[i]->detector().simulate((SimulatedFault)fault, &alarm);
+            }
+            if (raised) publishAlarm(*_channels[i], alarm);
+        }
+    }
+    _scheduler->resume();
+}
+
+// Channel picked by ?type=vib|cur[&slot=N] (first match if no slot), nullptr if none
+ProcessingChannel* ProcessingCore::requestedChannel(AsyncWebServerRequest* request){
+    String type = request->hasParam("type") ? request->getParam("type")->value() : "vib";
+    int slot = request->hasParam("slot") ? request->getParam("slot")->value().toInt() : -1;
+
+    for (int i = 0; i < _channelCount; i++) {
+        if (_channels[i]->retired()) continue;
+        if (type == _channels[i]->typeName() && (slot < 0 || slot == _channels[i]->slot())) return _channels[i];
+    }
+    return nullptr;
+}
+
+// Learned limits for the dashboard overlays: /model?type=vib[&slot=0]
+void ProcessingCore::sendModel(AsyncWebServerRequest* request){
+    const ProcessingChannel* channel = requestedChannel(request);
+    if (channel == nullptr) {
+        request->send(404, "text/plain", "Not calibrated");
+        return;
+    }
+
+    // The workers learn and check under _detectorLock: copy the limits of one model, then serialize the copy
+    const AnomalyDetector& detector = channel->detector();
+    const int bins = detector.bins();
+    std::unique_ptr<float[]> limits(new float[bins]);
+    float upper, lower;
+    bool calibrated;
+    {
+        LockScope locked(_detectorLock);
+        calibrated = detector.state() == AnomalyDetector::STATE_MONITORING;
+        upper = detector.upperLimit();
+        lower = detector.lowerLimit();
+        for (int i = 0; calibrated && i < bins; i++) limits[i] = detector.binLimit(i);
+    }
+    if (!calibrated) {
+        request->send(404, "text/plain", "Not calibrated");
+        return;
+    }
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->printf("{\"type\":\"%s\",\"slot\":%d,\"upper\":%.2f,\"lower\":%.2f,\"limits\":[", channel->typeName(), channel->slot(), upper, lower);
+    char chunk[RESPONSE_CHUNK_BYTES];
+    TextWriter out(chunk, sizeof(chunk), toResponse, response);
+    for (int i = 0; i < bins; i++) {
+        out.fixed(limits[i], 2).text((i < bins - 1) ? "," : "]}");
+    }
+    out.flush();
+    request->send(response);
+}
+
+// Averaged spectrum: /average?type=vib[&slot=0]&mode=exp|lin|peak
+void ProcessingCore::sendAverage(AsyncWebServerRequest* request){
+    const ProcessingChannel* channel = requestedChannel(request);
+    if (channel == nullptr) {
+        request->send(404, "text/plain", "No such channel");
+        return;
+    }
+    String modeName = request->hasParam("mode") ? request->getParam("mode")->value() : "exp";
+    int mode = 0;
+    while (mode < AVG_MODE_COUNT && !(modeName == averageModeName((AverageMode)mode))) mode++;
+    if (mode == AVG_MODE_COUNT) {
+        request->send(400, "text/plain", "mode=exp|lin|peak");
+        return;
+    }
+
+    // The workers update the averages under _averageLock: copy this one, then serialize the copy
+    const SpectrumAverager& averager = channel->averager();
+    const int bins = averager.bins();
+    std::unique_ptr<float[]> spectrum(new float[bins]);
+    uint32_t frames;
+    bool complete;
+    {
+        LockScope locked(_averageLock);
+        memcpy(spectrum.get(), averager.spectrum((AverageMode)mode), sizeof(float) * bins);
+        frames = averager.frames((AverageMode)mode);
+        complete = mode != AVG_LINEAR || averager.linearComplete();
+    }
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->printf("{\"type\":\"%s\",\"slot\":%d,\"mode\":\"%s\",\"frames\":%u,\"complete\":%s,\"fft\":[",
+                     channel->typeName(), channel->slot(), modeName.c_str(), frames, complete ? "true" : "false");
+    char chunk[RESPONSE_CHUNK_BYTES];
+    TextWriter out(chunk, sizeof(chunk), toResponse, response);
+    for (int i = 0; i < bins; i++) {
+        out.fixed(spectrum[i], 2).text((i < bins - 1) ? "," : "]}");
+    }
+    out.flush();
+    request->send(response);
+}
+
+// /analysis/add?type=cur[&slot=0]&fft=4096[&hop=1024]
+// /analysis/add?type=cur[&slot=0]&zoom=50[&points=256][&decimation=16][&hop=64]
+// /analysis/clear?type=cur[&slot=0]
+void ProcessingCore::requestAnalysis(AsyncWebServerRequest* request, bool clear){
+    ProcessingChannel* channel = requestedChannel(request);
+    if (channel == nullptr) {
+        request->send(404, "text/plain", "No such channel");
+        return;
+    }
+    if (_analysisRequested) {
+        request->send(503, "text/plain", "Busy");
+        return;
+    }
+
+    AnalysisRequest r;
+    r.channel = channel;
+    r.clear = clear;
+    r.zoomHz = request->hasParam("zoom") ? request->getParam("zoom")->value().toFloat() : 0;
+    r.points = request->hasParam("fft") ? request->getParam("fft")->value().toInt() : 0;
+    if (r.zoomHz > 0) r.points = request->hasParam("points") ? request->getParam("points")->value().toInt() : LINE_ZOOM_POINTS;
+    r.decimation = request->hasParam("decimation") ? request->getParam("decimation")->value().toInt() : LINE_ZOOM_DECIMATION;
+    r.hopSize = request->hasParam("hop") ? request->getParam("hop")->value().toInt() : 0;
+
+    // Size checks here, the pipeline checks the rest (powers of two, band inside Nyquist)
+    if (!clear && (r.points <= 0 || r.points > MAX_ANALYSIS_POINTS || r.decimation < 2 || r.decimation > MAX_ZOOM_DECIMATION)) {
+        request->send(400, "text/plain", "fft=<points> | zoom=<hz>[&points=][&decimation=], points <= 4096, decimation 2..64");
+        return;
+    }
+    _analysisRequest = r;
+    _analysisRequested = true;
+    request->send(202, "text/plain", clear ? "Analyses cleared" : "Analysis requested");
+}
+
+// /analysis?type=cur[&slot=0] lists the channel's analyses, &index=N returns one spectrum
+void ProcessingCore::sendAnalysis(AsyncWebServerRequest* request){
+    const ProcessingChannel* channel = requestedChannel(request);
+    if (channel == nullptr) {
+        request->send(404, "text/plain", "No such channel");
+        return;
+    }
+    const DspPipeline& pipeline = channel->pipeline();
+    int index = request->hasParam("index") ? request->getParam("index")->value().toInt() : -1;
+
+    xSemaphoreTake(_analysisLock, portMAX_DELAY);
+    if (index >= pipeline.analysisCount()) {
+        xSemaphoreGive(_analysisLock);
+        request->send(404, "text/plain", "No such analysis");
+        return;
+    }
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    response->printf("{\"type\":\"%s\",\"slot\":%d,", channel->typeName(), channel->slot());
+    if (index < 0) {
+        response->print("\"analyses\":[");
+        for (int i = 0; i < pipeline.analysisCount(); i++) {
+            const SpectrumAnalysis& a = pipeline.analysis(i);
+            response->printf("%s{\"index\":%d,\"kind\":\"%s\",\"bins\":%d,\"start\":%.3f,\"binHz\":%.4f,\"frames\":%u}",
+                             i ? "," : "", i, a.kindName(), a.bins(), a.startHz(), a.binHz(), a.frames());
+        }
+        response->print("]}");
+    } else {
+        const SpectrumAnalysis& a = pipeline.analysis(index);
+        const float* spectrum = a.spectrum();
+        response->printf("\"index\":%d,\"kind\":\"%s\",\"start\":%.3f,\"binHz\":%.4f,\"frames\":%u,\"fft\":[",
+                         index, a.kindName(), a.startHz(), a.binHz(), a.frames());
+        char chunk[RESPONSE_CHUNK_BYTES];
+        TextWriter out(chunk, sizeof(chunk), toResponse, response);
+        for (int i = 0; i < a.bins(); i++) {
+            out.fixed(spectrum[i], 2).text((i < a.bins() - 1) ? "," : "]}");
+        }
+        out.flush();
+    }
+    xSemaphoreGive(_analysisLock);
+    request->send(response);
+}
+
+// Coherence / phase per bin and the order spectrum of the current-vibration pair:
+// /correlation[?bins=0] (bins=0: summary only)
+void ProcessingCore::sendCorrelation(AsyncWebServerRequest* request){
+    const CorrelationEngine* engine = _correlation;
+    if (engine == nullptr) {
+        request->send(404, "text/plain", "No current / vibration pair at the same sample rate");
+        return;
+    }
+    bool bins = !request->hasParam("bins") || request->getParam("bins")->value().toInt() != 0;
+
+    // The workers update the engine under _correlationLock: copy one frame's worth, then serialize the copy
+    const int count = engine->bins();
+    std::unique_ptr<float[]> copy(bins ? new float[2 * count + CORR_ORDER_BINS] : nullptr);
+    float* coherence = copy.get();
+    float* phase = coherence + count;
+    float* orders = phase + count;
+    CorrelationSummary_t c;
+    uint32_t skipped, gaps;
+    float binHz = engine->binHz();
+    {
+        LockScope locked(_correlationLock);
+        c = engine->summary();
+        skipped = engine->skipped();
+        gaps = engine->gaps();
+        if (bins) {
+            for (int i = 0; i < count; i++) {
+                coherence[i] = engine->coherence(i);
+                phase[i] = engine->phaseDeg(i);
+            }
+            for (int i = 0; i < CORR_ORDER_BINS; i++) orders[i] = engine->orderMagnitude(i);
+        }
+    }
+
+    AsyncResponseStream* response = request->beginResponseStream("application/json");
+    char chunk[RESPONSE_CHUNK_BYTES];
+    TextWriter out(chunk, sizeof(chunk), toResponse, response);
+    out.text("{\"cur\":").integer(_correlated[0]->slot()).text(",\"vib\":").integer(_correlated[1]->slot())
+       .text(",\"frames\":").uinteger(c.frames).text(",\"skipped\":").uinteger(skipped).text(",\"gaps\":").uinteger(gaps)
+       .text(",\"coherent\":").fixed(c.coherentPower, 3).text(",\"hz\":").fixed(c.peakHz, 2).text(",\"coh\":").fixed(c.peakCoherence, 3)
+       .text(",\"phase\":").fixed(c.peakPhaseDeg, 1).text(",\"running\":").fixed(c.runningHz, 2).text(",\"skewUs\":").integer(c.skewUs)
+       .text(",\"verdict\":\"").text(correlationVerdictName((CorrelationVerdict)c.verdict)).put('"');
+    if (bins) {
+        out.text(",\"binHz\":").fixed(binHz, 4).text(",\"coherence\":[");
+        for (int i = 0; i < count; i++) out.fixed(coherence[i], 3).text((i < count - 1) ? "," : "]");
+        out.text(",\"phaseDeg\":[");
+        for (int i = 0; i < count; i++) out.fixed(phase[i], 1).text((i < count - 1) ? "," : "]");
+        out.text(",\"orderStep\":").fixed(1.0f / CORR_ORDER_RESOLUTION, 3).text(",\"orders\":[");
+        for (int i = 0; i < CORR_ORDER_BINS; i++) out.fixed(orders[i], 2).text((i < CORR_ORDER_BINS - 1) ? "," : "]");
+    }
+    out.put('}');
+    out.flush();
+    request->send(response);
+}
+
+// A /capture download in progress: the log's sector order when it started
+struct CaptureDownload {
+    CaptureLog*	capture;
+    SemaphoreHandle_t lock;
+    int			count = 0;
+    uint16_t*	sectors;
+    uint32_t*	sequences;
+
+    CaptureDownload(CaptureLog* log, SemaphoreHandle_t sinkLock)
+        : capture(log), lock(sinkLock), sectors(new uint16_t[log->sectorCount()]), sequences(new uint32_t[log->sectorCount()]) {}
+    ~CaptureDownload() { delete[] sectors; delete[] sequences; }
+};
+
+// Whole capture log, oldest sector first, streamed from flash a chunk at a time (see tools/CaptureDump.cpp)
+void ProcessingCore::sendCapture(AsyncWebServerRequest* request){
+    if (_capture == nullptr || !_capture->ready()) {
+        request->send(503, "text/plain", "Capture log unavailable");
+        return;
+    }
+    // The workers keep appending and erasing: fix the sector order now, read each chunk under their lock
+    std::shared_ptr<CaptureDownload> download(new CaptureDownload(_capture, _sinkLock));
+    {
+        LockScope locked(_sinkLock);
+        download->count = _capture->snapshot(download->sectors, download->sequences, _capture->sectorCount());
+    }
+    AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream", [download](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        LockScope locked(download->lock);
+        return download->capture->readSnapshot(download->sectors, download->sequences, download->count, index, buffer, maxLen);
+    });
+    response->addHeader("Content-Disposition", "attachment; filename=capture.bin");
+    request->send(response);
+}
+
+void ProcessingCore::processingWorker(Worker& worker){
+    uint8_t index;
+
+    for(;;) {
+        // Sleep until the hub hands over a batch. The timeout only keeps housekeeping going when idle.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(HOUSEKEEPING_INTERVAL));
+        uint32_t awake = Perf::cycles();
+
+        // One batch per claim: the scheduler goes round the sensors so none can hog the core,
+        // and holds each sensor for one worker at a time so its batches stay in order
+        int lane;
+        while ((lane = _scheduler->claim(worker.index)) >= 0) {
+            if (_rings[lane].pop(index)) handleBatch(worker, index);
+            _scheduler->release(lane);
+        }
+
+        if (worker.index == 0) {
+            // Learning / simulation requests from the web server
+            serviceRequests(worker);
+
+            // Slow or dead SSE viewers
+            servicePacing();
+
+            // Gateway connection and its HELLO
+            if (_uplink != nullptr) {
+                LockScope locked(_sinkLock);
+                _uplink->service(millis());
+            }
+
+            // Drop WebSocket clients that went away
+            xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+            _ws.cleanupClients();
+            xSemaphoreGiveRecursive(_sseLock);
+        }
+
+        worker.busyCycles += Perf::cycles() - awake;
+    }
+}
+
+// Prometheus text format, e.g. scrape http://192.168.4.1/metrics
+// Counters are read while the other tasks update them, so a scrape is a close, not atomic, snapshot.
+void ProcessingCore::sendMetrics(AsyncWebServerRequest* request){
+    const double cyclesPerSecond = 1e6 * Perf::cyclesPerUs();
+    AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+
+    // --- Stage timings, summed over the DSP workers ---
+    static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == STAGE_COUNT, "one name per stage");
+    PerfStage totals[STAGE_COUNT];
+    for (int w = 0; w < DSP_WORKERS; w++) {
+        for (int i = 0; i < STAGE_COUNT; i++) {
+            const PerfStage& s = _workers[w].stages[i];
+            totals[i].count += s.count;
+            totals[i].totalCycles += s.totalCycles;
+            if (s.maxCycles > totals[i].maxCycles) totals[i].maxCycles = s.maxCycles;
+        }
+    }
+    struct { const char* name; const PerfStage* stage; } stages[STAGE_COUNT + 2];
+    for (int i = 0; i < STAGE_COUNT; i++) stages[i] = { STAGE_NAMES[i], &totals[i] };
+    stages[STAGE_COUNT] = { "parse", _hub ? &_hub->parseStage() : nullptr };
+    stages[STAGE_COUNT + 1] = { "enqueue", _hub ? &_hub->enqueueStage() : nullptr };
+    const int stageCount = STAGE_COUNT + 2;
+
+    response->print("# HELP pnb_stage_seconds Time spent per pipeline stage.\n# TYPE pnb_stage_seconds summary\n");
+    for (int i = 0; i < stageCount; i++) {
+        if (stages[i].stage == nullptr) continue;
+        response->printf("pnb_stage_seconds_sum{stage=\"%s\"} %.6f\n", stages[i].name, stages[i].stage->totalCycles / cyclesPerSecond);
+        response->printf("pnb_stage_seconds_count{stage=\"%s\"} %u\n", stages[i].name, stages[i].stage->count);
+    }
+    response->print("# HELP pnb_stage_max_seconds Slowest single run per stage.\n# TYPE pnb_stage_max_seconds gauge\n");
+    for (int i = 0; i < stageCount; i++) {
+        if (stages[i].stage == nullptr) continue;
+        response->printf("pnb_stage_max_seconds{stage=\"%s\"} %.6f\n", stages[i].name, stages[i].stage->maxCycles / cyclesPerSecond);
+    }
+
+    // --- Core load ---
+    response->print("# HELP pnb_uptime_seconds Time since boot.\n# TYPE pnb_uptime_seconds gauge\n");
+    response->printf("pnb_uptime_seconds %.3f\n", millis() / 1000.0);
+    response->print("# HELP pnb_processing_busy_seconds_total Time each DSP worker spent awake (ProcTask on core 1, the others on core 0).\n# TYPE pnb_processing_busy_seconds_total counter\n");
+    for (int w = 0; w < DSP_WORKERS; w++) response->printf("pnb_processing_busy_seconds_total{task=\"%s\"} %.6f\n", _workers[w].name, _workers[w].busyCycles / cyclesPerSecond);
+    response->print("# HELP pnb_worker_batches_total Batches handled per DSP worker.\n# TYPE pnb_worker_batches_total counter\n");
+    for (int w = 0; w < DSP_WORKERS; w++) response->printf("pnb_worker_batches_total{task=\"%s\"} %u\n", _workers[w].name, _workers[w].batches);
+    response->print("# HELP pnb_worker_steals_total Batches a DSP worker took over from another worker's sensors.\n# TYPE pnb_worker_steals_total counter\n");
+    for (int w = 0; w < DSP_WORKERS; w++) response->printf("pnb_worker_steals_total{task=\"%s\"} %u\n", _workers[w].name, _scheduler->steals(w));
+    response->print("# HELP pnb_scheduler_pauses_total Times the DSP workers were paused for a dashboard request.\n# TYPE pnb_scheduler_pauses_total counter\n");
+    response->printf("pnb_scheduler_pauses_total %u\n", _scheduler->pauses());
+
+    // --- Hub -> DSP handoff, per sensor slot ---
+    response->print("# HELP pnb_ring_pushed_total Batches handed to the processing core.\n# TYPE pnb_ring_pushed_total counter\n");
+    for (int i = 0; i < _ringCount; i++) response->printf("pnb_ring_pushed_total{slot=\"%d\"} %u\n", i, _rings[i].pushed());
+    response->print("# HELP pnb_ring_dropped_total Batches dropped because the processing core was behind.\n# TYPE pnb_ring_dropped_total counter\n");
+    for (int i = 0; i < _ringCount; i++) response->printf("pnb_ring_dropped_total{slot=\"%d\"} %u\n", i, _rings[i].dropped());
+    response->print("# HELP pnb_ring_high_water Deepest each ring has been.\n# TYPE pnb_ring_high_water gauge\n");
+    for (int i = 0; i < _ringCount; i++) response->printf("pnb_ring_high_water{slot=\"%d\"} %u\n", i, _rings[i].highWater());
+    response->print("# HELP pnb_pool_exhausted_total Packets dropped because no batch slot was free.\n# TYPE pnb_pool_exhausted_total counter\n");
+    response->printf("pnb_pool_exhausted_total %u\n", _pool->exhausted());
+
+    // --- Per-client stream counters ---
+    if (_hub != nullptr) {
+        struct { const char* name; const char* help; } counters[] = {
+            { "pnb_client_bytes_total", "Bytes read from the sensor socket." },
+            { "pnb_client_packets_total", "Packets parsed." },
+            { "pnb_client_skipped_packets_total", "Packets parsed but discarded." },
+            { "pnb_client_dropped_bytes_total", "Bytes discarded while resyncing." },
+            { "pnb_client_resyncs_total", "Times the stream lost sync." },
+            { "pnb_client_decode_errors_total", "Payloads that failed to decode." },
+            { "pnb_client_lost_packets_total", "v2 sequence gaps." },
+            { "pnb_client_reordered_total", "v2 packets older than the previous one." }
+        };
+        const int counterCount = sizeof(counters) / sizeof(counters[0]);
+        for (int c = 0; c < counterCount; c++) {
+            response->printf("# HELP %s %s\n# TYPE %s counter\n", counters[c].name, counters[c].help, counters[c].name);
+            for (int i = 0; i < _hub->maxClients(); i++) {
+                const PacketParser& parser = _hub->parser(i);
+                uint32_t values[] = { _hub->bytesReceived(i), parser.packets(), parser.skippedPackets(), parser.droppedBytes(),
+                                      parser.resyncs(), parser.decodeErrors(), parser.lostPackets(), parser.reordered() };
+                response->printf("%s{slot=\"%d\"} %u\n", counters[c].name, i, values[c]);
+            }
+        }
+    }
+
+    // --- Post-mortem capture ---
+    if (_capture != nullptr) {
+        response->print("# HELP pnb_captures_total Captures written since boot.\n# TYPE pnb_captures_total counter\n");
+        response->printf("pnb_captures_total %u\n", _capture->captures());
+        response->print("# HELP pnb_capture_write_errors_total Failed flash erases or writes.\n# TYPE pnb_capture_write_errors_total counter\n");
+        response->printf("pnb_capture_write_errors_total %u\n", _capture->writeErrors());
+        response->print("# HELP pnb_capture_log_bytes Size of the /capture download.\n# TYPE pnb_capture_log_bytes gauge\n");
+        response->printf("pnb_capture_log_bytes %u\n", _capture->logicalSize());
+    }
+
+    // --- Memory / tasks ---
+    response->print("# HELP pnb_task_stack_free_bytes Lowest free stack seen per task.\n# TYPE pnb_task_stack_free_bytes gauge\n");
+    for (int w = 0; w < DSP_WORKERS; w++) {
+        response->printf("pnb_task_stack_free_bytes{task=\"%s\"} %u\n", _workers[w].name, (unsigned)uxTaskGetStackHighWaterMark(_workerTasks[w]));
+    }
+    if (_hub != nullptr && _hub->taskHandle() != NULL) {
+        response->printf("pnb_task_stack_free_bytes{task=\"ConnTask\"} %u\n", (unsigned)uxTaskGetStackHighWaterMark(_hub->taskHandle()));
+    }
+    response->print("# HELP pnb_heap_free_bytes Free heap.\n# TYPE pnb_heap_free_bytes gauge\n");
+    response->printf("pnb_heap_free_bytes %u\n", ESP.getFreeHeap());
+    response->print("# HELP pnb_heap_min_free_bytes Lowest free heap since boot.\n# TYPE pnb_heap_min_free_bytes gauge\n");
+    response->printf("pnb_heap_min_free_bytes %u\n", ESP.getMinFreeHeap());
+    if (_arena != nullptr) {
+        response->print("# HELP pnb_arena_used_bytes Startup arena in use per region.\n# TYPE pnb_arena_used_bytes gauge\n");
+        for (int r = 0; r < MEM_REGION_COUNT; r++) response->printf("pnb_arena_used_bytes{region=\"%s\"} %u\n", memRegionName((MemRegion)r), (unsigned)_arena->used((MemRegion)r));
+        response->print("# HELP pnb_arena_size_bytes Startup arena size per region.\n# TYPE pnb_arena_size_bytes gauge\n");
+        for (int r = 0; r < MEM_REGION_COUNT; r++) response->printf("pnb_arena_size_bytes{region=\"%s\"} %u\n", memRegionName((MemRegion)r), (unsigned)_arena->capacity((MemRegion)r));
+        response->print("# HELP pnb_arena_fallback_bytes Buffers that did not fit the arena and went to the heap.\n# TYPE pnb_arena_fallback_bytes gauge\n");
+        response->printf("pnb_arena_fallback_bytes %u\n", (unsigned)_arena->fallbackBytes());
+    }
+    response->print("# HELP pnb_channel_dsp_bytes Memory held by each channel's window ring, FFT tables and spectrum.\n# TYPE pnb_channel_dsp_bytes gauge\n");
+    for (int i = 0; i < _channelCount; i++) {
+        const DspPipeline& pipeline = _channels[i]->pipeline();
+        response->printf("pnb_channel_dsp_bytes{slot=\"%d\",type=\"%s\",format=\"%s\"} %u\n", _channels[i]->slot(), _channels[i]->typeName(),
+                         (pipeline.format() == DSP_Q15) ? "q15" : "float", (unsigned)pipeline.memoryBytes());
+    }
+    const CorrelationEngine* engine = _correlation;
+    if (engine != nullptr) {
+        response->print("# HELP pnb_correlation_frames_total Current / vibration frames averaged.\n# TYPE pnb_correlation_frames_total counter\n");
+        response->printf("pnb_correlation_frames_total %u\n", engine->summary().frames);
+        response->print("# HELP pnb_correlation_skipped_total Frames skipped because the two streams were too far apart.\n# TYPE pnb_correlation_skipped_total counter\n");
+        response->printf("pnb_correlation_skipped_total %u\n", engine->skipped());
+        response->print("# HELP pnb_correlation_gaps_total Lost batches seen in the paired streams' timestamps.\n# TYPE pnb_correlation_gaps_total counter\n");
+        response->printf("pnb_correlation_gaps_total %u\n", engine->gaps());
+        response->print("# HELP pnb_correlation_coherent_ratio Share of the vibration power explained by the current.\n# TYPE pnb_correlation_coherent_ratio gauge\n");
+        response->printf("pnb_correlation_coherent_ratio %.3f\n", engine->summary().coherentPower);
+    }
+
+    // --- Gateway uplink ---
+    if (_uplink != nullptr) {
+        response->print("# HELP pnb_uplink_connected Connected to the gateway.\n# TYPE pnb_uplink_connected gauge\n");
+        response->printf("pnb_uplink_connected %d\n", _uplink->connected() ? 1 : 0);
+        response->print("# HELP pnb_uplink_connects_total Gateway connections made.\n# TYPE pnb_uplink_connects_total counter\n");
+        response->printf("pnb_uplink_connects_total %u\n", _uplink->connects());
+        response->print("# HELP pnb_uplink_frames_total Frames queued for the gateway.\n# TYPE pnb_uplink_frames_total counter\n");
+        for (int k = UPLINK_HELLO; k < UPLINK_KIND_COUNT; k++) {
+            response->printf("pnb_uplink_frames_total{kind=\"%s\"} %u\n", uplinkKindName((UplinkKind)k), _uplink->frames((UplinkKind)k));
+        }
+        response->print("# HELP pnb_uplink_dropped_total Frames dropped because the gateway connection was backed up.\n# TYPE pnb_uplink_dropped_total counter\n");
+        response->printf("pnb_uplink_dropped_total %u\n", _uplink->dropped());
+        response->print("# HELP pnb_uplink_bytes_total Bytes queued for the gateway.\n# TYPE pnb_uplink_bytes_total counter\n");
+        response->printf("pnb_uplink_bytes_total %u\n", _uplink->bytesSent());
+    }
+
+    // --- Dashboard streams ---
+    response->print("# HELP pnb_dashboard_clients Connected dashboard clients.\n# TYPE pnb_dashboard_clients gauge\n");
+    response->printf("pnb_dashboard_clients{transport=\"sse\"} %u\n", (unsigned)_sseCount);
+    response->printf("pnb_dashboard_clients{transport=\"ws\"} %u\n", (unsigned)_ws.count());
+    response->print("# HELP pnb_sse_queued_messages Average messages waiting per SSE client.\n# TYPE pnb_sse_queued_messages gauge\n");
+    response->printf("pnb_sse_queued_messages %u\n", (unsigned)_events.avgPacketsWaiting());
+    response->print("# HELP pnb_sse_rejected_total Viewers turned away (over MAX_SSE_CLIENTS).\n# TYPE pnb_sse_rejected_total counter\n");
+    response->printf("pnb_sse_rejected_total %u\n", _sseRejected);
+    response->print("# HELP pnb_json_overflow_total Dashboard events dropped for not fitting their serialization buffer.\n# TYPE pnb_json_overflow_total counter\n");
+    response->printf("pnb_json_overflow_total %u\n", (unsigned)_jsonOverflows.load());
+    response->print("# HELP pnb_sse_closed_total Viewers disconnected by the hub.\n# TYPE pnb_sse_closed_total counter\n");
+    response->printf("pnb_sse_closed_total{reason=\"stall\"} %u\n", _sseStallClosed);
+    response->printf("pnb_sse_closed_total{reason=\"heap\"} %u\n", _sseHeapClosed);
+
+    // --- Per SSE viewer (slot index), reset when a viewer reconnects ---
+    xSemaphoreTakeRecursive(_sseLock, portMAX_DELAY);
+    response->print("# HELP pnb_sse_client_queued_bytes Bytes waiting in the viewer's send queue.\n# TYPE pnb_sse_client_queued_bytes gauge\n");
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (_sse[i].client != nullptr) response->printf("pnb_sse_client_queued_bytes{client=\"%d\"} %u\n", i, _sse[i].pacer.queuedBytes());
+    }
+    response->print("# HELP pnb_sse_client_drain_bytes_per_second Measured drain rate.\n# TYPE pnb_sse_client_drain_bytes_per_second gauge\n");
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (_sse[i].client != nullptr) response->printf("pnb_sse_client_drain_bytes_per_second{client=\"%d\"} %.0f\n", i, _sse[i].pacer.drainRate());
+    }
+    response->print("# HELP pnb_sse_client_send_rate_bytes_per_second Send rate the viewer is paced at.\n# TYPE pnb_sse_client_send_rate_bytes_per_second gauge\n");
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (_sse[i].client != nullptr) response->printf("pnb_sse_client_send_rate_bytes_per_second{client=\"%d\"} %.0f\n", i, _sse[i].pacer.sendRate());
+    }
+    response->print("# HELP pnb_sse_client_dropped_total Messages skipped for the viewer (a newer one replaces them).\n# TYPE pnb_sse_client_dropped_total counter\n");
+    for (int i = 0; i < MAX_SSE_CLIENTS; i++) {
+        if (_sse[i].client == nullptr) continue;
+        for (int c = 0; c < PACE_CLASS_COUNT; c++) {
+            response->printf("pnb_sse_client_dropped_total{client=\"%d\",class=\"%s\"} %u\n", i, paceClassName((PaceClass)c), _sse[i].pacer.dropped((PaceClass)c));
+        }
+    }
+    xSemaphoreGiveRecursive(_sseLock);
+
+    request->send(response);
+}
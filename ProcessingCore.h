@@ -1,48 +1,216 @@
-#ifndef PROCESSING_CORE_H
-#define PROCESSING_CORE_H
-
-#include <Arduino.h>
-#include <WiFi.h>
-#include <AsyncTCP.h>
-#include <ESPAsyncWebServer.h>
-#include <arduinoFFT.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
-#include "esp_task_wdt.h"
-
-class ProcessingCore{
-	public:
-		ProcessingCore(int eventPort = 80, const char* eventPath = "/events", int batchSamples = 256, int aggregationFactor = 4);
-		void begin(QueueHandle_t vQ, QueueHandle_t cQ);
-	
-	private:
-		int			_aggregationFactor;
-		int			_batchSamples;
-		int			_fftPools;
-		
-		float*		_latestVibData;
-		float*		_latestCurData;
-		float*		_latestVibFft;
-		float*		_latestCurFft;
-		
-		const char*	_eventPath;
-		int			_eventPort;
-		
-		AsyncWebServer _webServer;
-		AsyncEventSource _events; 
-		
-        QueueHandle_t _vibQueue;
-        QueueHandle_t _curQueue;
-		
-		float*		_vReal;
-		float*		_vImag;
-		ArduinoFFT<float>* _FFT = nullptr; 
-		
-		int _vibCount = 0;
-		int _curCount = 0;
-		
-		void processingWorker();
-		static void taskWrapper(void* pvParameters);
-
-};
+#ifndef PROCESSING_CORE_H
+#define PROCESSING_CORE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_task_wdt.h"
+#include <atomic>
+#include "ProcessingChannel.h"
+#include "CorrelationEngine.h"
+#include "BatchPool.h"
+#include "SpectrumCodec.h"
+#include "TextWriter.h"
+#include "PerfCounters.h"
+#include "CaptureLog.h"
+#include "ClientPacer.h"
+#include "MemoryArena.h"
+#include "GatewayLink.h"
+#include "DspScheduler.h"
+
+// SSE dashboard viewers that get data (each paced on its own); more are told "busy"
+#define MAX_SSE_CLIENTS 4
+
+// Dashboard time trace keeps every 4th sample (1024 -> 256 points)
+#define TIME_STRIDE 4
+// Current channels zoom on the line frequency: 256 bins of 0.24 Hz (at 1 kHz) around 50 Hz
+#define LINE_ZOOM_POINTS 256
+#define LINE_ZOOM_DECIMATION 16
+// Full-spectrum SSE frame, JSON plus event framing (1024-point window: 512 bins + 256 time samples)
+#define PROC_JSON_BYTES 8192
+// Processing task stack, bytes. /metrics reports the lowest free stack (pnb_task_stack_free_bytes).
+#define PROC_TASK_STACK 16384
+
+// DSP workers: "ProcTask" on core 1 serves every sensor and does the housekeeping, the others
+// ("DspTask1" ..) run on core 0 below the hub (HUB_TASK_PRIORITY) and only take over queued batches.
+// Each worker has its own task stack and serializer buffers, and holds one BatchPool slot while it works (see POOL_SLOTS).
+#define DSP_WORKERS 2
+#define DSP_TASK_PRIORITY 1
+// Batches a sensor must have queued before a core 0 worker takes one (2: only once core 1 falls behind)
+#define DSP_HELPER_BACKLOG 1
+
+class CommunicationHub;
+
+class ProcessingCore{
+	public:
+		ProcessingCore(int eventPort = 80, const char* eventPath = "/events", int batchSamples = 256, int aggregationFactor = 4, int hopSize = 256, int maxChannels = 8);
+		void begin(BatchRing* rings, int ringCount, BatchPool* pool);
+		TaskHandle_t taskHandle() const { return _workerTasks[0]; }
+		// Per DSP worker, for the hub's wakeups
+		const TaskHandle_t* workerTasks() const { return _workerTasks; }
+		const DspScheduler* scheduler() const { return _scheduler; }
+		// Hub whose counters /metrics also reports (optional)
+		void setHub(CommunicationHub* hub) { _hub = hub; }
+		// Post-mortem capture on alarms (optional, set before begin)
+		void setCapture(CaptureLog* capture) { _capture = capture; }
+		// Arena new channels are built in (optional, set before begin). begin() itself allocates
+		// from whatever ArenaScope the caller has open.
+		void setArena(MemoryArena* arena) { _arena = arena; }
+		// Forward features / spectra / alarms (or raw batches) to a gateway (optional, set before begin)
+		void setUplink(GatewayLink* uplink) { _uplink = uplink; }
+
+		// MemoryArena budget of begin(): channel table, scheduler and task stacks (MEM_FAST), serializer buffers (MEM_BULK)
+		static constexpr size_t arenaFastBytes(int maxChannels){
+			return arenaRound(sizeof(ProcessingChannel*) * maxChannels) + arenaRound(sizeof(DspScheduler))
+			       + DSP_WORKERS * (arenaRound(PROC_TASK_STACK) + arenaRound(sizeof(StaticTask_t)));
+		}
+		static constexpr size_t arenaBulkBytes(int fftSize){
+			return DSP_WORKERS * (arenaRound(PROC_JSON_BYTES) + arenaRound(SpectrumCodec::frameSize(fftSize / 2, fftSize / TIME_STRIDE)));
+		}
+	
+	private:
+		int			_aggregationFactor;
+		int			_batchSamples;
+		int			_fftPools;
+		int			_hopSize;
+		
+		ProcessingChannel**	_channels;		// Created on the first batch of each (slot, type), never removed (only retired)
+		int			_maxChannels;
+		int			_channelCount = 0;		// Published with a release store after the entry is written
+		SemaphoreHandle_t _channelLock;		// Appends to the table (and the arena they allocate from)
+		
+		const char*	_eventPath;
+		int			_eventPort;
+		
+		AsyncWebServer _webServer;
+		AsyncEventSource _events; 
+		AsyncWebSocket	_ws;				// Binary spectrum frames (SpectrumCodec)
+		size_t		_frameCapacity;
+		MemoryArena* _arena = nullptr;
+
+		// --- SSE viewers: per-client queue limits and send rate instead of a broadcast ---
+		struct SseClient {
+			AsyncEventSourceClient*	client;		// nullptr = free slot
+			ProcessingCore*	core;
+			ClientPacer		pacer;
+			uint32_t		staleChannels;		// Bit per channel: a full spectrum was refused, send the next one
+		};
+		SseClient	_sse[MAX_SSE_CLIENTS];
+		volatile int _sseCount = 0;
+		SemaphoreHandle_t _sseLock;			// Recursive: closing a client runs its disconnect handler in the caller. Also held for WebSocket sends.
+		volatile size_t	_updateBytes;			// Last full-spectrum event, the size estimate for the next one
+		uint32_t	_sseRejected = 0;			// Viewers over MAX_SSE_CLIENTS
+		uint32_t	_sseStallClosed = 0;		// Closed after PACER_STALL_MS without draining
+		uint32_t	_sseHeapClosed = 0;			// Closed to free heap
+		
+        BatchRing*	_rings;			// One per hub client slot, BatchPool slot indices
+        int			_ringCount;
+        BatchPool*	_pool;
+        CommunicationHub* _hub = nullptr;
+        CaptureLog*	_capture = nullptr;
+        GatewayLink* _uplink = nullptr;
+        SemaphoreHandle_t _sinkLock;	// Capture log and uplink, shared by the workers
+
+		// Current vs vibration, paired once both channels exist (kept for good, like the channels).
+		// The two channels may be on different workers: their batches go through the engine under _correlationLock.
+		CorrelationEngine* volatile _correlation = nullptr;
+		volatile bool _pairRequested = false;	// New channel: ProcTask pairs while the workers are paused
+		ProcessingChannel* _correlated[2];	// Current, vibration
+		SemaphoreHandle_t _correlationLock;
+
+		// --- DSP workers ---
+		enum Stage {
+			STAGE_AGGREGATE,		// pushBatch without a new spectrum
+			STAGE_FFT,				// pushBatch that ran the FFT
+			STAGE_DETECT,
+			STAGE_FEATURES,
+			STAGE_AVERAGE,
+			STAGE_CAPTURE,			// CaptureLog work (RAM history copy, flash appends)
+			STAGE_CORRELATE,		// CorrelationEngine, per batch of either paired channel
+			STAGE_JSON,				// JSON serialization (TextWriter)
+			STAGE_BINARY,			// SpectrumCodec encode
+			STAGE_SSE,				// Queuing the SSE frame per viewer
+			STAGE_WS,				// AsyncWebSocket::binaryAll
+			STAGE_UPLINK,			// Gateway frames, encode + queue
+			STAGE_COUNT
+		};
+		struct Worker {
+			ProcessingCore*	core;
+			int			index;				// 0 = ProcTask (core 1)
+			char		name[12];
+			char*		jsonBuffer;
+			uint8_t*	frameBuffer;
+			PerfStage	stages[STAGE_COUNT];	// Written by this worker only (/metrics sums them)
+			uint64_t	busyCycles = 0;		// Time the task spent awake
+			uint32_t	batches = 0;
+		};
+		Worker		_workers[DSP_WORKERS];
+		TaskHandle_t _workerTasks[DSP_WORKERS] = {};
+		DspScheduler* _scheduler = nullptr;		// Which worker handles which sensor's next batch
+
+		// --- Metrics (/metrics) ---
+		std::atomic<uint32_t> _jsonOverflows{0};	// Events dropped because they did not fit their buffer
+		
+		// Set by web handlers, served by ProcTask with the other workers paused (detectors are not shared across tasks)
+		volatile bool	_learnRequested = false;
+		volatile int	_simulateRequested = -1;	// SimulatedFault, -1 = none
+		SemaphoreHandle_t _detectorLock;	// Held while a detector changes and while /model copies its limits
+		volatile bool	_spectrumRequested = false;	// Dashboard asked for a full spectrum now
+		volatile float	_runningHzRequested = 0;	// New running speed for the band features, 0 = none
+		volatile bool	_captureRequested = false;	// Manual capture trigger
+		volatile bool	_averageResetRequested = false;
+		volatile float	_averageAlpha = 0;			// With the reset: new EMA weight, 0 = keep
+		volatile int	_averageFrames = -1;		// With the reset: new linear average length, -1 = keep
+		SemaphoreHandle_t _averageLock;		// Held while the averages change and while /average copies one
+
+		// /analysis/add and /analysis/clear for one channel, applied by the processing task
+		struct AnalysisRequest {
+			ProcessingChannel* channel;
+			bool	clear;
+			float	zoomHz;			// 0 = plain FFT
+			int		points;
+			int		decimation;
+			int		hopSize;
+		};
+		AnalysisRequest	_analysisRequest;
+		volatile bool	_analysisRequested = false;
+		SemaphoreHandle_t _analysisLock;	// Held while analyses are added / freed and while /analysis reads them
+		
+		void processingWorker(Worker& worker);
+		void handleBatch(Worker& worker, uint8_t index);
+		ProcessingChannel* channelFor(uint8_t slot, SensorDataType type, const InternalMessage_t& first);
+		void publish(Worker& worker, const ProcessingChannel& channel, bool due);
+		void publishJson(Worker& worker, const ProcessingChannel& channel, uint32_t targets);
+		void publishBinary(Worker& worker, const ProcessingChannel& channel);
+		void publishAlarm(const ProcessingChannel& channel, const AlarmEvent_t& alarm);
+		void publishFeatures(const ProcessingChannel& channel);
+		void publishStatus(const ProcessingChannel& channel);
+		void publishCorrelation(const CorrelationSummary_t& c);
+		void sendText(const char* text, size_t len);
+		bool takeOver(ProcessingChannel& channel, const InternalMessage_t& msg);
+		void pairChannels();
+		bool requestsPending() const;
+		void serviceRequests(Worker& worker);
+		void addSseClient(AsyncEventSourceClient* client);
+		void removeSseClient(SseClient* slot);
+		uint32_t spectrumTargets(uint32_t channelBit, bool due);
+		uint32_t sendFrame(const char* frame, size_t len, PaceClass cls, uint32_t now, uint32_t targets = 0xFFFFFFFF);
+		void servicePacing();
+		uint32_t channelBit(const ProcessingChannel& channel) const;
+		ProcessingChannel* requestedChannel(AsyncWebServerRequest* request);
+		void sendModel(AsyncWebServerRequest* request);
+		void sendAverage(AsyncWebServerRequest* request);
+		void requestAnalysis(AsyncWebServerRequest* request, bool clear);
+		void sendAnalysis(AsyncWebServerRequest* request);
+		void sendCapture(AsyncWebServerRequest* request);
+		void sendCorrelation(AsyncWebServerRequest* request);
+		void triggerCapture(Worker& worker, const ProcessingChannel& channel, const AlarmEvent_t& alarm);
+		void sendMetrics(AsyncWebServerRequest* request);
+		static void taskWrapper(void* pvParameters);
+
+};
 #endif
\ No newline at end of file
@@ -1,27 +1,89 @@
-#ifndef PROTOCOL_H
-#define PROTOCOL_H
-
-#include <Arduino.h>
-
-#define BATCH_SAMPLES 256
-#define PACKET_HEADER 0xA5A5
-
-enum SensorDataType {
-    TYPE_UNKNOWN = 0, 
-    TYPE_VIBRATION = 1, 
-    TYPE_CURRENT = 2 
-};
-
-// The exact binary structure sent over WiFi (1028 bytes total)
-typedef struct {
-    uint16_t header;         // Safety check (0xA5A5)
-    int16_t  type;           // 1 = Vibration, 2 = Current
-    float    data[BATCH_SAMPLES]; 
-} DataPacket_t;
-
-typedef struct {
-    SensorDataType type;
-    float data[BATCH_SAMPLES];
-} InternalMessage_t;
-
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+#define BATCH_SAMPLES 256
+#define PACKET_HEADER 0xA5A5
+#define PACKET_HEADER_V2 0x5AA5     // Same 0xA5 lead byte on the wire, so one resync scan finds both
+#define PACKET_VERSION_V2 2
+
+enum SensorDataType {
+    TYPE_UNKNOWN = 0, 
+    TYPE_VIBRATION = 1, 
+    TYPE_CURRENT = 2 
+};
+
+// Leading 4 bytes of every packet, read on their own so the samples can go straight into a BatchPool slot
+typedef struct {
+    uint16_t header;         // Safety check (0xA5A5)
+    int16_t  type;           // 1 = Vibration, 2 = Current
+} PacketHeader_t;
+
+// The exact binary structure sent over WiFi (1028 bytes total)
+typedef struct {
+    uint16_t header;         // Safety check (0xA5A5)
+    int16_t  type;           // 1 = Vibration, 2 = Current
+    float    data[BATCH_SAMPLES]; 
+} DataPacket_t;
+
+// --- Protocol v2 ---
+// Sample encodings. Integer encodings decode as: value = offset + q * scale
+enum SampleEncoding {
+    ENC_FLOAT32 = 0,         // 4 bytes / sample (the v1 payload)
+    ENC_INT16 = 1,           // 2 bytes / sample
+    ENC_INT12_PACKED = 2,    // Two unsigned 12-bit samples in 3 bytes
+    ENC_DELTA8 = 3,          // int16 first sample, then int8 deltas (0x80 escapes to a full int16)
+    ENC_COUNT
+};
+
+// v2 frame: this header followed by payloadBytes of encoded samples (little-endian, 30 bytes).
+// v1 frames (0xA5A5 + type + 256 floats) are still accepted.
+typedef struct __attribute__((packed)) {
+    uint16_t header;         // Safety check (0x5AA5)
+    uint8_t  version;        // PACKET_VERSION_V2
+    uint8_t  type;           // SensorDataType
+    uint8_t  sensorId;       // Node id chosen by the sensor
+    uint8_t  encoding;       // SampleEncoding
+    uint16_t sampleCount;    // Samples in this batch (BATCH_SAMPLES)
+    uint32_t sequence;       // Per-sensor batch counter, detects gaps / reordering
+    uint32_t timestampUs;    // Sensor clock at the first sample
+    uint16_t sampleRateHz;
+    uint16_t payloadBytes;
+    float    scale;          // Integer encodings only
+    float    offset;         // Integer encodings only
+    uint8_t  reserved;
+    uint8_t  check;          // XOR of the previous 29 bytes
+} PacketHeaderV2_t;
+
+// Per-batch metadata kept alongside the samples (v1 packets get version 1, zero sequence/timestamp)
+typedef struct {
+    uint8_t  version;
+    uint8_t  sensorId;
+    uint8_t  encoding;       // SampleEncoding of the wire payload
+    uint16_t sampleRateHz;   // 0 = unknown (v1)
+    uint32_t sequence;
+    uint32_t timestampUs;
+    float    scale;          // Integer encodings: value = offset + q * scale (v1: 1 / 0)
+    float    offset;
+} BatchInfo_t;
+
+// How the samples of an InternalMessage_t are stored
+enum BatchFormat {
+    BATCH_FLOAT = 0,         // data[]: decoded float values
+    BATCH_CODES = 1          // codes[]: raw integer ADC codes, see info.scale / info.offset
+};
+
+typedef struct {
+    SensorDataType type;
+    uint8_t sensorSlot;      // CommunicationHub client slot the batch came from
+    uint8_t format;          // BatchFormat
+    uint8_t connection;      // Clients the slot has had (wraps): changes when a new one takes it
+    BatchInfo_t info;
+    union {
+        float   data[BATCH_SAMPLES];
+        int16_t codes[BATCH_SAMPLES];
+    };
+} InternalMessage_t;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include <math.h>
+#include "RealFft.h"
+#include "MemoryArena.h"
+
+static void buildWindow(int n, float* window){
+    // Hann, same weights as arduinoFFT (0.54 * (1 - cos)), symmetric over n - 1
+    const double samplesMinusOne = (double)(n - 1);
+    for (int i = 0; i < n; i++) {
+        window[i] = (float)(0.54 * (1.0 - cos(2.0 * M_PI * (double)i / samplesMinusOne)));
+    }
+}
+
+static void buildTwiddles(int n, float* cosTable, float* sinTable){
+    // W_n^k = cos - i*sin, k < n/2
+    for (int k = 0; k < n / 2; k++) {
+        cosTable[k] = (float)cos(2.0 * M_PI * (double)k / (double)n);
+        sinTable[k] = (float)sin(2.0 * M_PI * (double)k / (double)n);
+    }
+}
+
+void RealFftDetail::buildTables(int n, float* window, float* cosTable, float* sinTable){
+    buildWindow(n, window);
+    buildTwiddles(n, cosTable, sinTable);
+}
+
+void RealFftDetail::buildComplexTables(int m, float* window, float* cosTable, float* sinTable){
+    buildWindow(m, window);
+    buildTwiddles(2 * m, cosTable, sinTable);
+}
+
+// Fallback for sizes without a compile-time specialisation
+class RealFftDynamic : public RealFftPlan {
+	public:
+		RealFftDynamic(int n) : _n(n) {
+			_window	= arenaNew<float>(n, MEM_FAST, "fft");
+			_cos	= arenaNew<float>(n / 2, MEM_FAST, "fft");
+			_sin	= arenaNew<float>(n / 2, MEM_FAST, "fft");
+			_work	= arenaNew<float>(n, MEM_FAST, "fft");
+			RealFftDetail::buildTables(n, _window, _cos, _sin);
+		}
+		~RealFftDynamic() {
+			arenaDelete(_window); arenaDelete(_cos); arenaDelete(_sin); arenaDelete(_work);
+		}
+		void magnitude(const float* in, float* out, int start = 0, int ringSize = 0) override { RealFftDetail::run(_n, _window, _cos, _sin, _work, in, start, ringSize, out); }
+		int size() const override { return _n; }
+		const char* backendName() const override { return "portable"; }
+
+	private:
+		int		_n;
+		float*	_window;
+		float*	_cos;
+		float*	_sin;
+		float*	_work;
+};
+
+RealFftPlan* createRealFftPlan(int n, int backend){
+    if (n < 4 || (n & (n - 1)) != 0) return nullptr;
+    switch (backend) {
+        case REAL_FFT_PORTABLE:
+            switch (n) {
+                case 256:  return arenaCreate<RealFft<256>>(MEM_FAST, "fft");
+                case 1024: return arenaCreate<RealFft<1024>>(MEM_FAST, "fft");
+                case 4096: return arenaCreate<RealFft<4096>>(MEM_FAST, "fft");
+                default:   return arenaCreate<RealFftDynamic>(MEM_FAST, "fft", n);
+            }
+        case REAL_FFT_REFERENCE:
+            return createReferenceFftPlan(n);
+#if REAL_FFT_HAVE_ESPDSP
+        case REAL_FFT_ESPDSP:
+            return createEspDspFftPlan(n);
+#endif
+        default:
+            return nullptr;
+    }
+}
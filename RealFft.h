@@ -0,0 +1,163 @@
+#ifndef REAL_FFT_H
+#define REAL_FFT_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Real-input FFT: the N real samples are packed as N/2 complex values, run through an
+// N/2-point complex FFT and separated with a split step. Hann window and twiddle tables
+// are built once in the constructor, nothing is recomputed or allocated per frame.
+//
+// magnitude() does DC removal + Hann window + FFT + |X| in one call and writes N/2 bins.
+// The input may be a ring buffer: `start` is the index of the oldest of the N samples and
+// `ringSize` the ring length (0 = N). The window may wrap around the end of the ring.
+// Window and scale match arduinoFFT (Hann without compensation, unnormalised magnitude).
+//
+// RealFftPlan is the backend interface, every backend produces the same bins:
+//   REAL_FFT_PORTABLE   RealFft<N> below: plain loops the compiler can vectorise (Linux, any ESP32)
+//   REAL_FFT_REFERENCE  The arduinoFFT 2.0 algorithm (full N-point FFT, window per frame), for comparison
+//   REAL_FFT_ESPDSP     esp-dsp kernels (ae32 / ESP32-S3 aes3 SIMD), only on target with esp-dsp
+// The one DspPipeline uses is picked at compile time with REAL_FFT_BACKEND (see tools/FftConformance.cpp).
+#define REAL_FFT_PORTABLE 0
+#define REAL_FFT_REFERENCE 1
+#define REAL_FFT_ESPDSP 2
+
+#if defined(ARDUINO) && defined(__has_include)
+#if __has_include(<esp_dsp.h>)
+#define REAL_FFT_HAVE_ESPDSP 1
+#endif
+#endif
+#ifndef REAL_FFT_HAVE_ESPDSP
+#define REAL_FFT_HAVE_ESPDSP 0
+#endif
+
+#ifndef REAL_FFT_BACKEND
+#if REAL_FFT_HAVE_ESPDSP
+#define REAL_FFT_BACKEND REAL_FFT_ESPDSP
+#else
+#define REAL_FFT_BACKEND REAL_FFT_PORTABLE
+#endif
+#endif
+
+class RealFftPlan {
+	public:
+		virtual ~RealFftPlan() {}
+		virtual void magnitude(const float* in, float* out, int start = 0, int ringSize = 0) = 0;
+		virtual int size() const = 0;
+		virtual const char* backendName() const = 0;
+};
+
+namespace RealFftDetail {
+
+// Hann window over n samples, W_n^k (k < n/2) for the packed n-point real FFT
+void buildTables(int n, float* window, float* cosTable, float* sinTable);
+// Same window over m samples, W_2m^k (k < m) for an m-point complexFft (ZoomFft, CorrelationEngine)
+void buildComplexTables(int m, float* window, float* cosTable, float* sinTable);
+
+// Split step: X[k] = Fe[k] + W_n^k * Fo[k], then magnitude. work holds the n/2-point FFT
+// of the packed samples in natural order. Shared by every packed backend.
+inline __attribute__((always_inline)) void splitMagnitude(int n, const float* cosTable, const float* sinTable, const float* work, float* out){
+    const int m = n >> 1;
+    out[0] = work[0] + work[1];
+    if (out[0] < 0) out[0] = -out[0];
+    for (int k = 1; k < m; k++) {
+        const float zr = work[2 * k],       zi = work[2 * k + 1];
+        const float cr = work[2 * (m - k)], ci = -work[2 * (m - k) + 1];
+        const float er = 0.5f * (zr + cr),  ei = 0.5f * (zi + ci);
+        const float orr = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+        const float c = cosTable[k], s = sinTable[k];
+        const float xr = er + orr * c + oi * s;
+        const float xi = ei + oi * c - orr * s;
+        out[k] = sqrtf(xr * xr + xi * xi);
+    }
+}
+
+// Samples of a window of n starting at `start` before it wraps around a ring of ringSize (0 = n)
+inline int windowRun(int n, int start, int ringSize){
+    const int ring = (ringSize > 0) ? ringSize : n;
+    return (ring - start < n) ? ring - start : n;
+}
+
+// In-place m-point complex FFT (interleaved re/im, natural order in and out). The tables
+// hold W_2m^k for k < m, so W_m^x == W_2m^(2x) is read with a stride.
+inline __attribute__((always_inline)) void complexFft(int m, const float* cosTable, const float* sinTable, float* work){
+    // Bit reversal over the m complex values
+    int j = 0;
+    for (int i = 0; i < m - 1; i++) {
+        if (i < j) {
+            float tr = work[2 * i];     work[2 * i] = work[2 * j];         work[2 * j] = tr;
+            float ti = work[2 * i + 1]; work[2 * i + 1] = work[2 * j + 1]; work[2 * j + 1] = ti;
+        }
+        int k = m >> 1;
+        while (k <= j) { j -= k; k >>= 1; }
+        j += k;
+    }
+
+    // Radix-2 butterflies
+    for (int len = 2; len <= m; len <<= 1) {
+        const int half = len >> 1;
+        const int stride = 2 * (m / len);
+        for (int base = 0; base < m; base += len) {
+            for (int k = 0; k < half; k++) {
+                const float c = cosTable[k * stride];
+                const float s = sinTable[k * stride];
+                float* a = &work[2 * (base + k)];
+                float* b = &work[2 * (base + k + half)];
+                const float tr = b[0] * c + b[1] * s;
+                const float ti = b[1] * c - b[0] * s;
+                b[0] = a[0] - tr; b[1] = a[1] - ti;
+                a[0] += tr;       a[1] += ti;
+            }
+        }
+    }
+}
+
+// Kept inline so RealFft<N> gets the loops specialised for a constant N.
+inline __attribute__((always_inline)) void run(int n, const float* window, const float* cosTable, const float* sinTable, float* work, const float* in, int start, int ringSize, float* out){
+    // 1. DC removal + window, packed as n/2 complex values (re = even, im = odd sample)
+    const int headCount = windowRun(n, start, ringSize);
+    float mean = 0;
+    for (int i = 0; i < headCount; i++) mean += in[start + i];
+    for (int i = headCount; i < n; i++) mean += in[i - headCount];
+    mean /= n;
+    for (int i = 0; i < headCount; i++) work[i] = (in[start + i] - mean) * window[i];
+    for (int i = headCount; i < n; i++) work[i] = (in[i - headCount] - mean) * window[i];
+
+    // 2. n/2-point complex FFT (the split-step table doubles as its twiddles)
+    complexFft(n >> 1, cosTable, sinTable, work);
+
+    // 3. Split step + magnitude
+    splitMagnitude(n, cosTable, sinTable, work, out);
+}
+
+}
+
+// Compile-time sized plan (tables live inside the object).
+template<int N>
+class RealFft : public RealFftPlan {
+	static_assert(N >= 4 && (N & (N - 1)) == 0, "RealFft size must be a power of two");
+	public:
+		RealFft() { RealFftDetail::buildTables(N, _window, _cos, _sin); }
+		void magnitude(const float* in, float* out, int start = 0, int ringSize = 0) override { RealFftDetail::run(N, _window, _cos, _sin, _work, in, start, ringSize, out); }
+		int size() const override { return N; }
+		const char* backendName() const override { return "portable"; }
+
+	private:
+		float _window[N];
+		float _cos[N / 2];
+		float _sin[N / 2];
+		float _work[N];
+};
+
+// Returns a plan of the REAL_FFT_BACKEND backend. The portable one is compile-time specialised
+// for 256/1024/4096 points and runtime-sized otherwise.
+// Returns nullptr if n is not a power of two >= 4 or the backend is not built in.
+RealFftPlan* createRealFftPlan(int n, int backend = REAL_FFT_BACKEND);
+
+// Per-backend factories (createRealFftPlan dispatches to these)
+RealFftPlan* createReferenceFftPlan(int n);
+#if REAL_FFT_HAVE_ESPDSP
+RealFftPlan* createEspDspFftPlan(int n);
+#endif
+
+#endif
\ No newline at end of file
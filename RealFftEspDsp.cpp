@@ -0,0 +1,81 @@
+#include "RealFft.h"
+
+#if REAL_FFT_HAVE_ESPDSP
+
+#include <esp_dsp.h>
+#include "MemoryArena.h"
+
+// REAL_FFT_ESPDSP: same packed real FFT as RealFft<N>, with the heavy loops in esp-dsp.
+// dsps_fft2r_fc32 resolves to the ae32 assembly kernel on ESP32 and the aes3 SIMD one on
+// ESP32-S3; the DC removal and window multiply use dsps_addc_f32 / dsps_mul_f32.
+// The split step reuses RealFftDetail::splitMagnitude, so the bins match the portable plan.
+
+// esp-dsp keeps one shared twiddle table sized for the largest FFT, grown on demand.
+// Plans are created by the processing task before it runs them, so no locking is needed.
+static int s_tableSize = 0;
+
+static bool ensureTwiddles(int points){
+    if (points <= s_tableSize) return true;
+    if (s_tableSize > 0) dsps_fft2r_deinit_fc32();
+    s_tableSize = 0;
+    if (dsps_fft2r_init_fc32(NULL, points) != ESP_OK) return false;
+    s_tableSize = points;
+    return true;
+}
+
+class RealFftEspDsp : public RealFftPlan {
+	public:
+		RealFftEspDsp(int n) : _n(n) {
+			// The aes3 kernels want 16-byte aligned buffers (every arena / fallback block is)
+			_window	= arenaNew<float>(n, MEM_FAST, "fft");
+			_cos	= arenaNew<float>(n / 2, MEM_FAST, "fft");
+			_sin	= arenaNew<float>(n / 2, MEM_FAST, "fft");
+			_work	= arenaNew<float>(n, MEM_FAST, "fft");
+			RealFftDetail::buildTables(n, _window, _cos, _sin);
+		}
+		~RealFftEspDsp() {
+			arenaDelete(_window); arenaDelete(_cos); arenaDelete(_sin); arenaDelete(_work);
+		}
+		bool valid() const { return _window && _cos && _sin && _work; }
+		void magnitude(const float* in, float* out, int start = 0, int ringSize = 0) override;
+		int size() const override { return _n; }
+		const char* backendName() const override { return "esp-dsp"; }
+
+	private:
+		int		_n;
+		float*	_window;
+		float*	_cos;
+		float*	_sin;
+		float*	_work;
+};
+
+void RealFftEspDsp::magnitude(const float* in, float* out, int start, int ringSize){
+    const int n = _n;
+    const int m = n >> 1;
+
+    // 1. DC removal (ring in two runs) + window, packed as m complex values
+    const int headCount = RealFftDetail::windowRun(n, start, ringSize);
+    float mean = 0;
+    for (int i = 0; i < headCount; i++) mean += in[start + i];
+    for (int i = headCount; i < n; i++) mean += in[i - headCount];
+    mean /= n;
+    dsps_addc_f32(in + start, _work, headCount, -mean, 1, 1);
+    if (headCount < n) dsps_addc_f32(in, _work + headCount, n - headCount, -mean, 1, 1);
+    dsps_mul_f32(_work, _window, _work, n, 1, 1, 1);
+
+    // 2. m-point complex FFT; esp-dsp leaves the result in bit-reversed order
+    dsps_fft2r_fc32(_work, m);
+    dsps_bit_rev_fc32(_work, m);
+
+    // 3. Split step + magnitude
+    RealFftDetail::splitMagnitude(n, _cos, _sin, _work, out);
+}
+
+RealFftPlan* createEspDspFftPlan(int n){
+    if (n < 4 || (n & (n - 1)) != 0 || !ensureTwiddles(n / 2)) return nullptr;
+    RealFftEspDsp* plan = arenaCreate<RealFftEspDsp>(MEM_FAST, "fft", n);
+    if (plan != nullptr && !plan->valid()) { arenaDestroy(plan); return nullptr; }
+    return plan;
+}
+
+#endif
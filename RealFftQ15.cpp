@@ -0,0 +1,129 @@
+#include <math.h>
+#include <stdlib.h>
+#include "RealFft.h"
+#include "RealFftQ15.h"
+#include "MemoryArena.h"
+
+// Block floating point headroom: inputs of a stage stay below 2^13, so a + b * W
+// (at most 2^13 * (1 + sqrt(2)) per component) cannot leave int16.
+static const int32_t STAGE_LIMIT = 1 << 13;
+// Fractional bits kept on the mean, and the matching exponent of d * window
+static const int MEAN_FRACTION = 4;
+static const int WINDOW_EXPONENT = 15 - 1 + MEAN_FRACTION;	// Q15, halved window
+
+static inline int16_t toQ15(double v){
+    long q = lround(v * 32768.0);
+    if (q > 32767) q = 32767;
+    if (q < -32768) q = -32768;
+    return (int16_t)q;
+}
+
+static inline int32_t shiftRound(int32_t v, int shift){
+    return (shift > 0) ? (v + (1 << (shift - 1))) >> shift : v;
+}
+
+static inline int32_t absMax(int32_t peak, int32_t v){
+    if (v < 0) v = -v;
+    return (v > peak) ? v : peak;
+}
+
+RealFftQ15::RealFftQ15(int n) : _n(n){
+	_window	= arenaNew<int16_t>(n, MEM_FAST, "fft");
+	_cos	= arenaNew<int16_t>(n / 2, MEM_FAST, "fft");
+	_sin	= arenaNew<int16_t>(n / 2, MEM_FAST, "fft");
+	_work	= arenaNew<int16_t>(n, MEM_FAST, "fft");
+
+	// Same Hann weights as RealFftDetail::buildTables, halved
+	const double samplesMinusOne = (double)(n - 1);
+	for (int i = 0; i < n; i++) _window[i] = toQ15(0.27 * (1.0 - cos(2.0 * M_PI * (double)i / samplesMinusOne)));
+	for (int k = 0; k < n / 2; k++) {
+		_cos[k] = toQ15(cos(2.0 * M_PI * (double)k / (double)n));
+		_sin[k] = toQ15(sin(2.0 * M_PI * (double)k / (double)n));
+	}
+}
+
+RealFftQ15::~RealFftQ15(){
+	arenaDelete(_window); arenaDelete(_cos); arenaDelete(_sin); arenaDelete(_work);
+}
+
+void RealFftQ15::magnitude(const int16_t* in, float* out, int start, float scale, int ringSize){
+    const int n = _n;
+    const int m = n >> 1;
+    const int headCount = RealFftDetail::windowRun(n, start, ringSize);
+
+    // 1. DC removal (mean with MEAN_FRACTION extra bits) + window. Pass one finds the block
+    //    exponent, pass two writes the normalised int16 frame.
+    int64_t sum = 0;
+    for (int i = 0; i < n; i++) sum += in[(i < headCount) ? start + i : i - headCount];
+    const int32_t mean = (int32_t)((sum * (1 << MEAN_FRACTION) + (sum >= 0 ? n / 2 : -n / 2)) / n);
+
+    int64_t peak64 = 0;
+    for (int i = 0; i < n; i++) {
+        int32_t d = in[(i < headCount) ? start + i : i - headCount] * (1 << MEAN_FRACTION) - mean;
+        int64_t v = (int64_t)d * _window[i];
+        if (v < 0) v = -v;
+        if (v > peak64) peak64 = v;
+    }
+    int shift = 0;
+    while ((peak64 >> shift) >= STAGE_LIMIT) shift++;
+    const int64_t rounding = (shift > 0) ? ((int64_t)1 << (shift - 1)) : 0;
+    for (int i = 0; i < n; i++) {
+        int32_t d = in[(i < headCount) ? start + i : i - headCount] * (1 << MEAN_FRACTION) - mean;
+        _work[i] = (int16_t)(((int64_t)d * _window[i] + rounding) >> shift);
+    }
+    int exponent = shift - WINDOW_EXPONENT;
+    int32_t peak = (int32_t)((peak64 + rounding) >> shift);
+
+    // 2. Bit reversal over the m complex values
+    int j = 0;
+    for (int i = 0; i < m - 1; i++) {
+        if (i < j) {
+            int16_t tr = _work[2 * i];     _work[2 * i] = _work[2 * j];         _work[2 * j] = tr;
+            int16_t ti = _work[2 * i + 1]; _work[2 * i + 1] = _work[2 * j + 1]; _work[2 * j + 1] = ti;
+        }
+        int k = m >> 1;
+        while (k <= j) { j -= k; k >>= 1; }
+        j += k;
+    }
+
+    // 3. Radix-2 butterflies with a block shift before any stage that could overflow
+    for (int len = 2; len <= m; len <<= 1) {
+        const int half = len >> 1;
+        const int stride = 2 * (m / len);
+        int s = 0;
+        while ((peak >> s) >= STAGE_LIMIT) s++;
+        exponent += s;
+        peak = 0;
+        for (int base = 0; base < m; base += len) {
+            for (int k = 0; k < half; k++) {
+                const int32_t c = _cos[k * stride];
+                const int32_t sn = _sin[k * stride];
+                int16_t* a = &_work[2 * (base + k)];
+                int16_t* b = &_work[2 * (base + k + half)];
+                const int32_t ar = shiftRound(a[0], s), ai = shiftRound(a[1], s);
+                const int32_t br = shiftRound(b[0], s), bi = shiftRound(b[1], s);
+                const int32_t tr = (br * c + bi * sn + (1 << 14)) >> 15;
+                const int32_t ti = (bi * c - br * sn + (1 << 14)) >> 15;
+                b[0] = (int16_t)(ar - tr); b[1] = (int16_t)(ai - ti);
+                a[0] = (int16_t)(ar + tr); a[1] = (int16_t)(ai + ti);
+                peak = absMax(absMax(absMax(absMax(peak, b[0]), b[1]), a[0]), a[1]);
+            }
+        }
+    }
+    _exponent = exponent;
+
+    // 4. Split step + magnitude in float, rescaled to value units
+    const float unit = ldexpf(scale, exponent);
+    const float q15 = 1.0f / 32768.0f;
+    out[0] = fabsf((float)(_work[0] + _work[1])) * unit;
+    for (int k = 1; k < m; k++) {
+        const float zr = _work[2 * k],       zi = _work[2 * k + 1];
+        const float cr = _work[2 * (m - k)], ci = -_work[2 * (m - k) + 1];
+        const float er = 0.5f * (zr + cr),   ei = 0.5f * (zi + ci);
+        const float orr = 0.5f * (zi - ci),  oi = -0.5f * (zr - cr);
+        const float c = _cos[k] * q15, s = _sin[k] * q15;
+        const float xr = er + orr * c + oi * s;
+        const float xi = ei + oi * c - orr * s;
+        out[k] = sqrtf(xr * xr + xi * xi) * unit;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef REAL_FFT_Q15_H
+#define REAL_FFT_Q15_H
+
+#include <stdint.h>
+
+// Fixed-point counterpart of RealFftPlan for raw int16 ADC codes (the Q15 pipeline).
+// Same chain and output scale as the float plan: DC removal, Hann window, packed real FFT,
+// split step and |X|, so detectors and features see the same numbers either way.
+//
+// The window and butterflies run on int16 with Q15 tables and block floating point:
+// the frame is normalised below 2^13 after windowing, and a stage that could overflow
+// shifts the whole block right first, counting the shifts in one shared exponent.
+// Only the split step and magnitude (n/2 values) run in float.
+//
+// Tables + work buffer take 6 * n bytes (the float plan: 12 * n).
+class RealFftQ15 {
+	public:
+		RealFftQ15(int n);
+		~RealFftQ15();
+
+		RealFftQ15(const RealFftQ15&) = delete;
+		RealFftQ15& operator=(const RealFftQ15&) = delete;
+
+		// in: ring of ringSize codes (0 = n), `start` is the index of the oldest of the n used.
+		// out: n/2 magnitudes in value units, i.e. multiplied by `scale` (value per code).
+		void magnitude(const int16_t* in, float* out, int start, float scale, int ringSize = 0);
+
+		int size() const { return _n; }
+		// Block exponent of the last frame: work values * 2^exponent = windowed codes
+		int exponent() const { return _exponent; }
+
+	private:
+		int			_n;
+		int			_exponent = 0;
+		int16_t*	_window;		// Q15, half the float window (its 1.08 peak does not fit Q15)
+		int16_t*	_cos;			// Q15, n/2 entries
+		int16_t*	_sin;
+		int16_t*	_work;			// n/2 packed complex values
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <math.h>
+#include <string.h>
+#include "RealFft.h"
+#include "MemoryArena.h"
+
+// REAL_FFT_REFERENCE: the arduinoFFT 2.0 chain the dashboard was first built on.
+// Full N-point complex FFT with a zero imaginary part, Hann weights computed every frame
+// and twiddles by recurrence, exactly as ArduinoFFT<float>::dcRemoval / windowing(Hann,
+// Forward, false) / compute(Forward) / complexToMagnitude. Slow, kept as the yardstick
+// the faster backends are checked against (tools/FftConformance.cpp).
+class RealFftReference : public RealFftPlan {
+	public:
+		RealFftReference(int n) : _n(n) {
+			_vReal	= arenaNew<float>(n, MEM_FAST, "fft");
+			_vImag	= arenaNew<float>(n, MEM_FAST, "fft");
+		}
+		~RealFftReference() {
+			arenaDelete(_vReal); arenaDelete(_vImag);
+		}
+		void magnitude(const float* in, float* out, int start = 0, int ringSize = 0) override;
+		int size() const override { return _n; }
+		const char* backendName() const override { return "reference"; }
+
+	private:
+		int		_n;
+		float*	_vReal;
+		float*	_vImag;
+};
+
+void RealFftReference::magnitude(const float* in, float* out, int start, int ringSize){
+    const int n = _n;
+    const int headCount = RealFftDetail::windowRun(n, start, ringSize);
+    memcpy(_vReal, in + start, sizeof(float) * headCount);
+    memcpy(_vReal + headCount, in, sizeof(float) * (n - headCount));
+    memset(_vImag, 0, sizeof(float) * n);
+
+    // dcRemoval
+    float mean = 0;
+    for (int i = 0; i < n; i++) mean += _vReal[i];
+    mean /= n;
+    for (int i = 0; i < n; i++) _vReal[i] -= mean;
+
+    // windowing(Hann, Forward, false), symmetric pairs
+    const float samplesMinusOne = (float)(n - 1);
+    for (int i = 0; i < (n >> 1); i++) {
+        float ratio = (float)i / samplesMinusOne;
+        float weighingFactor = 0.54f * (1.0f - cosf(2.0f * (float)M_PI * ratio));
+        _vReal[i] *= weighingFactor;
+        _vReal[n - (i + 1)] *= weighingFactor;
+    }
+
+    // compute(Forward): bit reversal...
+    int j = 0;
+    for (int i = 0; i < (n - 1); i++) {
+        if (i < j) {
+            float t = _vReal[i]; _vReal[i] = _vReal[j]; _vReal[j] = t;
+            t = _vImag[i]; _vImag[i] = _vImag[j]; _vImag[j] = t;
+        }
+        int k = (n >> 1);
+        while (k <= j) {
+            j -= k;
+            k >>= 1;
+        }
+        j += k;
+    }
+
+    // ...and radix-2 butterflies, twiddles by recurrence
+    float c1 = -1.0f;
+    float c2 = 0.0f;
+    int l2 = 1;
+    for (int l = 1; l < n; l <<= 1) {
+        int l1 = l2;
+        l2 <<= 1;
+        float u1 = 1.0f;
+        float u2 = 0.0f;
+        for (j = 0; j < l1; j++) {
+            for (int i = j; i < n; i += l2) {
+                int i1 = i + l1;
+                float t1 = u1 * _vReal[i1] - u2 * _vImag[i1];
+                float t2 = u1 * _vImag[i1] + u2 * _vReal[i1];
+                _vReal[i1] = _vReal[i] - t1;
+                _vImag[i1] = _vImag[i] - t2;
+                _vReal[i] += t1;
+                _vImag[i] += t2;
+            }
+            float z = ((u1 * c1) - (u2 * c2));
+            u2 = ((u1 * c2) + (u2 * c1));
+            u1 = z;
+        }
+        c2 = -sqrtf((1.0f - c1) / 2.0f);
+        c1 = sqrtf((1.0f + c1) / 2.0f);
+    }
+
+    // complexToMagnitude, first half only
+    for (int i = 0; i < (n >> 1); i++) out[i] = sqrtf(_vReal[i] * _vReal[i] + _vImag[i] * _vImag[i]);
+}
+
+RealFftPlan* createReferenceFftPlan(int n){
+    if (n < 4 || (n & (n - 1)) != 0) return nullptr;
+    return arenaCreate<RealFftReference>(MEM_FAST, "fft", n);
+}
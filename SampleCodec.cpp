@@ -0,0 +1,161 @@
+#include <math.h>
+#include <string.h>
+#include "SampleCodec.h"
+
+static inline int32_t quantize(float v, float scale, float offset, int32_t lo, int32_t hi){
+    long q = lrintf((v - offset) / scale);
+    if (q < lo) q = lo;
+    if (q > hi) q = hi;
+    return (int32_t)q;
+}
+
+static inline void putInt16(uint8_t* p, int16_t v){ p[0] = (uint8_t)(v & 0xFF); p[1] = (uint8_t)((uint16_t)v >> 8); }
+static inline int16_t getInt16(const uint8_t* p){ return (int16_t)(p[0] | (p[1] << 8)); }
+
+static const uint8_t DELTA8_ESCAPE = 0x80;
+
+size_t SampleCodec::maxPayloadBytes(uint8_t encoding, int n){
+    switch (encoding) {
+        case ENC_FLOAT32:      return sizeof(float) * n;
+        case ENC_INT16:        return sizeof(int16_t) * n;
+        case ENC_INT12_PACKED: return 3 * ((n + 1) / 2);
+        case ENC_DELTA8:       return (n > 0) ? 2 + 3 * (size_t)(n - 1) : 0;	// Worst case: every delta escaped
+        default:               return 0;
+    }
+}
+
+size_t SampleCodec::encode(uint8_t encoding, const float* in, int n, float scale, float offset, uint8_t* out, size_t capacity){
+    size_t len = 0;
+    switch (encoding) {
+        case ENC_FLOAT32:
+            len = sizeof(float) * n;
+            if (len > capacity) return 0;
+            memcpy(out, in, len);
+            return len;
+
+        case ENC_INT16:
+            len = sizeof(int16_t) * n;
+            if (len > capacity) return 0;
+            for (int i = 0; i < n; i++) putInt16(out + 2 * i, (int16_t)quantize(in[i], scale, offset, -32768, 32767));
+            return len;
+
+        case ENC_INT12_PACKED:
+            len = 3 * ((n + 1) / 2);
+            if (len > capacity) return 0;
+            for (int i = 0; i < n; i += 2) {
+                uint16_t a = (uint16_t)quantize(in[i], scale, offset, 0, 4095);
+                uint16_t b = (i + 1 < n) ? (uint16_t)quantize(in[i + 1], scale, offset, 0, 4095) : 0;
+                uint8_t* p = out + 3 * (i / 2);
+                p[0] = (uint8_t)(a & 0xFF);
+                p[1] = (uint8_t)((a >> 8) | ((b & 0x0F) << 4));
+                p[2] = (uint8_t)(b >> 4);
+            }
+            return len;
+
+        case ENC_DELTA8: {
+            if (n <= 0 || capacity < 2) return 0;
+            int32_t prev = quantize(in[0], scale, offset, -32768, 32767);
+            putInt16(out, (int16_t)prev);
+            len = 2;
+            for (int i = 1; i < n; i++) {
+                int32_t q = quantize(in[i], scale, offset, -32768, 32767);
+                int32_t d = q - prev;
+                if (d >= -127 && d <= 127) {
+                    if (len + 1 > capacity) return 0;
+                    out[len++] = (uint8_t)(int8_t)d;
+                } else {
+                    if (len + 3 > capacity) return 0;
+                    out[len++] = DELTA8_ESCAPE;
+                    putInt16(out + len, (int16_t)q);
+                    len += 2;
+                }
+                prev = q;
+            }
+            return len;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+// Walks an integer payload and hands every code to emit(i, q). Returns false if it is malformed.
+template<typename Emit>
+static bool decodeIntegers(uint8_t encoding, const uint8_t* in, size_t len, int n, Emit emit){
+    switch (encoding) {
+        case ENC_INT16:
+            if (len != sizeof(int16_t) * n) return false;
+            for (int i = 0; i < n; i++) emit(i, getInt16(in + 2 * i));
+            return true;
+
+        case ENC_INT12_PACKED:
+            if (len != 3 * (size_t)((n + 1) / 2)) return false;
+            for (int i = 0; i < n; i += 2) {
+                const uint8_t* p = in + 3 * (i / 2);
+                emit(i, p[0] | ((p[1] & 0x0F) << 8));
+                if (i + 1 < n) emit(i + 1, (p[1] >> 4) | (p[2] << 4));
+            }
+            return true;
+
+        case ENC_DELTA8: {
+            if (n <= 0 || len < 2) return false;
+            int32_t q = getInt16(in);
+            emit(0, q);
+            size_t pos = 2;
+            for (int i = 1; i < n; i++) {
+                if (pos >= len) return false;
+                uint8_t b = in[pos++];
+                if (b == DELTA8_ESCAPE) {
+                    if (pos + 2 > len) return false;
+                    q = getInt16(in + pos);
+                    pos += 2;
+                } else {
+                    q += (int8_t)b;
+                }
+                emit(i, q);
+            }
+            return pos == len;
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool SampleCodec::decode(uint8_t encoding, const uint8_t* in, size_t len, int n, float scale, float offset, float* out){
+    if (encoding == ENC_FLOAT32) {
+        if (len != sizeof(float) * n) return false;
+        if ((const void*)in != (const void*)out) memcpy(out, in, len);
+        return true;
+    }
+    return decodeIntegers(encoding, in, len, n, [=](int i, int32_t q){ out[i] = offset + scale * q; });
+}
+
+bool SampleCodec::decodeCodes(uint8_t encoding, const uint8_t* in, size_t len, int n, int16_t* out){
+    // DELTA8 deltas can walk outside int16 on a corrupt payload, clamp like the encoder does
+    return decodeIntegers(encoding, in, len, n, [=](int i, int32_t q){ out[i] = (int16_t)((q < -32768) ? -32768 : (q > 32767) ? 32767 : q); });
+}
+
+uint8_t SampleCodec::headerCheck(const PacketHeaderV2_t& header){
+    const uint8_t* p = (const uint8_t*)&header;
+    uint8_t x = 0;
+    for (size_t i = 0; i < offsetof(PacketHeaderV2_t, check); i++) x ^= p[i];
+    return x;
+}
+
+void SampleCodec::buildHeader(PacketHeaderV2_t* header, SensorDataType type, uint8_t sensorId, uint8_t encoding, uint16_t sampleCount, uint32_t sequence, uint32_t timestampUs, uint16_t sampleRateHz, uint16_t payloadBytes, float scale, float offset){
+    header->header			= PACKET_HEADER_V2;
+    header->version			= PACKET_VERSION_V2;
+    header->type			= (uint8_t)type;
+    header->sensorId		= sensorId;
+    header->encoding		= encoding;
+    header->sampleCount		= sampleCount;
+    header->sequence		= sequence;
+    header->timestampUs		= timestampUs;
+    header->sampleRateHz	= sampleRateHz;
+    header->payloadBytes	= payloadBytes;
+    header->scale			= scale;
+    header->offset			= offset;
+    header->reserved		= 0;
+    header->check			= headerCheck(*header);
+}
@@ -0,0 +1,36 @@
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+
+// Encoders / decoders for the protocol v2 sample encodings (see SampleEncoding).
+// Used by the hub to decode and by sensor nodes / tools to build v2 frames.
+namespace SampleCodec {
+
+// Largest payload an encoding can produce for n samples (0 for an unknown encoding)
+size_t maxPayloadBytes(uint8_t encoding, int n);
+
+// Float samples -> wire payload. Integer encodings quantise as q = round((v - offset) / scale).
+// Returns the payload length, or 0 if it does not fit in `capacity`.
+size_t encode(uint8_t encoding, const float* in, int n, float scale, float offset, uint8_t* out, size_t capacity);
+
+// Wire payload -> n float samples. Returns false if the payload is malformed.
+bool decode(uint8_t encoding, const uint8_t* in, size_t len, int n, float scale, float offset, float* out);
+
+// Integer payload -> n raw codes (no scale / offset applied). False for ENC_FLOAT32 or a malformed payload.
+bool decodeCodes(uint8_t encoding, const uint8_t* in, size_t len, int n, int16_t* out);
+
+// True for encodings that carry integer codes
+inline bool isIntegerEncoding(uint8_t encoding){ return encoding != ENC_FLOAT32 && encoding < ENC_COUNT; }
+
+// XOR check byte over every header byte before `check`
+uint8_t headerCheck(const PacketHeaderV2_t& header);
+
+// Fills a complete v2 header (including check) for an already encoded payload
+void buildHeader(PacketHeaderV2_t* header, SensorDataType type, uint8_t sensorId, uint8_t encoding, uint16_t sampleCount, uint32_t sequence, uint32_t timestampUs, uint16_t sampleRateHz, uint16_t payloadBytes, float scale, float offset);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "SensorLink.h"
+
+void SensorLink::attach(uint8_t slot, BatchRing* ring, BatchPool* pool, PerfStage* enqueueStage){
+    _slot = slot;
+    _ring = ring;
+    _pool = pool;
+    _enqueueStage = enqueueStage;
+    _pending = -1;
+    _parser.reset();
+}
+
+void SensorLink::reset(){
+    // Hand back a slot left half-filled by a client that went away
+    if (_pending >= 0) {
+        _pool->recycle((uint8_t)_pending);
+        _pending = -1;
+    }
+    _parser.reset();
+    _connection++;
+}
+
+PacketParser::Event SensorLink::commit(size_t n){
+    _bytes += n;
+    PacketParser::Event event = _parser.commit(n);
+    switch (event) {
+        case PacketParser::EVENT_HEADER:
+            startBatch();
+            break;
+        case PacketParser::EVENT_PACKET:
+            handOver();
+            break;
+        case PacketParser::EVENT_SKIPPED:
+            // Payload failed to decode: the slot it was read into is free again
+            if (_pending >= 0) {
+                _pool->recycle((uint8_t)_pending);
+                _pending = -1;
+            }
+            break;
+        default:
+            break;
+    }
+    return event;
+}
+
+void SensorLink::startBatch(){
+    // Samples go from the socket straight into a pool slot
+    uint8_t index;
+    InternalMessage_t* msg = _pool->acquire(&index);
+    if (msg == nullptr) {
+        _parser.beginPayload(nullptr);	// No free slot: DROP the samples, stay in sync
+        return;
+    }
+    msg->type = _parser.type();
+    msg->sensorSlot = _slot;
+    msg->connection = _connection;
+    msg->info = _parser.info();
+    _pending = index;
+    // Integer ADC codes stay integer for the Q15 pipeline
+    if (SampleCodec::isIntegerEncoding(msg->info.encoding)) {
+        msg->format = BATCH_CODES;
+        _parser.beginPayloadCodes(msg->codes);
+    } else {
+        msg->format = BATCH_FLOAT;
+        _parser.beginPayload(msg->data);
+    }
+}
+
+void SensorLink::handOver(){
+    uint8_t index = (uint8_t)_pending;
+    _pending = -1;
+    // Only the slot index is handed over, without locks or waiting.
+    // If the DSP core is behind, the sensor's oldest queued batch is DROPPED. This prevents lag.
+    uint32_t start = Perf::cycles();
+    uint8_t evicted;
+    switch (_ring->push(index, &evicted)) {
+        case BatchRing::PUSHED_EVICTED: _pool->recycle(evicted); break;
+        case BatchRing::DROPPED: _pool->recycle(index); break;
+        default: break;
+    }
+    if (_enqueueStage != nullptr) _enqueueStage->add(Perf::cycles() - start);
+}
@@ -0,0 +1,47 @@
+#ifndef SENSOR_LINK_H
+#define SENSOR_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "PacketParser.h"
+#include "BatchPool.h"
+#include "PerfCounters.h"
+
+// One sensor connection on the hub side: its stream parser, the BatchPool slot the
+// payload is being read into, and the handoff of finished batches to its BatchRing.
+// Platform neutral, so CommunicationHub and the host load test (tools/LoadGen) run the
+// same code. The caller reads the socket straight into the link:
+//     n = client.read(link.writePtr(), min(available, link.want()));
+//     if (link.commit(n) == PacketParser::EVENT_PACKET) notify the consumer;
+class SensorLink {
+	public:
+		// slot = sensorSlot stamped on every batch; enqueueStage (optional) times the ring push
+		void attach(uint8_t slot, BatchRing* ring, BatchPool* pool, PerfStage* enqueueStage = nullptr);
+		// New connection in the slot: hands back a half-filled pool slot, restarts the parser.
+		// Its batches carry the next connection number, so the DSP side sees the change of client.
+		void reset();
+
+		size_t want() const { return _parser.want(); }
+		uint8_t* writePtr() { return _parser.writePtr(); }
+		// n bytes were read into writePtr(). EVENT_PACKET = a batch went to the ring.
+		PacketParser::Event commit(size_t n);
+
+		const PacketParser& parser() const { return _parser; }
+		uint32_t bytesReceived() const { return _bytes; }
+
+	private:
+		PacketParser	_parser;
+		uint8_t			_slot = 0;
+		BatchRing*		_ring = nullptr;
+		BatchPool*		_pool = nullptr;
+		PerfStage*		_enqueueStage = nullptr;
+		int16_t			_pending = -1;		// Pool slot being filled, -1 if none
+		uint8_t			_connection = 0;	// Stamped on every batch, counts reset()s
+		uint32_t		_bytes = 0;
+
+		void startBatch();
+		void handOver();
+};
+
+#endif
\ No newline at end of file
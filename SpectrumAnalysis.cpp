@@ -0,0 +1,37 @@
+#include <string.h>
+#include "DspPipeline.h"
+#include "SpectrumAnalysis.h"
+#include "MemoryArena.h"
+
+FftAnalysis::FftAnalysis(const DspPipeline& source, int points, int hopSize) : _points(points){
+	_hopSize	= (hopSize <= 0 || hopSize > points) ? points : hopSize;
+	_binHz		= source.samplingFrequency() / points;
+	_spectrum	= arenaNew<float>(points / 2, MEM_FAST, "analysis");
+	if (source.format() == DSP_Q15) _fftQ15 = arenaCreate<RealFftQ15>(MEM_FAST, "analysis", points);
+	else _fft = createRealFftPlan(points);
+	if (_fftQ15 == nullptr && _fft == nullptr) _fft = createRealFftPlan(points, REAL_FFT_PORTABLE);
+}
+
+FftAnalysis::~FftAnalysis(){
+	arenaDelete(_spectrum);
+	arenaDestroy(_fft);
+	arenaDestroy(_fftQ15);
+}
+
+size_t FftAnalysis::memoryBytes() const {
+    size_t bytes = sizeof(float) * (_points / 2);
+    return bytes + ((_fftQ15 != nullptr) ? 6 : 12) * (size_t)_points;
+}
+
+bool FftAnalysis::update(const DspPipeline& source, int newSamples){
+    _sinceLast += newSamples;
+    if (source.filled() < _points || _sinceLast < _hopSize) return false;
+    _sinceLast = 0;
+
+    // Newest _points samples, straight from the shared ring
+    const int start = source.recentStart(_points);
+    if (_fftQ15 != nullptr) _fftQ15->magnitude(source.ringCodes(), _spectrum, start, source.codeScale(), source.ringSize());
+    else if (_fft != nullptr) _fft->magnitude(source.ringData(), _spectrum, start, source.ringSize());
+    _frames++;
+    return true;
+}
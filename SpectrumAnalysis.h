@@ -0,0 +1,68 @@
+#ifndef SPECTRUM_ANALYSIS_H
+#define SPECTRUM_ANALYSIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class DspPipeline;
+class RealFftPlan;
+class RealFftQ15;
+
+// An extra analysis run over a DspPipeline's input ring, next to the pipeline's own FFT
+// (e.g. a 4096-point fine spectrum, or a ZoomFft around the line frequency).
+// Analyses keep no copy of the input: after every batch the pipeline calls update() and
+// they read what they need from its ring. Added with DspPipeline::addFftAnalysis / addZoomAnalysis.
+class SpectrumAnalysis {
+	public:
+		virtual ~SpectrumAnalysis() {}
+
+		// The pipeline wrote newSamples to its ring. Returns true when spectrum() was refreshed.
+		virtual bool update(const DspPipeline& source, int newSamples) = 0;
+		// The ring was reallocated / restarted
+		virtual void reset() = 0;
+		// Input history the analysis reads back from the ring during an update() of newSamples
+		virtual int ringSamples(int newSamples) const = 0;
+
+		// bins() magnitudes, bin k at startHz() + k * binHz(); same scale as DspPipeline::spectrum()
+		virtual const float* spectrum() const = 0;
+		virtual int bins() const = 0;
+		virtual float startHz() const = 0;
+		virtual float binHz() const = 0;
+		virtual uint32_t frames() const = 0;			// Spectra computed so far
+		virtual size_t memoryBytes() const = 0;
+		virtual const char* kindName() const = 0;		// "fft" / "zoom"
+};
+
+// A real FFT of a different size over the newest `points` samples of the ring, every hopSize samples
+class FftAnalysis : public SpectrumAnalysis {
+	public:
+		FftAnalysis(const DspPipeline& source, int points, int hopSize = 0);
+		~FftAnalysis();
+
+		FftAnalysis(const FftAnalysis&) = delete;
+		FftAnalysis& operator=(const FftAnalysis&) = delete;
+
+		bool update(const DspPipeline& source, int newSamples) override;
+		void reset() override { _sinceLast = 0; }
+		int ringSamples(int) const override { return _points; }
+
+		const float* spectrum() const override { return _spectrum; }
+		int bins() const override { return _points / 2; }
+		float startHz() const override { return 0; }
+		float binHz() const override { return _binHz; }
+		uint32_t frames() const override { return _frames; }
+		size_t memoryBytes() const override;
+		const char* kindName() const override { return "fft"; }
+
+	private:
+		int			_points;
+		int			_hopSize;
+		float		_binHz;
+		int			_sinceLast = 0;
+		uint32_t	_frames = 0;
+		float*		_spectrum;
+		RealFftPlan* _fft = nullptr;		// Float rings
+		RealFftQ15*	_fftQ15 = nullptr;		// Q15 rings
+};
+
+#endif
\ No newline at end of file
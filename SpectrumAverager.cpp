@@ -0,0 +1,45 @@
+#include <string.h>
+#include "SpectrumAverager.h"
+#include "MemoryArena.h"
+
+SpectrumAverager::SpectrumAverager(int bins, float alpha, int linearFrames) : _bins(bins), _alpha(alpha), _linearFrames(linearFrames){
+	for (int m = 0; m < AVG_MODE_COUNT; m++) _buffers[m] = arenaNew<float>(_bins, MEM_BULK, "average");
+	reset();
+}
+
+SpectrumAverager::~SpectrumAverager(){
+	for (int m = 0; m < AVG_MODE_COUNT; m++) arenaDelete(_buffers[m]);
+}
+
+void SpectrumAverager::reset(){
+    for (int m = 0; m < AVG_MODE_COUNT; m++) memset(_buffers[m], 0, sizeof(float) * _bins);
+    _frames = 0;
+    _linearCount = 0;
+}
+
+void SpectrumAverager::configure(float alpha, int linearFrames){
+    if (alpha > 0 && alpha <= 1) _alpha = alpha;
+    if (linearFrames >= 0) _linearFrames = linearFrames;
+}
+
+void SpectrumAverager::update(const float* spectrum){
+    float* ema = _buffers[AVG_EXPONENTIAL];
+    float* mean = _buffers[AVG_LINEAR];
+    float* peak = _buffers[AVG_PEAK_HOLD];
+
+    // First spectrum seeds the EMA, afterwards each bin moves `alpha` of the way
+    const float a = (_frames == 0) ? 1.0f : _alpha;
+    // Running mean: avg += (x - avg) / k, frozen once the target count is reached
+    const bool linear = !linearComplete();
+    const float k = linear ? 1.0f / (float)(_linearCount + 1) : 0.0f;
+
+    for (int i = 0; i < _bins; i++) {
+        const float x = spectrum[i];
+        ema[i] += a * (x - ema[i]);
+        mean[i] += k * (x - mean[i]);
+        if (x > peak[i]) peak[i] = x;
+    }
+
+    _frames++;
+    if (linear) _linearCount++;
+}
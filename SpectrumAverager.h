@@ -0,0 +1,55 @@
+#ifndef SPECTRUM_AVERAGER_H
+#define SPECTRUM_AVERAGER_H
+
+#include <stdint.h>
+
+enum AverageMode {
+    AVG_EXPONENTIAL = 0,    // EMA, weight `alpha` on the newest spectrum
+    AVG_LINEAR,             // Equal-weight mean of the first N spectra since reset (Welch-style)
+    AVG_PEAK_HOLD,          // Per-bin maximum since reset
+    AVG_MODE_COUNT
+};
+
+// Per-channel spectrum accumulators. All three are updated in place in one pass over
+// each new spectrum, so querying an averaged spectrum costs nothing on the hot path.
+// With the pipeline's overlapping frames the linear mean is a Welch estimate (of magnitudes).
+class SpectrumAverager {
+	public:
+		SpectrumAverager(int bins, float alpha = 0.1f, int linearFrames = 16);
+		~SpectrumAverager();
+
+		SpectrumAverager(const SpectrumAverager&) = delete;
+		SpectrumAverager& operator=(const SpectrumAverager&) = delete;
+
+		void reset();
+		void update(const float* spectrum);
+
+		// linearFrames 0 = keep averaging until reset
+		void configure(float alpha, int linearFrames);
+
+		const float* spectrum(AverageMode mode) const { return _buffers[mode]; }
+		// Spectra folded into `mode` since the last reset
+		uint32_t frames(AverageMode mode) const { return (mode == AVG_LINEAR) ? _linearCount : _frames; }
+		bool linearComplete() const { return _linearFrames > 0 && _linearCount >= (uint32_t)_linearFrames; }
+		int bins() const { return _bins; }
+		float alpha() const { return _alpha; }
+
+	private:
+		int			_bins;
+		float		_alpha;
+		int			_linearFrames;
+		float*		_buffers[AVG_MODE_COUNT];
+		uint32_t	_frames = 0;
+		uint32_t	_linearCount = 0;
+};
+
+inline const char* averageModeName(AverageMode mode){
+    switch (mode) {
+        case AVG_EXPONENTIAL: return "exp";
+        case AVG_LINEAR:      return "lin";
+        case AVG_PEAK_HOLD:   return "peak";
+        default:              return "unk";
+    }
+}
+
+#endif
\ No newline at end of file
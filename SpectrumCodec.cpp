@@ -0,0 +1,70 @@
+#include <math.h>
+#include <string.h>
+#include "SpectrumCodec.h"
+
+static inline int16_t quantize(float v){
+    long q = lrintf(v);
+    if (q > 32767) q = 32767;
+    if (q < -32767) q = -32767;
+    return (int16_t)q;
+}
+
+size_t SpectrumCodec::encode(uint8_t* dst, size_t capacity, SensorDataType type, uint8_t slot, const DspPipeline& pipeline, int timeStride){
+    const int bins = pipeline.bins();
+    const int timeCount = pipeline.fftSize() / timeStride;
+    const size_t len = frameSize(bins, timeCount);
+    if (len > capacity) return 0;
+
+    const float* fft = pipeline.spectrum();
+
+    // --- Scales: spectrum is 0..max, time is centred on its midpoint ---
+    float fftMax = 0;
+    for (int i = 0; i < bins; i++) if (fft[i] > fftMax) fftMax = fft[i];
+
+    float tMin = pipeline.timeSample(0), tMax = tMin;
+    for (int i = 0; i < timeCount; i++) {
+        float v = pipeline.timeSample(i * timeStride);
+        if (v < tMin) tMin = v;
+        if (v > tMax) tMax = v;
+    }
+
+    SpectrumFrameHeader_t header;
+    header.magic		= SPECTRUM_FRAME_MAGIC;
+    header.version		= SPECTRUM_FRAME_VERSION;
+    header.type			= (uint8_t)type;
+    header.slot			= slot;
+    header.flags		= 0;
+    header.bins			= (uint16_t)bins;
+    header.timeCount	= (uint16_t)timeCount;
+    header.reserved		= 0;
+    header.fftScale		= (fftMax > 0) ? fftMax / 32767.0f : 1.0f;
+    header.timeOffset	= 0.5f * (tMax + tMin);
+    header.timeScale	= (tMax > tMin) ? 0.5f * (tMax - tMin) / 32767.0f : 1.0f;
+    memcpy(dst, &header, sizeof(header));
+
+    // --- Payload ---
+    int16_t* out = (int16_t*)(dst + sizeof(header));
+    const float fftInv = 1.0f / header.fftScale;
+    for (int i = 0; i < bins; i++) out[i] = quantize(fft[i] * fftInv);
+
+    out += bins;
+    const float timeInv = 1.0f / header.timeScale;
+    for (int i = 0; i < timeCount; i++) out[i] = quantize((pipeline.timeSample(i * timeStride) - header.timeOffset) * timeInv);
+
+    return len;
+}
+
+void SpectrumCodec::writeJson(TextWriter& out, const char* typeName, uint8_t slot, const DspPipeline& pipeline, int timeStride){
+    const float* fft = pipeline.spectrum();
+    const int bins = pipeline.bins();
+    const int n = pipeline.fftSize();
+
+    out.text("{\"type\":\"").text(typeName).text("\",\"slot\":").integer(slot).text(",\"fft\":[");
+    for (int i = 0; i < bins; i++) {
+        out.fixed(fft[i], 2).put((i < bins - 1) ? ',' : ']');
+    }
+    out.text(",\"time\":[");
+    for (int i = 0; i < n; i += timeStride) {
+        out.fixed(pipeline.timeSample(i), 2).text((i < n - timeStride) ? "," : "]}");
+    }
+}
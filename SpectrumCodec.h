@@ -0,0 +1,48 @@
+#ifndef SPECTRUM_CODEC_H
+#define SPECTRUM_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "DspPipeline.h"
+#include "TextWriter.h"
+
+#define SPECTRUM_FRAME_MAGIC   0x5350	// "PS" on the wire (little-endian)
+#define SPECTRUM_FRAME_VERSION 1
+
+// Binary dashboard frame sent over the /ws WebSocket (little-endian, 24 bytes + payload).
+// Payload: `bins` int16 spectrum values, then `timeCount` int16 time samples.
+//   fft[i]  = q * fftScale
+//   time[i] = timeOffset + q * timeScale
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  type;           // SensorDataType
+    uint8_t  slot;
+    uint8_t  flags;          // Reserved, 0
+    uint16_t bins;
+    uint16_t timeCount;
+    uint16_t reserved;
+    float    fftScale;
+    float    timeOffset;
+    float    timeScale;
+} SpectrumFrameHeader_t;
+
+namespace SpectrumCodec {
+
+// Bytes needed for a frame of the given sizes
+constexpr size_t frameSize(int bins, int timeCount){
+    return sizeof(SpectrumFrameHeader_t) + sizeof(int16_t) * (size_t)(bins + timeCount);
+}
+
+// Packs the latest spectrum and every `timeStride`-th sample of the window.
+// Returns the frame length, or 0 if `capacity` is too small.
+size_t encode(uint8_t* dst, size_t capacity, SensorDataType type, uint8_t slot, const DspPipeline& pipeline, int timeStride);
+
+// The same content as the SSE "update" JSON, values with two decimals:
+//   {"type":"<typeName>","slot":N,"fft":[...],"time":[...]}
+void writeJson(TextWriter& out, const char* typeName, uint8_t slot, const DspPipeline& pipeline, int timeStride);
+
+}
+
+#endif
\ No newline at end of file
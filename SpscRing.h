@@ -0,0 +1,103 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Head and tail live on separate cache lines so the two cores do not false-share
+#if defined(ESP_PLATFORM)
+#define SPSC_CACHE_LINE 32
+#else
+#define SPSC_CACHE_LINE 64
+#endif
+
+// Lock-free single-producer / single-consumer ring for small trivially copyable items
+// (BatchPool indices between the network and DSP cores). No critical sections, no copies
+// beyond the item itself.
+//
+// When full, the overflow policy decides what is lost:
+//   DROP_NEWEST - the pushed item is refused (caller still owns it)
+//   DROP_OLDEST - the oldest queued item is evicted and handed back to the producer
+// The producer evicts by advancing the tail with a CAS, so pop() also claims items by CAS.
+template<typename T, size_t Capacity>
+class SpscRing {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+	static_assert(std::is_trivially_copyable<T>::value, "SpscRing items must be trivially copyable");
+
+	public:
+		enum OverflowPolicy { DROP_NEWEST, DROP_OLDEST };
+		enum PushResult { PUSHED, PUSHED_EVICTED, DROPPED };
+
+		SpscRing(OverflowPolicy policy = DROP_OLDEST) : _policy(policy) {}
+
+		void setOverflowPolicy(OverflowPolicy policy) { _policy = policy; }
+
+		// Producer only. On PUSHED_EVICTED `evicted` holds the item that made room.
+		PushResult push(const T& item, T* evicted = nullptr){
+			const uint32_t head = _head.load(std::memory_order_relaxed);
+			uint32_t tail = _tail.load(std::memory_order_acquire);
+			PushResult result = PUSHED;
+
+			if (head - tail >= Capacity) {
+				if (_policy == DROP_NEWEST) {
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+					return DROPPED;
+				}
+				// Claim the oldest item; if the consumer wins the race there is room anyway
+				T oldest = _slots[tail & (Capacity - 1)];
+				if (_tail.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel)) {
+					if (evicted != nullptr) *evicted = oldest;
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+					result = PUSHED_EVICTED;
+				}
+			}
+
+			_slots[head & (Capacity - 1)] = item;
+			_head.store(head + 1, std::memory_order_release);
+			_pushed.fetch_add(1, std::memory_order_relaxed);
+
+			// Depth right after this push (the consumer can only have made it smaller)
+			const uint32_t depth = head + 1 - tail - (result == PUSHED_EVICTED ? 1 : 0);
+			if (depth > _highWater.load(std::memory_order_relaxed)) _highWater.store(depth, std::memory_order_relaxed);
+			return result;
+		}
+
+		// Consumer only. Returns false when empty.
+		bool pop(T& out){
+			uint32_t tail = _tail.load(std::memory_order_acquire);
+			for (;;) {
+				const uint32_t head = _head.load(std::memory_order_acquire);
+				if (tail == head) return false;
+				T item = _slots[tail & (Capacity - 1)];
+				// Fails only if the producer evicted this item meanwhile; tail is reloaded
+				if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel)) {
+					out = item;
+					return true;
+				}
+			}
+		}
+
+		size_t size() const {
+			return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+		}
+		bool empty() const { return size() == 0; }
+		static constexpr size_t capacity() { return Capacity; }
+
+		// --- Counters ---
+		uint32_t pushed() const { return _pushed.load(std::memory_order_relaxed); }
+		uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+		uint32_t highWater() const { return _highWater.load(std::memory_order_relaxed); }	// Deepest the ring has been
+
+	private:
+		alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> _head{0};	// Written by the producer
+		alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> _tail{0};	// Written by the consumer (and by eviction)
+		alignas(SPSC_CACHE_LINE) std::atomic<uint32_t> _pushed{0};
+		std::atomic<uint32_t> _dropped{0};
+		std::atomic<uint32_t> _highWater{0};	// Producer only
+		OverflowPolicy _policy;
+		T _slots[Capacity];
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <string.h>
+#include "TextWriter.h"
+
+TextWriter::TextWriter(char* buffer, size_t capacity, Sink sink, void* ctx)
+	: _buffer(buffer), _capacity(capacity), _sink(sink), _ctx(ctx){
+	if (_capacity > 0) _buffer[0] = '\0';
+}
+
+TextWriter& TextWriter::text(const char* s){
+    return text(s, strlen(s));
+}
+
+TextWriter& TextWriter::text(const char* s, size_t len){
+    // One byte of the buffer is kept for the terminator
+    while (len > 0 && !_overflow) {
+        size_t room = (_capacity > 0) ? _capacity - 1 - _len : 0;
+        if (room == 0) {
+            if (_sink == nullptr || _len == 0 || !flush()) {
+                _overflow = true;
+                break;
+            }
+            continue;
+        }
+        size_t n = (len < room) ? len : room;
+        memcpy(_buffer + _len, s, n);
+        _len += n;
+        _total += n;
+        s += n;
+        len -= n;
+    }
+    if (_capacity > 0) _buffer[_len] = '\0';
+    return *this;
+}
+
+TextWriter& TextWriter::put(char c){
+    return text(&c, 1);
+}
+
+// Digits of v, most significant first, into the end of buf. Returns the first digit.
+static char* digitsOf(uint64_t v, char* end){
+    char* p = end;
+    // 64-bit division is a library call on the ESP32; stay in 32 bits when the value allows
+    while (v > 0xFFFFFFFFull) {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    }
+    uint32_t small = (uint32_t)v;
+    do {
+        *--p = (char)('0' + small % 10);
+        small /= 10;
+    } while (small > 0);
+    return p;
+}
+
+TextWriter& TextWriter::integer(long value){
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    uint64_t magnitude = (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char* p = digitsOf(magnitude, end);
+    if (value < 0) *--p = '-';
+    return text(p, (size_t)(end - p));
+}
+
+TextWriter& TextWriter::uinteger(unsigned long value){
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = digitsOf(value, end);
+    return text(p, (size_t)(end - p));
+}
+
+// Integral float too large for 64 bits (m * 2^shift, shift > 25): exact decimal digits into the end of buf
+static char* bigDigitsOf(uint32_t mantissa, int shift, char* end){
+    // 2^128 needs 4 limbs, one spare for the shift
+    uint32_t limbs[5] = {};
+    limbs[shift / 32] = mantissa << (shift % 32);
+    if (shift % 32 != 0) limbs[shift / 32 + 1] = mantissa >> (32 - shift % 32);
+    int top = 4;
+    char* p = end;
+    for (;;) {
+        while (top > 0 && limbs[top] == 0) top--;
+        if (top == 0 && limbs[0] < 1000000000u) break;
+        // Divide by 10^9, the remainder is the next nine digits
+        uint64_t rem = 0;
+        for (int i = top; i >= 0; i--) {
+            uint64_t cur = (rem << 32) | limbs[i];
+            limbs[i] = (uint32_t)(cur / 1000000000u);
+            rem = cur % 1000000000u;
+        }
+        uint32_t chunk = (uint32_t)rem;
+        for (int d = 0; d < 9; d++) {
+            *--p = (char)('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
+    return digitsOf(limbs[0], p);
+}
+
+TextWriter& TextWriter::fixed(float value, int decimals){
+    static const uint32_t POW10[] = {1, 10, 100, 1000, 10000};
+    if (decimals < 0) decimals = 0;
+    if (decimals > 4) decimals = 4;
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits >> 31) != 0;
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t fraction = bits & 0x7FFFFF;
+    if (exponent == 0xFF) {
+        if (fraction != 0) return text(negative ? "-nan" : "nan");
+        return text(negative ? "-inf" : "inf");
+    }
+
+    // value = mantissa * 2^shift exactly; scaled by 10^decimals it is still an integer times a power of two
+    uint32_t mantissa = (exponent == 0) ? fraction : (fraction | 0x800000);
+    int shift = (exponent == 0) ? -149 : (int)exponent - 150;
+
+    char buf[64];
+    char* end = buf + sizeof(buf);
+    char* p;
+    if (shift > 25) {
+        // >= 2^49: integral, and too wide for 64 bits once scaled
+        p = bigDigitsOf(mantissa, shift, end - decimals);
+        for (int i = 0; i < decimals; i++) end[-1 - i] = '0';
+    } else {
+        // mantissa * 10^4 < 2^38, so every case below stays within 64 bits
+        uint64_t scaled = (uint64_t)mantissa * POW10[decimals];
+        uint64_t q;
+        if (shift >= 0) {
+            q = scaled << shift;
+        } else if (shift > -40) {
+            // Round half to even, as printf does for the exact binary value
+            int s = -shift;
+            q = scaled >> s;
+            uint64_t rest = scaled & (((uint64_t)1 << s) - 1);
+            uint64_t half = (uint64_t)1 << (s - 1);
+            if (rest > half || (rest == half && (q & 1))) q++;
+        } else {
+            q = 0;      // Below half a unit of the last place
+        }
+        p = digitsOf(q, end);
+        // At least one digit before the point
+        while (end - p < decimals + 1) *--p = '0';
+    }
+
+    if (decimals > 0) {
+        // Open a gap for the point in front of the decimals
+        p--;
+        memmove(p, p + 1, (size_t)(end - decimals - 1 - p));
+        end[-decimals - 1] = '.';
+    }
+    if (negative) *--p = '-';
+    return text(p, (size_t)(end - p));
+}
+
+bool TextWriter::flush(){
+    if (_sink != nullptr && _len > 0) {
+        if (!_sink(_buffer, _len, _ctx)) _overflow = true;
+        _len = 0;
+        if (_capacity > 0) _buffer[0] = '\0';
+    }
+    return !_overflow;
+}
+
+namespace SseFrame {
+
+size_t open(TextWriter& out, const char* event, uint32_t id){
+    if (id != 0) out.text("id: ").uinteger(id).text("\r\n");
+    if (event != nullptr) out.text("event: ").text(event).text("\r\n");
+    out.text("data: ");
+    return out.length();
+}
+
+void close(TextWriter& out){
+    out.text("\r\n\r\n");
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef TEXT_WRITER_H
+#define TEXT_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounds-checked text builder for the dashboard JSON, with its own number formatting (no printf).
+// fixed() prints exactly what printf("%.*f") prints for a float, integer()/uinteger() what %ld / %lu do.
+//
+// Output goes into the caller's buffer. With a sink every full buffer is handed over as one chunk
+// and writing starts over, so any length streams through a small buffer (HTTP responses). Without
+// a sink the text must fit: further writes are dropped and overflowed() is set. The buffer is kept
+// NUL-terminated either way.
+class TextWriter {
+	public:
+		// Gets each full chunk, and the rest on flush(). Returns false to stop the output.
+		typedef bool (*Sink)(const char* data, size_t len, void* ctx);
+
+		TextWriter(char* buffer, size_t capacity, Sink sink = nullptr, void* ctx = nullptr);
+
+		TextWriter& text(const char* s);
+		TextWriter& text(const char* s, size_t len);
+		TextWriter& put(char c);
+		TextWriter& integer(long value);
+		TextWriter& uinteger(unsigned long value);
+		// printf("%.*f", decimals, value) for 0..4 decimals, including "nan" / "inf" and rounding ties to even
+		TextWriter& fixed(float value, int decimals);
+
+		// Hands what is buffered to the sink. False if anything was dropped.
+		bool flush();
+
+		const char* data() const { return _buffer; }
+		size_t length() const { return _len; }			// In the buffer (since the last chunk)
+		size_t total() const { return _total; }			// Written in all
+		bool overflowed() const { return _overflow; }
+
+	private:
+		char*	_buffer;
+		size_t	_capacity;
+		size_t	_len = 0;
+		size_t	_total = 0;
+		bool	_overflow = false;
+		Sink	_sink;
+		void*	_ctx;
+};
+
+// Server-Sent Events framing, as AsyncEventSourceClient::send() builds it for a single-line message:
+//   "id: <id>\r\n" (unless 0), "event: <event>\r\n", "data: <message>\r\n\r\n"
+// The message is written between open() and close(); it must not contain line breaks.
+namespace SseFrame {
+
+// Returns the offset of the message in the writer's buffer
+size_t open(TextWriter& out, const char* event, uint32_t id);
+void close(TextWriter& out);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "UplinkCodec.h"
+#include "SampleCodec.h"
+
+uint8_t UplinkCodec::headerCheck(const UplinkHeader_t& header){
+    const uint8_t* p = (const uint8_t*)&header;
+    uint8_t x = 0;
+    for (size_t i = 0; i < offsetof(UplinkHeader_t, check); i++) x ^= p[i];
+    return x;
+}
+
+// --- Encoder ---
+// The payload is already in place behind the header; this fills the header in front of it
+size_t UplinkEncoder::frame(uint8_t* dst, UplinkKind kind, uint8_t slot, uint8_t type, size_t payloadBytes, uint32_t nowMs){
+    UplinkHeader_t header;
+    header.magic		= UPLINK_MAGIC;
+    header.version		= UPLINK_VERSION;
+    header.kind			= (uint8_t)kind;
+    header.hubId		= _hubId;
+    header.slot			= slot;
+    header.type			= type;
+    header.sequence		= _sequence++;
+    header.hubTimeMs	= nowMs;
+    header.payloadBytes	= (uint16_t)payloadBytes;
+    header.reserved		= 0;
+    header.check		= UplinkCodec::headerCheck(header);
+    memcpy(dst, &header, sizeof(header));
+    return sizeof(header) + payloadBytes;
+}
+
+size_t UplinkEncoder::hello(uint8_t* dst, size_t capacity, const char* name, int maxSensors, int fftSize, uint32_t nowMs){
+    if (capacity < sizeof(UplinkHeader_t) + sizeof(UplinkHello_t)) return 0;
+    UplinkHello_t hello;
+    memset(&hello, 0, sizeof(hello));
+    strncpy(hello.name, name, sizeof(hello.name) - 1);
+    hello.maxSensors	= (uint8_t)maxSensors;
+    hello.fftSize		= (uint16_t)fftSize;
+    memcpy(dst + sizeof(UplinkHeader_t), &hello, sizeof(hello));
+    return frame(dst, UPLINK_HELLO, 0, TYPE_UNKNOWN, sizeof(hello), nowMs);
+}
+
+size_t UplinkEncoder::features(uint8_t* dst, size_t capacity, const ProcessingChannel& channel, uint32_t nowMs){
+    const FeatureVector_t& f = channel.features();
+    const size_t len = offsetof(UplinkFeatures_t, bandEnergy) + sizeof(float) * f.bandCount;
+    if (capacity < sizeof(UplinkHeader_t) + len) return 0;
+    UplinkFeatures_t out;
+    out.rms				= f.rms;
+    out.peak			= f.peak;
+    out.crestFactor		= f.crestFactor;
+    out.kurtosis		= f.kurtosis;
+    out.peakHz			= f.peakHz;
+    out.peakMagnitude	= f.peakMagnitude;
+    out.bandCount		= f.bandCount;
+    out.state			= (uint8_t)channel.detector().state();
+    out.alarm			= (uint8_t)channel.detector().activeAlarm();
+    out.reserved		= 0;
+    memcpy(out.bandEnergy, f.bandEnergy, sizeof(float) * f.bandCount);
+    memcpy(dst + sizeof(UplinkHeader_t), &out, len);
+    return frame(dst, UPLINK_FEATURES, channel.slot(), channel.type(), len, nowMs);
+}
+
+size_t UplinkEncoder::spectrum(uint8_t* dst, size_t capacity, const ProcessingChannel& channel, uint32_t nowMs){
+    const DspPipeline& pipeline = channel.pipeline();
+    const int bins = pipeline.bins();
+    const size_t len = sizeof(UplinkSpectrum_t) + sizeof(uint16_t) * bins;
+    if (bins > UPLINK_MAX_BINS || capacity < sizeof(UplinkHeader_t) + len) return 0;
+
+    // Magnitudes are 0..max: unsigned 16-bit steps of max / 65535
+    const float* fft = pipeline.spectrum();
+    float fftMax = 0;
+    for (int i = 0; i < bins; i++) if (fft[i] > fftMax) fftMax = fft[i];
+
+    UplinkSpectrum_t header;
+    header.binHz	= pipeline.samplingFrequency() / pipeline.fftSize();
+    header.scale	= (fftMax > 0) ? fftMax / 65535.0f : 1.0f;
+    header.bins		= (uint16_t)bins;
+    header.reserved	= 0;
+    uint8_t* payload = dst + sizeof(UplinkHeader_t);
+    memcpy(payload, &header, sizeof(header));
+
+    uint16_t* out = (uint16_t*)(payload + sizeof(header));
+    const float inv = 1.0f / header.scale;
+    for (int i = 0; i < bins; i++) {
+        long q = lrintf(fft[i] * inv);
+        out[i] = (uint16_t)((q > 65535) ? 65535 : (q < 0) ? 0 : q);
+    }
+    return frame(dst, UPLINK_SPECTRUM, channel.slot(), channel.type(), len, nowMs);
+}
+
+size_t UplinkEncoder::alarm(uint8_t* dst, size_t capacity, const ProcessingChannel& channel, const AlarmEvent_t& event, uint32_t nowMs){
+    if (capacity < sizeof(UplinkHeader_t) + sizeof(UplinkAlarm_t)) return 0;
+    UplinkAlarm_t out;
+    memset(&out, 0, sizeof(out));
+    out.code		= (uint8_t)event.code;
+    out.frequencyHz	= event.frequencyHz;
+    out.value		= event.value;
+    out.limit		= event.limit;
+    memcpy(dst + sizeof(UplinkHeader_t), &out, sizeof(out));
+    return frame(dst, UPLINK_ALARM, channel.slot(), channel.type(), sizeof(out), nowMs);
+}
+
+size_t UplinkEncoder::raw(uint8_t* dst, size_t capacity, const InternalMessage_t& batch, uint32_t nowMs){
+    const bool codes = (batch.format == BATCH_CODES);
+    const size_t payloadBytes = (codes ? sizeof(int16_t) : sizeof(float)) * BATCH_SAMPLES;
+    const size_t len = sizeof(PacketHeaderV2_t) + payloadBytes;
+    if (capacity < sizeof(UplinkHeader_t) + len) return 0;
+
+    // The sensor's own header fields survive the trip; the samples are as the hub holds them
+    PacketHeaderV2_t packet;
+    SampleCodec::buildHeader(&packet, batch.type, batch.info.sensorId, codes ? ENC_INT16 : ENC_FLOAT32, BATCH_SAMPLES, batch.info.sequence,
+                             batch.info.timestampUs, batch.info.sampleRateHz, (uint16_t)payloadBytes, codes ? batch.info.scale : 1.0f, codes ? batch.info.offset : 0.0f);
+    uint8_t* payload = dst + sizeof(UplinkHeader_t);
+    memcpy(payload, &packet, sizeof(packet));
+    memcpy(payload + sizeof(packet), codes ? (const void*)batch.codes : (const void*)batch.data, payloadBytes);
+    return frame(dst, UPLINK_RAW, batch.sensorSlot, batch.type, len, nowMs);
+}
+
+// --- Decoders ---
+bool UplinkCodec::decodeHello(const uint8_t* payload, size_t len, UplinkHello_t* out){
+    if (len != sizeof(UplinkHello_t)) return false;
+    memcpy(out, payload, sizeof(*out));
+    out->name[UPLINK_NAME_BYTES - 1] = '\0';
+    return true;
+}
+
+bool UplinkCodec::decodeFeatures(const uint8_t* payload, size_t len, UplinkFeatures_t* out){
+    const size_t fixed = offsetof(UplinkFeatures_t, bandEnergy);
+    if (len < fixed) return false;
+    memcpy(out, payload, fixed);
+    if (out->bandCount > FEATURE_MAX_BANDS || len != fixed + sizeof(float) * out->bandCount) return false;
+    memcpy(out->bandEnergy, payload + fixed, sizeof(float) * out->bandCount);
+    return true;
+}
+
+bool UplinkCodec::decodeAlarm(const uint8_t* payload, size_t len, UplinkAlarm_t* out){
+    if (len != sizeof(UplinkAlarm_t)) return false;
+    memcpy(out, payload, sizeof(*out));
+    return true;
+}
+
+int UplinkCodec::decodeSpectrum(const uint8_t* payload, size_t len, float* out, int capacity, float* binHz){
+    UplinkSpectrum_t header;
+    if (len < sizeof(header)) return 0;
+    memcpy(&header, payload, sizeof(header));
+    if (header.bins == 0 || header.bins > capacity || len != sizeof(header) + sizeof(uint16_t) * header.bins) return 0;
+    const uint8_t* q = payload + sizeof(header);
+    for (int i = 0; i < header.bins; i++) {
+        uint16_t v;
+        memcpy(&v, q + sizeof(uint16_t) * i, sizeof(v));
+        out[i] = v * header.scale;
+    }
+    *binHz = header.binHz;
+    return header.bins;
+}
+
+bool UplinkCodec::decodeRaw(const uint8_t* payload, size_t len, uint8_t slot, InternalMessage_t* out){
+    PacketHeaderV2_t packet;
+    if (len < sizeof(packet)) return false;
+    memcpy(&packet, payload, sizeof(packet));
+    if (packet.header != PACKET_HEADER_V2 || packet.check != SampleCodec::headerCheck(packet) || packet.sampleCount != BATCH_SAMPLES
+        || len != sizeof(packet) + packet.payloadBytes) return false;
+
+    const uint8_t* samples = payload + sizeof(packet);
+    out->type				= (SensorDataType)packet.type;
+    out->sensorSlot			= slot;
+    out->info.version		= packet.version;
+    out->info.sensorId		= packet.sensorId;
+    out->info.encoding		= packet.encoding;
+    out->info.sampleRateHz	= packet.sampleRateHz;
+    out->info.sequence		= packet.sequence;
+    out->info.timestampUs	= packet.timestampUs;
+    out->info.scale			= packet.scale;
+    out->info.offset		= packet.offset;
+    if (SampleCodec::isIntegerEncoding(packet.encoding)) {
+        out->format = BATCH_CODES;
+        return SampleCodec::decodeCodes(packet.encoding, samples, packet.payloadBytes, BATCH_SAMPLES, out->codes);
+    }
+    out->format = BATCH_FLOAT;
+    return SampleCodec::decode(packet.encoding, samples, packet.payloadBytes, BATCH_SAMPLES, 1.0f, 0.0f, out->data);
+}
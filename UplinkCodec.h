@@ -0,0 +1,141 @@
+#ifndef UPLINK_CODEC_H
+#define UPLINK_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Protocol.h"
+#include "ProcessingChannel.h"
+
+#define UPLINK_MAGIC   0x5550	// "PU" on the wire (little-endian)
+#define UPLINK_VERSION 1
+#define UPLINK_DEFAULT_PORT 9100
+// Largest spectrum a hub forwards (a 4096-point FFT)
+#define UPLINK_MAX_BINS 2048
+#define UPLINK_NAME_BYTES 24
+
+// Hub -> gateway frame kinds
+enum UplinkKind {
+    UPLINK_HELLO = 1,        // UplinkHello_t, first frame of every connection
+    UPLINK_FEATURES,         // UplinkFeatures_t, every spectrum of a channel
+    UPLINK_SPECTRUM,         // UplinkSpectrum_t + bins uint16 magnitudes, at the dashboard's throttle
+    UPLINK_ALARM,            // UplinkAlarm_t, on every alarm state change
+    UPLINK_RAW,              // One v2 sensor packet (PacketHeaderV2_t + payload), the gateway runs the DSP
+    UPLINK_KIND_COUNT
+};
+
+// Every uplink frame: this header followed by payloadBytes (little-endian, 20 bytes)
+typedef struct __attribute__((packed)) {
+    uint16_t magic;          // UPLINK_MAGIC
+    uint8_t  version;        // UPLINK_VERSION
+    uint8_t  kind;           // UplinkKind
+    uint16_t hubId;
+    uint8_t  slot;           // Hub client slot of the sensor (0 for HELLO)
+    uint8_t  type;           // SensorDataType
+    uint32_t sequence;       // Per-hub frame counter, detects frames lost on the hub
+    uint32_t hubTimeMs;      // Hub clock when the frame was built
+    uint16_t payloadBytes;
+    uint8_t  reserved;
+    uint8_t  check;          // XOR of the previous 19 bytes
+} UplinkHeader_t;
+
+typedef struct __attribute__((packed)) {
+    char     name[UPLINK_NAME_BYTES];	// NUL-padded
+    uint8_t  maxSensors;
+    uint8_t  reserved;
+    uint16_t fftSize;
+} UplinkHello_t;
+
+// FeatureVector_t plus the detector state. Only bandCount bands are sent.
+typedef struct __attribute__((packed)) {
+    float    rms;
+    float    peak;
+    float    crestFactor;
+    float    kurtosis;
+    float    peakHz;
+    float    peakMagnitude;
+    uint8_t  bandCount;
+    uint8_t  state;          // AnomalyDetector::State
+    uint8_t  alarm;          // Active AlarmCode
+    uint8_t  reserved;
+    float    bandEnergy[FEATURE_MAX_BANDS];
+} UplinkFeatures_t;
+
+// Spectrum: magnitude[i] = q[i] * scale, bin i at i * binHz
+typedef struct __attribute__((packed)) {
+    float    binHz;
+    float    scale;
+    uint16_t bins;
+    uint16_t reserved;
+} UplinkSpectrum_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  code;           // AlarmCode, ALARM_NONE = back to normal
+    uint8_t  reserved[3];
+    float    frequencyHz;
+    float    value;
+    float    limit;
+} UplinkAlarm_t;
+
+inline const char* uplinkKindName(UplinkKind kind){
+    switch (kind) {
+        case UPLINK_HELLO:    return "hello";
+        case UPLINK_FEATURES: return "features";
+        case UPLINK_SPECTRUM: return "spectrum";
+        case UPLINK_ALARM:    return "alarm";
+        case UPLINK_RAW:      return "raw";
+        default:              return "unk";
+    }
+}
+
+// Largest payload of any frame kind
+#define UPLINK_MAX_PAYLOAD (sizeof(UplinkSpectrum_t) + sizeof(uint16_t) * UPLINK_MAX_BINS)
+
+// Builds the frames one hub sends (numbered with its own sequence counter) and decodes them on
+// the gateway. Platform neutral: the firmware's GatewayLink and the host stand-in hub in
+// tools/LoadGen encode with the same code the gateway (tools/Gateway) decodes with.
+class UplinkEncoder {
+	public:
+		explicit UplinkEncoder(uint16_t hubId = 0) : _hubId(hubId) {}
+
+		uint16_t hubId() const { return _hubId; }
+		// Next connection starts at sequence 0 again
+		void restart() { _sequence = 0; }
+
+		// Each returns the frame length, or 0 if it does not fit in `capacity`
+		size_t hello(uint8_t* dst, size_t capacity, const char* name, int maxSensors, int fftSize, uint32_t nowMs);
+		size_t features(uint8_t* dst, size_t capacity, const ProcessingChannel& channel, uint32_t nowMs);
+		size_t spectrum(uint8_t* dst, size_t capacity, const ProcessingChannel& channel, uint32_t nowMs);
+		size_t alarm(uint8_t* dst, size_t capacity, const ProcessingChannel& channel, const AlarmEvent_t& event, uint32_t nowMs);
+		// Float batches go out as ENC_FLOAT32, raw codes as ENC_INT16 with their scale / offset
+		size_t raw(uint8_t* dst, size_t capacity, const InternalMessage_t& batch, uint32_t nowMs);
+
+		// Bytes needed for any frame of a hub with this fftSize
+		static constexpr size_t maxFrameBytes(int fftSize){
+			return sizeof(UplinkHeader_t) + larger(sizeof(UplinkSpectrum_t) + sizeof(uint16_t) * (size_t)(fftSize / 2), sizeof(PacketHeaderV2_t) + sizeof(float) * BATCH_SAMPLES);
+		}
+
+	private:
+		uint16_t	_hubId;
+		uint32_t	_sequence = 0;
+
+		static constexpr size_t larger(size_t a, size_t b){ return (a > b) ? a : b; }
+		size_t frame(uint8_t* dst, UplinkKind kind, uint8_t slot, uint8_t type, size_t payloadBytes, uint32_t nowMs);
+};
+
+namespace UplinkCodec {
+
+// XOR check byte over every header byte before `check`
+uint8_t headerCheck(const UplinkHeader_t& header);
+
+// Payload -> values. False if the payload is malformed.
+bool decodeHello(const uint8_t* payload, size_t len, UplinkHello_t* out);
+bool decodeFeatures(const uint8_t* payload, size_t len, UplinkFeatures_t* out);
+bool decodeAlarm(const uint8_t* payload, size_t len, UplinkAlarm_t* out);
+// Magnitudes into out[0 .. capacity); returns the bin count, 0 if malformed or too large
+int decodeSpectrum(const uint8_t* payload, size_t len, float* out, int capacity, float* binHz);
+// A forwarded sensor packet, as SensorLink would have handed it over (format follows the encoding)
+bool decodeRaw(const uint8_t* payload, size_t len, uint8_t slot, InternalMessage_t* out);
+
+}
+
+#endif
\ No newline at end of file
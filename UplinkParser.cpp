@@ -0,0 +1,69 @@
+#include <string.h>
+#include "UplinkParser.h"
+
+static const size_t HEADER_BYTES = sizeof(UplinkHeader_t);
+
+void UplinkParser::reset(){
+    restart();
+    _inSync = true;
+    _haveSequence = false;
+    _lastSequence = 0;
+}
+
+void UplinkParser::restart(){
+    _fill = 0;
+    _need = HEADER_BYTES;
+    _complete = false;
+}
+
+uint8_t* UplinkParser::writePtr(){
+    if (_complete) restart();
+    return &_buffer[_fill];
+}
+
+bool UplinkParser::acceptHeader() const {
+    const UplinkHeader_t& h = header();
+    return h.magic == UPLINK_MAGIC && h.version == UPLINK_VERSION && h.check == UplinkCodec::headerCheck(h)
+        && h.kind >= UPLINK_HELLO && h.kind < UPLINK_KIND_COUNT && h.payloadBytes <= UPLINK_MAX_PAYLOAD;
+}
+
+// Drops bytes from the front until the buffer starts with the magic's lead byte again
+void UplinkParser::slideHeader(){
+    const uint8_t lead = (uint8_t)(UPLINK_MAGIC & 0xFF);
+    size_t skip = 1;
+    while (skip < _fill && _buffer[skip] != lead) skip++;
+    memmove(_buffer, _buffer + skip, _fill - skip);
+    _fill -= skip;
+    _droppedBytes += skip;
+}
+
+UplinkParser::Event UplinkParser::commit(size_t n){
+    if (n == 0) return EVENT_NONE;
+    _fill += n;
+    if (_fill < _need) return EVENT_NONE;
+
+    if (_need == HEADER_BYTES) {
+        if (!acceptHeader()) {
+            // Lost sync: count it once per episode
+            if (_inSync) { _resyncs++; _inSync = false; }
+            slideHeader();
+            return EVENT_NONE;
+        }
+        _inSync = true;
+        _need = HEADER_BYTES + header().payloadBytes;
+        if (_fill < _need) return EVENT_NONE;
+    }
+
+    // Sequence restarts at 0 with every connection (HELLO)
+    const UplinkHeader_t& h = header();
+    if (h.kind == UPLINK_HELLO) _haveSequence = false;
+    if (_haveSequence) {
+        int32_t delta = (int32_t)(h.sequence - _lastSequence);
+        if (delta > 1) _lost += (uint32_t)(delta - 1);
+    }
+    _lastSequence = h.sequence;
+    _haveSequence = true;
+    _frames++;
+    _complete = true;
+    return EVENT_FRAME;
+}
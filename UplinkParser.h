@@ -0,0 +1,56 @@
+#ifndef UPLINK_PARSER_H
+#define UPLINK_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "UplinkCodec.h"
+
+// Incremental parser for one hub's uplink stream on the gateway, used like PacketParser:
+//     n = recv(fd, parser.writePtr(), parser.want(), 0);
+//     if (parser.commit(n) == UplinkParser::EVENT_FRAME) handle(parser.header(), parser.payload());
+// Header and payload land in one buffer, so a frame is handled in place. A header with the
+// wrong magic, version or check byte makes it slide forward one byte at a time, as the hub does.
+class UplinkParser {
+	public:
+		enum Event {
+			EVENT_NONE = 0,
+			EVENT_FRAME			// header() / payload() hold a complete frame until the next commit
+		};
+
+		UplinkParser() { reset(); }
+		void reset();
+
+		size_t want() const { return _complete ? sizeof(UplinkHeader_t) : _need - _fill; }
+		uint8_t* writePtr();
+		Event commit(size_t n);
+
+		const UplinkHeader_t& header() const { return *(const UplinkHeader_t*)_buffer; }
+		const uint8_t* payload() const { return _buffer + sizeof(UplinkHeader_t); }
+
+		// --- Counters ---
+		uint32_t frames() const { return _frames; }
+		uint32_t droppedBytes() const { return _droppedBytes; }	// Bytes discarded while resyncing
+		uint32_t resyncs() const { return _resyncs; }
+		uint32_t lostFrames() const { return _lost; }			// Sequence gaps: frames the hub dropped
+
+	private:
+		uint8_t		_buffer[sizeof(UplinkHeader_t) + UPLINK_MAX_PAYLOAD];
+		size_t		_fill;
+		size_t		_need;
+		bool		_complete;
+		bool		_inSync;
+
+		bool		_haveSequence;
+		uint32_t	_lastSequence;
+
+		uint32_t	_frames = 0;
+		uint32_t	_droppedBytes = 0;
+		uint32_t	_resyncs = 0;
+		uint32_t	_lost = 0;
+
+		void restart();
+		bool acceptHeader() const;
+		void slideHeader();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include <math.h>
+#include <string.h>
+#include "DspPipeline.h"
+#include "RealFft.h"
+#include "ZoomFft.h"
+#include "MemoryArena.h"
+
+ZoomFft::ZoomFft(float centerHz, int points, int decimation, float samplingFrequency, int hopSize) : _centerHz(centerHz), _points(points), _decimation(decimation), _samplingFrequency(samplingFrequency){
+	_hopSize	= (hopSize <= 0 || hopSize > points) ? points / 4 : hopSize;
+	_taps		= ZOOM_TAPS_PER_DECIMATION * decimation;
+
+	// Lowpass at the decimated Nyquist, unity DC gain, shifted up to centerHz
+	_tapRe		= arenaNew<float>(_taps, MEM_FAST, "zoom");
+	_tapIm		= arenaNew<float>(_taps, MEM_FAST, "zoom");
+	const double w = 2.0 * M_PI * centerHz / samplingFrequency;
+	const double cutoff = 0.5 / decimation;
+	const double middle = 0.5 * (_taps - 1);
+	double gain = 0;
+	for (int k = 0; k < _taps; k++) {
+		double x = k - middle;
+		double sinc = (x == 0) ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+		double h = sinc * 0.5 * (1.0 - cos(2.0 * M_PI * (k + 0.5) / _taps));
+		_tapRe[k] = (float)h;
+		gain += h;
+	}
+	for (int k = 0; k < _taps; k++) {
+		double h = _tapRe[k] / gain;
+		_tapRe[k] = (float)(h * cos(w * k));
+		_tapIm[k] = (float)(h * sin(w * k));
+	}
+	_stepRe		= cos(w * decimation);
+	_stepIm		= -sin(w * decimation);
+
+	_baseband	= arenaNew<float>(2 * points, MEM_FAST, "zoom");
+	_work		= arenaNew<float>(2 * points, MEM_FAST, "zoom");
+	_spectrum	= arenaNew<float>(points, MEM_FAST, "zoom");
+	_window		= arenaNew<float>(points, MEM_FAST, "zoom");
+	_cos		= arenaNew<float>(points, MEM_FAST, "zoom");
+	_sin		= arenaNew<float>(points, MEM_FAST, "zoom");
+	RealFftDetail::buildComplexTables(points, _window, _cos, _sin);
+	reset();
+}
+
+ZoomFft::~ZoomFft(){
+	arenaDelete(_tapRe); arenaDelete(_tapIm);
+	arenaDelete(_baseband); arenaDelete(_work); arenaDelete(_spectrum);
+	arenaDelete(_window); arenaDelete(_cos); arenaDelete(_sin);
+}
+
+void ZoomFft::reset(){
+    memset(_baseband, 0, sizeof(float) * 2 * _points);
+    memset(_spectrum, 0, sizeof(float) * _points);
+    _basebandPos = 0;
+    _basebandFilled = 0;
+    _pending = 0;
+    _sinceLast = 0;
+    _rotRe = 1.0;
+    _rotIm = 0.0;
+}
+
+size_t ZoomFft::memoryBytes() const {
+    return sizeof(float) * (2 * (size_t)_taps + 8 * (size_t)_points);
+}
+
+bool ZoomFft::update(const DspPipeline& source, int newSamples){
+    bool ready = false;
+    _pending += newSamples;
+    while (_pending >= _decimation) {
+        // Decimated sample at the input of age _pending: y = e^(-jwt) * sum h[k] e^(jwk) x[t - k]
+        _pending -= _decimation;
+        float re = 0, im = 0;
+        for (int k = 0; k < _taps; k++) {
+            float x = source.recentSample(_pending + k);
+            re += _tapRe[k] * x;
+            im += _tapIm[k] * x;
+        }
+        float* y = &_baseband[2 * _basebandPos];
+        y[0] = (float)(re * _rotRe - im * _rotIm);
+        y[1] = (float)(re * _rotIm + im * _rotRe);
+        _basebandPos = (_basebandPos + 1) & (_points - 1);
+
+        // Advance the output phasor and keep it on the unit circle
+        double r = _rotRe * _stepRe - _rotIm * _stepIm;
+        _rotIm = _rotRe * _stepIm + _rotIm * _stepRe;
+        _rotRe = r;
+        double norm = 1.5 - 0.5 * (_rotRe * _rotRe + _rotIm * _rotIm);
+        _rotRe *= norm;
+        _rotIm *= norm;
+
+        if (_basebandFilled < _points) _basebandFilled++;
+        if (++_sinceLast >= _hopSize && _basebandFilled == _points) {
+            compute();
+            _sinceLast = 0;
+            ready = true;
+        }
+    }
+    return ready;
+}
+
+void ZoomFft::compute(){
+    // Oldest decimated sample first, windowed
+    for (int i = 0; i < _points; i++) {
+        const float* y = &_baseband[2 * ((_basebandPos + i) & (_points - 1))];
+        _work[2 * i] = y[0] * _window[i];
+        _work[2 * i + 1] = y[1] * _window[i];
+    }
+    RealFftDetail::complexFft(_points, _cos, _sin, _work);
+
+    // Negative frequencies first, so bin k is startHz() + k * binHz()
+    const int half = _points >> 1;
+    for (int k = 0; k < _points; k++) {
+        const float* x = &_work[2 * ((k + half) & (_points - 1))];
+        _spectrum[k] = sqrtf(x[0] * x[0] + x[1] * x[1]);
+    }
+    _frames++;
+}
@@ -0,0 +1,77 @@
+#ifndef ZOOM_FFT_H
+#define ZOOM_FFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SpectrumAnalysis.h"
+
+// Filter length per unit of decimation: Hann-windowed sinc, transition about fs / (8 * D) wide
+#define ZOOM_TAPS_PER_DECIMATION 16
+
+// Zoom FFT: high resolution in a narrow band around centerHz (e.g. the line frequency on
+// current sensors) without a huge real FFT.
+//   complex demodulation by centerHz -> lowpass -> decimate by D -> N-point complex FFT
+// Bins are fs / (D * N) apart and cover centerHz +- fs / (2 * D). The decimation filter
+// rolls off towards the band edges, so the middle three quarters of the bins are the clean ones.
+//
+// Demodulation and filter are one set of complex taps h[k] * e^(jwk) applied straight to the
+// pipeline's ring once per decimated sample, so the input is never copied or mixed in full.
+// Only the N decimated samples are kept. Magnitudes use the same window and scale as the
+// real FFT, so a tone reads the same in both; the band is not mean-removed.
+class ZoomFft : public SpectrumAnalysis {
+	public:
+		// points: power of two. decimation >= 2. hopSize in decimated samples (0 = points / 4).
+		ZoomFft(float centerHz, int points, int decimation, float samplingFrequency, int hopSize = 0);
+		~ZoomFft();
+
+		ZoomFft(const ZoomFft&) = delete;
+		ZoomFft& operator=(const ZoomFft&) = delete;
+
+		bool update(const DspPipeline& source, int newSamples) override;
+		void reset() override;
+		// A batch can finish several decimated samples, the oldest one newSamples back
+		int ringSamples(int newSamples) const override { return _taps + newSamples; }
+
+		const float* spectrum() const override { return _spectrum; }
+		int bins() const override { return _points; }
+		float startHz() const override { return _centerHz - 0.5f * _samplingFrequency / _decimation; }
+		float binHz() const override { return _samplingFrequency / ((float)_decimation * _points); }
+		uint32_t frames() const override { return _frames; }
+		size_t memoryBytes() const override;
+		const char* kindName() const override { return "zoom"; }
+
+		float centerHz() const { return _centerHz; }
+		int decimation() const { return _decimation; }
+
+	private:
+		float		_centerHz;
+		int			_points;
+		int			_decimation;
+		float		_samplingFrequency;
+		int			_hopSize;
+		int			_taps;				// Filter length, ZOOM_TAPS_PER_DECIMATION * decimation
+
+		float*		_tapRe;				// h[k] * cos(wk), h[k] * sin(wk); k = sample age
+		float*		_tapIm;
+		double		_rotRe = 1.0;		// e^(-jwt) at the current decimated sample
+		double		_rotIm = 0.0;
+		double		_stepRe;			// e^(-jwD)
+		double		_stepIm;
+
+		float*		_baseband;			// Ring of _points decimated complex samples
+		int			_basebandPos = 0;
+		int			_basebandFilled = 0;
+		int			_pending = 0;		// Input samples since the last decimated sample
+		int			_sinceLast = 0;		// Decimated samples since the last spectrum
+		uint32_t	_frames = 0;
+
+		float*		_window;
+		float*		_cos;				// W_2N^k, k < N, for RealFftDetail::complexFft
+		float*		_sin;
+		float*		_work;
+		float*		_spectrum;
+
+		void compute();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include "BenchAlloc.h"
+
+static std::atomic<size_t> g_bytes{0};
+static std::atomic<size_t> g_count{0};
+
+size_t BenchAlloc::bytes(){ return g_bytes.load(std::memory_order_relaxed); }
+size_t BenchAlloc::count(){ return g_count.load(std::memory_order_relaxed); }
+
+void* operator new(size_t size){
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    g_count.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size){ return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
@@ -0,0 +1,13 @@
+#ifndef BENCH_ALLOC_H
+#define BENCH_ALLOC_H
+
+#include <stddef.h>
+
+// Counts bytes requested through global operator new (see BenchAlloc.cpp),
+// so benchmarks can report allocations made in the hot path.
+namespace BenchAlloc {
+    size_t bytes();
+    size_t count();
+}
+
+#endif
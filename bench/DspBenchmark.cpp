@@ -0,0 +1,224 @@
+// Host benchmarks for the ProcessingCore signal chain.
+// Build: cmake -S . -B build && cmake --build build && ./build/dsp_benchmark
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "BenchAlloc.h"
+#include "DspPipeline.h"
+#include "MemoryArena.h"
+#include "SpectrumCodec.h"
+
+// Fills one sensor batch with a 50 Hz tone plus a 120 Hz harmonic, sampled at 1 kHz.
+static void fillBatch(float* dst, int n, int offset){
+    for (int i = 0; i < n; i++) {
+        float t = (float)(offset + i) / 1000.0f;
+        dst[i] = 512.0f + 100.0f * sinf(2.0f * (float)M_PI * 50.0f * t) + 20.0f * sinf(2.0f * (float)M_PI * 120.0f * t);
+    }
+}
+
+// --- Per-frame latency / frames per second ---
+// Arg = FFT points. Each iteration aggregates a full frame of BATCH_SAMPLES batches and runs the FFT.
+static void BM_DspFrame(benchmark::State& state){
+    const int points = (int)state.range(0);
+    const int aggregation = points / BATCH_SAMPLES;
+
+    size_t setupBytes = BenchAlloc::bytes();
+    DspPipeline pipeline(BATCH_SAMPLES, aggregation, 1000.0f);
+    setupBytes = BenchAlloc::bytes() - setupBytes;
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    fillBatch(batch.data(), BATCH_SAMPLES, 0);
+
+    size_t frameBytes = BenchAlloc::bytes();
+    for (auto _ : state) {
+        for (int b = 0; b < aggregation; b++) {
+            benchmark::DoNotOptimize(pipeline.pushBatch(batch.data()));
+        }
+        benchmark::DoNotOptimize(pipeline.spectrum()[1]);
+    }
+    frameBytes = BenchAlloc::bytes() - frameBytes;
+
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["setup_bytes"] = (double)setupBytes;
+    state.counters["bytes/frame"] = (double)frameBytes / (double)state.iterations();
+    state.SetItemsProcessed(state.iterations() * points);
+}
+BENCHMARK(BM_DspFrame)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// --- Same frame on the Q15 pipeline (12-bit ADC codes, fixed-point FFT) ---
+static void BM_DspFrameQ15(benchmark::State& state){
+    const int points = (int)state.range(0);
+    const int aggregation = points / BATCH_SAMPLES;
+
+    size_t setupBytes = BenchAlloc::bytes();
+    DspPipeline pipeline(BATCH_SAMPLES, aggregation, 1000.0f, 0, DSP_Q15);
+    setupBytes = BenchAlloc::bytes() - setupBytes;
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    std::vector<int16_t> codes(BATCH_SAMPLES);
+    fillBatch(batch.data(), BATCH_SAMPLES, 0);
+    for (int i = 0; i < BATCH_SAMPLES; i++) codes[i] = (int16_t)lrintf(4.0f * batch[i]);	// 0.25 units per code
+
+    for (auto _ : state) {
+        for (int b = 0; b < aggregation; b++) {
+            benchmark::DoNotOptimize(pipeline.pushCodes(codes.data(), 0.25f, 0.0f));
+        }
+        benchmark::DoNotOptimize(pipeline.spectrum()[1]);
+    }
+
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations(), benchmark::Counter::kIsRate);
+    state.counters["setup_bytes"] = (double)setupBytes;
+    state.SetItemsProcessed(state.iterations() * points);
+}
+BENCHMARK(BM_DspFrameQ15)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// --- FFT chain only, aggregation excluded ---
+static void BM_DspProcess(benchmark::State& state){
+    const int points = (int)state.range(0);
+    DspPipeline pipeline(BATCH_SAMPLES, points / BATCH_SAMPLES, 1000.0f);
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    for (int b = 0; b < points / BATCH_SAMPLES; b++) {
+        fillBatch(batch.data(), BATCH_SAMPLES, b * BATCH_SAMPLES);
+        pipeline.pushBatch(batch.data());
+    }
+
+    for (auto _ : state) {
+        pipeline.process();
+        benchmark::DoNotOptimize(pipeline.spectrum()[1]);
+    }
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_DspProcess)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// --- Each FFT backend built into this binary on one frame (Args = backend, points) ---
+static void BM_FftBackend(benchmark::State& state){
+    const int points = (int)state.range(1);
+    RealFftPlan* plan = createRealFftPlan(points, (int)state.range(0));
+    if (plan == nullptr) { state.SkipWithError("backend not built in"); return; }
+    state.SetLabel(plan->backendName());
+
+    std::vector<float> frame(points), out(points / 2);
+    for (int b = 0; b < points / BATCH_SAMPLES; b++) fillBatch(&frame[b * BATCH_SAMPLES], BATCH_SAMPLES, b * BATCH_SAMPLES);
+
+    for (auto _ : state) {
+        plan->magnitude(frame.data(), out.data(), 0);
+        benchmark::DoNotOptimize(out[1]);
+    }
+    state.counters["frames/s"] = benchmark::Counter((double)state.iterations(), benchmark::Counter::kIsRate);
+    arenaDestroy(plan);
+}
+BENCHMARK(BM_FftBackend)->ArgsProduct({ { REAL_FFT_PORTABLE, REAL_FFT_REFERENCE }, { 1024, 4096 } })->Unit(benchmark::kMicrosecond);
+
+// --- Sliding STFT: one batch in, one spectrum out (hop = BATCH_SAMPLES) ---
+static void BM_DspSliding(benchmark::State& state){
+    const int points = (int)state.range(0);
+    DspPipeline pipeline(BATCH_SAMPLES, points / BATCH_SAMPLES, 1000.0f, BATCH_SAMPLES);
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    fillBatch(batch.data(), BATCH_SAMPLES, 0);
+    for (int b = 0; b < points / BATCH_SAMPLES; b++) pipeline.pushBatch(batch.data());
+
+    int64_t spectra = 0;
+    for (auto _ : state) {
+        spectra += pipeline.pushBatch(batch.data());
+        benchmark::DoNotOptimize(pipeline.spectrum()[1]);
+    }
+    state.counters["spectra/s"] = benchmark::Counter((double)spectra, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_DspSliding)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// --- Per-batch cost of the extra analyses on a 1024-point channel ---
+// Arg 0 = none, 1 = 4096-point FFT analysis, 2 = 50 Hz zoom (256 points, decimation 16), 3 = both
+static void BM_DspMultiRes(benchmark::State& state){
+    const int analyses = (int)state.range(0);
+    DspPipeline pipeline(BATCH_SAMPLES, 4, 1000.0f);
+    if (analyses & 1) pipeline.addFftAnalysis(4096, 0);
+    if (analyses & 2) pipeline.addZoomAnalysis(50.0f, 256, 16, 0);
+    state.counters["dsp_bytes"] = (double)pipeline.memoryBytes();
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    int offset = 0;
+    for (auto _ : state) {
+        fillBatch(batch.data(), BATCH_SAMPLES, offset);
+        offset += BATCH_SAMPLES;
+        benchmark::DoNotOptimize(pipeline.pushBatch(batch.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SAMPLES);
+}
+BENCHMARK(BM_DspMultiRes)->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+
+// --- Binary dashboard frame encoding (spectrum + every 4th time sample) ---
+static void BM_SpectrumEncode(benchmark::State& state){
+    const int points = (int)state.range(0);
+    DspPipeline pipeline(BATCH_SAMPLES, points / BATCH_SAMPLES, 1000.0f);
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    for (int b = 0; b < points / BATCH_SAMPLES; b++) {
+        fillBatch(batch.data(), BATCH_SAMPLES, b * BATCH_SAMPLES);
+        pipeline.pushBatch(batch.data());
+    }
+
+    std::vector<uint8_t> frame(SpectrumCodec::frameSize(points / 2, points / 4));
+    size_t len = 0;
+    for (auto _ : state) {
+        len = SpectrumCodec::encode(frame.data(), frame.size(), TYPE_VIBRATION, 0, pipeline, 4);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.counters["frame_bytes"] = (double)len;
+    state.SetBytesProcessed(state.iterations() * (int64_t)len);
+}
+BENCHMARK(BM_SpectrumEncode)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// --- SSE "update" JSON: TextWriter against the sprintf loop it replaced ---
+// Both run on the same spectrum; the TextWriter output must be byte-identical or the run fails.
+static size_t spectrumJsonSprintf(char* dst, const DspPipeline& pipeline, int timeStride){
+    const float* fft = pipeline.spectrum();
+    int bins = pipeline.bins();
+    int n = pipeline.fftSize();
+    int len = sprintf(dst, "{\"type\":\"%s\",\"slot\":%d,\"fft\":[", "vib", 0);
+    for (int i = 0; i < bins; i++) {
+        len += sprintf(dst + len, "%.2f%s", fft[i], (i < bins - 1) ? "," : "]");
+    }
+    len += sprintf(dst + len, ",\"time\":[");
+    for (int i = 0; i < n; i += timeStride) {
+        len += sprintf(dst + len, "%.2f%s", pipeline.timeSample(i), (i < n - timeStride) ? "," : "]}");
+    }
+    return (size_t)len;
+}
+
+static void BM_SpectrumJson(benchmark::State& state){
+    const int points = (int)state.range(0);
+    const bool baseline = state.range(1) != 0;
+    DspPipeline pipeline(BATCH_SAMPLES, points / BATCH_SAMPLES, 1000.0f);
+
+    std::vector<float> batch(BATCH_SAMPLES);
+    for (int b = 0; b < points / BATCH_SAMPLES; b++) {
+        fillBatch(batch.data(), BATCH_SAMPLES, b * BATCH_SAMPLES);
+        pipeline.pushBatch(batch.data());
+    }
+
+    std::vector<char> expected(32 * points), json(32 * points);
+    size_t expectedLen = spectrumJsonSprintf(expected.data(), pipeline, 4);
+    size_t len = 0;
+    for (auto _ : state) {
+        if (baseline) {
+            len = spectrumJsonSprintf(json.data(), pipeline, 4);
+        } else {
+            TextWriter out(json.data(), json.size());
+            SpectrumCodec::writeJson(out, "vib", 0, pipeline, 4);
+            len = out.length();
+        }
+        benchmark::DoNotOptimize(json.data());
+    }
+    if (len != expectedLen || memcmp(json.data(), expected.data(), len) != 0) state.SkipWithError("JSON differs from the sprintf output");
+    state.SetLabel(baseline ? "sprintf" : "TextWriter");
+    state.counters["json_bytes"] = (double)len;
+    state.SetBytesProcessed(state.iterations() * (int64_t)len);
+}
+BENCHMARK(BM_SpectrumJson)->ArgsProduct({ { 1024, 4096 }, { 1, 0 } })->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,171 @@
+// DSP throughput against the number of DspScheduler workers.
+// Build: cmake -S . -B build && cmake --build build && ./build/scheduler_benchmark
+//
+// A producer thread stands in for CommunicationHub: it copies a tone into BatchPool slots, pushes
+// them onto the sensors' BatchRings (waiting for room, so nothing is dropped) and wakes the
+// workers DspScheduler::wakeMask() names. Worker threads run the ProcessingCore loop: claim a
+// sensor, pop one batch, aggregate / FFT / detect / features / average / JSON, release the slot.
+// Condition variables stand in for the task notifications.
+//
+// /workers/sensors/homed: homed = 1 is the ESP32 layout (every sensor on worker 0, the others
+// steal), 0 spreads the sensors over the workers. Every run checks that each sensor's batches
+// are processed in sequence order; a violation fails the benchmark.
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BatchPool.h"
+#include "DspScheduler.h"
+#include "ProcessingChannel.h"
+#include "SpectrumCodec.h"
+#include "TextWriter.h"
+
+static const int AGGREGATION_FACTOR = 4;		// 1024-point FFT, as on the hub
+static const int HOP_SIZE = 256;
+static const float SAMPLE_RATE = 1000.0f;
+static const int BATCHES_PER_RUN = 4096;
+static const size_t JSON_BYTES = 8192;		// PROC_JSON_BYTES
+
+// ulTaskNotifyTake / xTaskNotifyGive on std::thread
+class Wakeup {
+	public:
+		void give(){
+			std::lock_guard<std::mutex> lock(_mutex);
+			_count++;
+			_cv.notify_one();
+		}
+		void take(){
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait_for(lock, std::chrono::milliseconds(1), [this]{ return _count > 0; });
+			_count = 0;
+		}
+
+	private:
+		std::mutex _mutex;
+		std::condition_variable _cv;
+		uint32_t _count = 0;
+};
+
+static void BM_DspScheduler(benchmark::State& state){
+    const int workers = (int)state.range(0);
+    const int sensors = (int)state.range(1);
+    const bool homed = state.range(2) != 0;
+
+    // One vibration channel per sensor, kept across runs (plans and buffers are built once)
+    std::vector<std::unique_ptr<ProcessingChannel>> channels;
+    std::vector<std::vector<float>> tones(sensors, std::vector<float>(BATCH_SAMPLES));
+    for (int s = 0; s < sensors; s++) {
+        channels.emplace_back(new ProcessingChannel((uint8_t)s, TYPE_VIBRATION, BATCH_SAMPLES, AGGREGATION_FACTOR, SAMPLE_RATE, HOP_SIZE, 0));
+        // Whole cycles per batch, so back-to-back copies stay continuous
+        const float cycles = (float)(4 + s);
+        for (int i = 0; i < BATCH_SAMPLES; i++) tones[s][i] = sinf(2.0f * (float)M_PI * cycles * i / BATCH_SAMPLES);
+    }
+    std::vector<std::vector<char>> json(workers, std::vector<char>(JSON_BYTES));
+
+    uint64_t processed = 0;
+    uint64_t steals = 0;
+    for (auto _ : state) {
+        BatchPool pool(sensors * BATCH_RING_DEPTH + 2 * workers);
+        std::vector<BatchRing> rings(sensors);
+        DspScheduler scheduler(rings.data(), sensors, workers);
+        if (homed) {
+            for (int s = 0; s < sensors; s++) scheduler.setHome(s, 0);
+        }
+        std::vector<Wakeup> wakeups(workers);
+        std::vector<uint32_t> lastSequence(sensors, 0);		// Per sensor, touched only by its current owner
+        std::atomic<bool> done{false};
+        std::atomic<bool> ordered{true};
+
+        std::vector<std::thread> threads;
+        for (int w = 0; w < workers; w++) {
+            threads.emplace_back([&, w](){
+                uint8_t index;
+                for (;;) {
+                    wakeups[w].take();
+                    int lane;
+                    while ((lane = scheduler.claim(w)) >= 0) {
+                        if (rings[lane].pop(index)) {
+                            const InternalMessage_t& msg = *pool.slot(index);
+                            ProcessingChannel& channel = *channels[lane];
+                            if (msg.info.sequence != lastSequence[lane] + 1) ordered.store(false, std::memory_order_relaxed);
+                            lastSequence[lane] = msg.info.sequence;
+                            bool ready = channel.pushBatch(msg);
+                            pool.release(index, w);
+                            if (ready) {
+                                AlarmEvent_t alarm;
+                                channel.analyse(&alarm);
+                                channel.extractFeatures();
+                                channel.accumulate();
+                                TextWriter out(json[w].data(), JSON_BYTES);
+                                SpectrumCodec::writeJson(out, channel.typeName(), channel.slot(), channel.pipeline(), 4);
+                                benchmark::DoNotOptimize(out.length());
+                            }
+                        }
+                        scheduler.release(lane);
+                    }
+                    if (done.load(std::memory_order_acquire)) {
+                        bool empty = true;
+                        for (int s = 0; s < sensors && empty; s++) empty = rings[s].empty();
+                        if (empty) return;
+                    }
+                }
+            });
+        }
+
+        // Producer: round robin over the sensors, like evenly paced nodes
+        std::vector<uint32_t> sequence(sensors, 0);
+        for (int b = 0; b < BATCHES_PER_RUN; b++) {
+            const int s = b % sensors;
+            uint8_t index;
+            InternalMessage_t* msg;
+            while ((msg = pool.acquire(&index)) == nullptr) std::this_thread::yield();
+            msg->type = TYPE_VIBRATION;
+            msg->sensorSlot = (uint8_t)s;
+            msg->format = BATCH_FLOAT;
+            memset(&msg->info, 0, sizeof(msg->info));
+            msg->info.version = 1;
+            msg->info.sampleRateHz = (uint16_t)SAMPLE_RATE;
+            msg->info.sequence = ++sequence[s];
+            msg->info.scale = 1.0f;
+            memcpy(msg->data, tones[s].data(), sizeof(msg->data));
+            while (rings[s].size() >= BatchRing::capacity()) std::this_thread::yield();
+            rings[s].push(index);
+            const uint32_t wake = scheduler.wakeMask(s);
+            for (int w = 0; w < workers; w++) {
+                if (wake & (1u << w)) wakeups[w].give();
+            }
+        }
+        done.store(true, std::memory_order_release);
+        for (int w = 0; w < workers; w++) wakeups[w].give();
+        for (std::thread& t : threads) t.join();
+
+        if (!ordered.load()) {
+            state.SkipWithError("a sensor's batches were processed out of order");
+            return;
+        }
+        for (int s = 0; s < sensors; s++) {
+            if (lastSequence[s] != sequence[s]) {
+                state.SkipWithError("batches lost");
+                return;
+            }
+        }
+        processed += BATCHES_PER_RUN;
+        for (int w = 0; w < workers; w++) steals += scheduler.steals(w);
+    }
+
+    state.SetItemsProcessed((int64_t)processed);
+    state.counters["steals%"] = (processed > 0) ? 100.0 * (double)steals / (double)processed : 0.0;
+}
+
+BENCHMARK(BM_DspScheduler)->ArgNames({ "workers", "sensors", "homed" })->ArgsProduct({ { 1, 2, 4 }, { 8, 16 }, { 0, 1 } })
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+// Two-thread stress benchmark for the hub -> DSP handoff ring.
+// Build: cmake -S . -B build && cmake --build build && ./build/spsc_benchmark
+//
+// A producer thread pushes increasing sequence numbers while the benchmark thread pops them.
+// Every run checks that items come out in order, none is duplicated and
+// pushed == popped + dropped; any violation fails the benchmark.
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include "SpscRing.h"
+
+static const uint32_t ITEMS_PER_RUN = 1 << 18;
+
+// lossless = the producer retries refused pushes (DROP_NEWEST only) to measure raw handoff rate
+template<size_t Capacity>
+static void runRing(benchmark::State& state, typename SpscRing<uint32_t, Capacity>::OverflowPolicy policy, bool lossless = false){
+    typedef SpscRing<uint32_t, Capacity> Ring;
+    uint64_t popped = 0;
+    uint64_t dropped = 0;
+
+    for (auto _ : state) {
+        Ring ring(policy);
+        std::atomic<bool> done{false};
+        uint32_t evictedSum = 0;
+
+        std::thread producer([&](){
+            uint32_t evicted;
+            for (uint32_t seq = 1; seq <= ITEMS_PER_RUN; seq++) {
+                typename Ring::PushResult result = ring.push(seq, &evicted);
+                if (result == Ring::PUSHED_EVICTED) evictedSum++;
+                while (lossless && result == Ring::DROPPED) {
+                    std::this_thread::yield();
+                    result = ring.push(seq, &evicted);
+                }
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        uint32_t last = 0;
+        uint32_t count = 0;
+        bool ordered = true;
+        uint32_t item;
+        for (;;) {
+            if (ring.pop(item)) {
+                if (item <= last) ordered = false;
+                last = item;
+                count++;
+            } else if (done.load(std::memory_order_acquire)) {
+                // Producer finished: whatever is left is final
+                while (ring.pop(item)) {
+                    if (item <= last) ordered = false;
+                    last = item;
+                    count++;
+                }
+                break;
+            }
+        }
+        producer.join();
+
+        if (!ordered) {
+            state.SkipWithError("items popped out of order or twice");
+            return;
+        }
+        const uint32_t lost = lossless ? 0 : ring.dropped();
+        if (ring.pushed() + (policy == Ring::DROP_NEWEST ? lost : 0) != ITEMS_PER_RUN
+            || (uint64_t)count + lost != ITEMS_PER_RUN) {
+            state.SkipWithError("pushed != popped + dropped");
+            return;
+        }
+        if (policy == Ring::DROP_OLDEST && evictedSum != ring.dropped()) {
+            state.SkipWithError("evictions not reported to the producer");
+            return;
+        }
+        popped += count;
+        dropped += lost;
+    }
+
+    // Items offered by the producer per second, whatever happened to them
+    state.SetItemsProcessed((int64_t)(popped + dropped));
+    state.counters["dropped%"] = (popped + dropped > 0) ? 100.0 * (double)dropped / (double)(popped + dropped) : 0.0;
+}
+
+// Same depth as BatchRing: the consumer can barely keep up, most of the cost is contention
+static void BM_SpscDepth2DropOldest(benchmark::State& state){ runRing<2>(state, SpscRing<uint32_t, 2>::DROP_OLDEST); }
+static void BM_SpscDepth2DropNewest(benchmark::State& state){ runRing<2>(state, SpscRing<uint32_t, 2>::DROP_NEWEST); }
+
+// Deep ring: raw handoff throughput
+static void BM_SpscDepth1024DropOldest(benchmark::State& state){ runRing<1024>(state, SpscRing<uint32_t, 1024>::DROP_OLDEST); }
+static void BM_SpscDepth1024DropNewest(benchmark::State& state){ runRing<1024>(state, SpscRing<uint32_t, 1024>::DROP_NEWEST); }
+static void BM_SpscDepth1024Lossless(benchmark::State& state){ runRing<1024>(state, SpscRing<uint32_t, 1024>::DROP_NEWEST, true); }
+
+BENCHMARK(BM_SpscDepth2DropOldest)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SpscDepth2DropNewest)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SpscDepth1024DropOldest)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SpscDepth1024DropNewest)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_SpscDepth1024Lossless)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
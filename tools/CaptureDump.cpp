@@ -0,0 +1,153 @@
+// Reads post-mortem captures downloaded from http://192.168.4.1/capture.
+// Build: cmake -S . -B build && cmake --build build
+//
+//   capture_dump capture.bin            Summary of every capture in the download
+//   capture_dump capture.bin --csv      One line per raw batch: id,slot,type,ms,sample0..N
+//   capture_dump --simulate flash.img   Runs CaptureLog against an image file (FileFlashStore),
+//                                       with two "reboots", then dumps the image like a download
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "CaptureLog.h"
+#include "FileFlashStore.h"
+
+static const uint32_t SECTOR_SIZE = 4096;
+static const uint32_t PAGE_SIZE = 256;
+
+struct DumpState {
+    bool csv = false;
+    uint32_t capture = 0;		// Capture being summarised
+    int batches = 0;
+    int spectra = 0;
+    int badChecks = 0;
+};
+
+static void endCapture(DumpState& st){
+    if (st.capture != 0 && !st.csv) printf("  %d batches, %d spectra, %d bad checks\n", st.batches, st.spectra, st.badChecks);
+    st.batches = st.spectra = st.badChecks = 0;
+}
+
+static void visit(const CaptureRecordHeader_t& h, const uint8_t* payload, bool checkOk, void* ctx){
+    DumpState& st = *(DumpState*)ctx;
+    if (h.captureId != st.capture) {
+        endCapture(st);
+        st.capture = h.captureId;
+    }
+    if (!checkOk) { st.badChecks++; return; }
+
+    switch (h.kind) {
+        case CAPTURE_TRIGGER: {
+            CaptureTrigger_t t;
+            memcpy(&t, payload, sizeof(t));
+            if (!st.csv) printf("capture %u @ %u ms: slot %u type %d alarm %u (%.1f Hz, value %.2f, limit %.2f)\n",
+                                h.captureId, h.timestampMs, h.slot, t.type, t.alarmCode, t.frequencyHz, t.value, t.limit);
+            break;
+        }
+        case CAPTURE_BATCH: {
+            st.batches++;
+            if (!st.csv || h.length != sizeof(InternalMessage_t)) break;
+            InternalMessage_t msg;
+            memcpy(&msg, payload, sizeof(msg));
+            printf("%u,%u,%d,%u", h.captureId, msg.sensorSlot, msg.type, h.timestampMs);
+            for (int i = 0; i < BATCH_SAMPLES; i++) {
+                float v = (msg.format == BATCH_CODES) ? msg.info.offset + msg.info.scale * msg.codes[i] : msg.data[i];
+                printf(",%.4f", v);
+            }
+            printf("\n");
+            break;
+        }
+        case CAPTURE_SPECTRUM:
+            st.spectra++;
+            break;
+        default:
+            break;
+    }
+}
+
+static int dump(const std::vector<uint8_t>& data, bool csv){
+    DumpState st;
+    st.csv = csv;
+    int sectors = 0;
+    for (size_t off = 0; off + SECTOR_SIZE <= data.size(); off += SECTOR_SIZE) {
+        if (CaptureLog::walkSector(&data[off], SECTOR_SIZE, PAGE_SIZE, visit, &st) != 0) sectors++;
+    }
+    endCapture(st);
+    if (!csv) printf("%d log sectors\n", sectors);
+    return 0;
+}
+
+// --- Off-target run of the storage layer ---
+static void fillBatch(InternalMessage_t& msg, uint8_t slot, uint32_t seq){
+    memset(&msg, 0, sizeof(msg));
+    msg.type = (slot & 1) ? TYPE_CURRENT : TYPE_VIBRATION;
+    msg.sensorSlot = slot;
+    msg.info.sequence = seq;
+    for (int i = 0; i < BATCH_SAMPLES; i++) msg.data[i] = 512.0f + 100.0f * sinf(0.1f * (seq * BATCH_SAMPLES + i));
+}
+
+static int simulate(const char* image){
+    const uint32_t size = 64 * SECTOR_SIZE;
+    DspPipeline pipeline(BATCH_SAMPLES, 4, 1000.0f, 256);
+    InternalMessage_t msg;
+    uint32_t seq = 0, now = 0;
+
+    // Three boots, two captures each; the log must continue after the previous boot's sectors
+    for (int boot = 0; boot < 3; boot++) {
+        FileFlashStore store(image, size);
+        CaptureLog log(&store);
+        if (!log.begin()) { fprintf(stderr, "cannot open %s\n", image); return 1; }
+
+        for (int n = 0; n < 200; n++, seq++, now += 256) {
+            fillBatch(msg, seq % 2, seq);
+            log.recordBatch(msg, now);
+            if (pipeline.pushBatch(msg.data)) log.recordSpectrum(msg.sensorSlot, msg.type, pipeline, now);
+            if (n == 40 || n == 120) {
+                CaptureTrigger_t t = { 2, TYPE_VIBRATION, 50.0f, 123.0f, 80.0f };
+                log.trigger(msg.sensorSlot, t, now);
+            }
+            log.maintain();
+        }
+        printf("boot %d: %u captures, %u write errors, download %u bytes\n", boot, log.captures(), log.writeErrors(), log.logicalSize());
+
+        if (boot == 2) {
+            // Chunked like the web server, from the sector order at the start
+            std::vector<uint16_t> sectors(log.sectorCount());
+            std::vector<uint32_t> sequences(log.sectorCount());
+            int count = log.snapshot(sectors.data(), sequences.data(), log.sectorCount());
+            std::vector<uint8_t> download(log.logicalSize());
+            uint32_t off = 0;
+            while (off < download.size()) {
+                size_t n = log.readSnapshot(sectors.data(), sequences.data(), count, off, &download[off], 1460);
+                if (n == 0) break;
+                off += n;
+            }
+            if (off != download.size()) {
+                fprintf(stderr, "download ended after %u of %u bytes\n", off, (unsigned)download.size());
+                return 1;
+            }
+            return dump(download, false);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if (argc >= 3 && strcmp(argv[1], "--simulate") == 0) return simulate(argv[2]);
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s capture.bin [--csv] | --simulate flash.img\n", argv[0]);
+        return 2;
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if (f == nullptr) { perror(argv[1]); return 1; }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+
+    return dump(data, argc >= 3 && strcmp(argv[2], "--csv") == 0);
+}
@@ -0,0 +1,139 @@
+// Cross-backend FFT conformance: runs every RealFftPlan backend built into this binary
+// (and the Q15 engine) on the same frames and compares them bin by bin against a
+// double-precision DFT of the same windowed frame.
+// Build: cmake -S . -B build && cmake --build build && ./build/fft_conformance
+//
+// Errors are reported in dBFS: relative to the bin of a full-scale 12-bit sine, so frames
+// with little energy (the impulse) are not judged on float rounding of their DC offset.
+// Exits 1 if any backend is worse than its limit. Build the firmware sources with
+// -DREAL_FFT_BACKEND=... to change what DspPipeline uses; this tool always checks all of them.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "RealFft.h"
+#include "RealFftQ15.h"
+#include "MemoryArena.h"
+
+static const double FLOAT_LIMIT_DB = -90.0;			// float32 backends with table twiddles
+static const double REFERENCE_LIMIT_DB = -60.0;		// arduinoFFT twiddle recurrence drifts with n
+static const double Q15_LIMIT_DB = -60.0;			// int16 butterflies, 12-bit input
+static const double FULL_SCALE_CODES = 2048.0;
+
+// Test frame as ADC codes, so the Q15 engine sees exactly the same samples
+struct Frame {
+    const char* name;
+    std::vector<int16_t> codes;
+};
+
+static Frame makeFrame(const char* name, int n, int kind){
+    Frame f;
+    f.name = name;
+    f.codes.resize(n);
+    for (int i = 0; i < n; i++) {
+        double t = i / 1000.0, v = 2048.0;
+        switch (kind) {
+            case 0: v += 1500.0 * sin(2 * M_PI * 50.0 * t) + 40.0 * sin(2 * M_PI * 120.0 * t); break;	// Tone + harmonic
+            case 1: v += (rand() % 2001) - 1000; break;												// Broadband noise
+            case 2: v += (i == n / 3) ? 1800.0 : 0.0; break;										// Impulse
+            default: v += 1000.0 * sin(2 * M_PI * 0.37 * i); break;									// Near Nyquist
+        }
+        f.codes[i] = (int16_t)lrint(v);
+    }
+    return f;
+}
+
+// Ground truth: same DC removal and window as RealFftDetail::buildTables, DFT in double.
+// Returns the window sum (a full-scale sine of amplitude A peaks at A * sum / 2).
+static double referenceDft(const std::vector<double>& x, std::vector<double>& out){
+    const int n = (int)x.size();
+    double mean = 0;
+    for (double v : x) mean += v;
+    mean /= n;
+    std::vector<double> w(n);
+    double windowSum = 0;
+    for (int i = 0; i < n; i++) {
+        double weight = 0.54 * (1.0 - cos(2.0 * M_PI * i / (double)(n - 1)));
+        w[i] = (x[i] - mean) * weight;
+        windowSum += weight;
+    }
+    out.assign(n / 2, 0.0);
+    for (int k = 0; k < n / 2; k++) {
+        double re = 0, im = 0;
+        for (int i = 0; i < n; i++) {
+            double a = 2.0 * M_PI * (double)((long long)k * i % n) / n;
+            re += w[i] * cos(a);
+            im -= w[i] * sin(a);
+        }
+        out[k] = sqrt(re * re + im * im);
+    }
+    return windowSum;
+}
+
+// Worst bin error in dB relative to fullScale
+static double compare(const std::vector<double>& truth, const float* got, double fullScale, int* worstBin){
+    double err = 0;
+    for (size_t k = 0; k < truth.size(); k++) {
+        double e = fabs(got[k] - truth[k]);
+        if (e > err) { err = e; *worstBin = (int)k; }
+    }
+    if (err == 0) return -999.0;
+    return 20.0 * log10(err / fullScale);
+}
+
+int main(){
+    const int sizes[] = { 256, 1024, 4096 };
+    const char* names[] = { "tones", "noise", "impulse", "nyquist" };
+    const float scale = 3.3f / 4095.0f;
+    int failures = 0;
+
+    printf("%-10s %5s %-8s %6s %10s %8s\n", "backend", "n", "frame", "start", "err_dBFS", "bin");
+    for (int n : sizes) {
+        std::vector<RealFftPlan*> plans;
+        for (int backend = REAL_FFT_PORTABLE; backend <= REAL_FFT_ESPDSP; backend++) {
+            RealFftPlan* plan = createRealFftPlan(n, backend);
+            if (plan != nullptr) plans.push_back(plan);
+        }
+        RealFftQ15 q15(n);
+        std::vector<float> out(n / 2), ring(2 * n);
+        std::vector<int16_t> ringCodes(2 * n);
+
+        srand(1);
+        for (int kind = 0; kind < 4; kind++) {
+            Frame f = makeFrame(names[kind], n, kind);
+            std::vector<double> x(n), truth;
+            for (int i = 0; i < n; i++) x[i] = scale * f.codes[i];
+            const double fullScale = FULL_SCALE_CODES * scale * referenceDft(x, truth) / 2.0;
+
+            // Also read the frame as a ring buffer starting mid-way, like DspPipeline does,
+            // and as the newest n samples of a ring twice as long (shared multi-resolution ring)
+            for (int start : { 0, n / 3, 2 * n - n / 4 }) {
+                const int ringSize = (start < n) ? n : 2 * n;
+                for (int i = 0; i < n; i++) {
+                    ring[(start + i) % ringSize] = (float)x[i];
+                    ringCodes[(start + i) % ringSize] = f.codes[i];
+                }
+                for (RealFftPlan* plan : plans) {
+                    int bin = 0;
+                    plan->magnitude(ring.data(), out.data(), start, ringSize);
+                    double db = compare(truth, out.data(), fullScale, &bin);
+                    bool ok = db <= ((strcmp(plan->backendName(), "reference") == 0) ? REFERENCE_LIMIT_DB : FLOAT_LIMIT_DB);
+                    failures += !ok;
+                    printf("%-10s %5d %-8s %6d %10.1f %8d%s\n", plan->backendName(), n, f.name, start, db, bin, ok ? "" : "  FAIL");
+                }
+                int bin = 0;
+                q15.magnitude(ringCodes.data(), out.data(), start, scale, ringSize);
+                double db = compare(truth, out.data(), fullScale, &bin);
+                bool ok = db <= Q15_LIMIT_DB;
+                failures += !ok;
+                printf("%-10s %5d %-8s %6d %10.1f %8d%s\n", "q15", n, f.name, start, db, bin, ok ? "" : "  FAIL");
+            }
+        }
+        for (RealFftPlan* plan : plans) arenaDestroy(plan);
+    }
+
+    printf(failures ? "%d FAILED\n" : "all backends conform\n", failures);
+    return failures ? 1 : 0;
+}
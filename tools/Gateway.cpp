@@ -0,0 +1,807 @@
+// Gateway: collects the uplinks of many hubs on one Linux machine, keeps their history in a
+// time-partitioned columnar store and serves one dashboard across all of them.
+// Build: cmake -S . -B build && cmake --build build
+//
+//   gateway --store ./gateway-store                       Hubs connect to port 9100, dashboard on http://localhost:8080/
+//   load_gen --hub --hubs 8 --nodes 16 --uplink 127.0.0.1:9100   Eight stand-in hubs on this machine (tools/LoadGen)
+//
+// Options:
+//   --port N           Uplink port the hubs connect to (9100, UPLINK_DEFAULT_PORT)
+//   --http N           Dashboard / API port (8080)
+//   --store DIR        Store directory (./gateway-store), reopened and appended to across runs
+//   --partition-s S    Time covered by one store partition (3600)
+//   --retain-h H       Partitions older than this are dropped (168), 0 = keep everything
+//   --max-hubs N       Concurrent hub connections (64)
+//   --duration S       Exit after S seconds and print a summary (0 = until Ctrl-C)
+//
+// Hubs send features for every spectrum, the spectrum itself at their dashboard throttle and
+// alarm changes (UplinkCodec.h). A hub that forwards raw batches instead (GatewayLink
+// setForwardRaw, load_gen --uplink-raw) gets its DSP run here, by the same ProcessingChannel
+// code as on the ESP32, and its results are stored like a processing hub's.
+//
+// HTTP API (JSON):
+//   /api/hubs                                       Connected hubs and their uplink counters
+//   /api/sources                                    Latest features of every (hub, slot, type)
+//   /api/spectrum?hub=1&slot=0&type=vib             Latest spectrum of one source
+//   /api/history?hub=1&slot=0&type=vib&field=rms&minutes=60&points=240
+//                                                   One feature from the store, max per time bucket
+//   /api/alarms?minutes=60                          Alarm changes from the store
+//   /metrics                                        Prometheus counters
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "ColumnStore.h"
+#include "ProcessingChannel.h"
+#include "TextWriter.h"
+#include "UplinkCodec.h"
+#include "UplinkParser.h"
+
+// DSP settings for raw-forwarding hubs, the firmware's (Esp32ServerRefactored.ino / ProcessingCore)
+static const int AGGREGATION_FACTOR = 4;
+static const int HOP_SIZE = 256;
+static const int LEARN_FRAMES = 50;
+static const float DEFAULT_SAMPLE_RATE = 1000.0f;
+static const float DEFAULT_RUNNING_HZ = 25.0f;
+static const int RUNNING_HARMONICS = 3;
+static const uint32_t SPECTRUM_INTERVAL_MS = 5000;
+
+// Stored spectra are cut down to this many bins (max of the merged bins)
+static const int STORE_BINS = 1024;
+// Largest HTTP request read, and the chunk the JSON is built in
+static const size_t HTTP_REQUEST_BYTES = 4096;
+static const size_t JSON_CHUNK_BYTES = 4096;
+// Source of a row: hub << 16 | slot << 8 | type
+static inline uint32_t sourceKey(uint16_t hub, uint8_t slot, uint8_t type){ return ((uint32_t)hub << 16) | ((uint32_t)slot << 8) | type; }
+
+static uint64_t wallMs(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static volatile sig_atomic_t s_stop = 0;
+
+// --- Store schema ---
+static const ColumnSpec_t FEATURE_COLUMNS[] = {
+    { "source", 4 }, { "rms", 4 }, { "peak", 4 }, { "crest", 4 }, { "kurtosis", 4 }, { "peak_hz", 4 }, { "peak_mag", 4 },
+    { "state", 1 }, { "alarm", 1 }, { "band_count", 1 }, { "bands", 4 * FEATURE_MAX_BANDS }
+};
+enum FeatureColumn { F_SOURCE, F_RMS, F_PEAK, F_CREST, F_KURTOSIS, F_PEAK_HZ, F_PEAK_MAG, F_STATE, F_ALARM, F_BAND_COUNT, F_BANDS, F_COUNT };
+
+static const ColumnSpec_t SPECTRUM_COLUMNS[] = {
+    { "source", 4 }, { "bin_hz", 4 }, { "scale", 4 }, { "bins", 2 }, { "magnitudes", 2 * STORE_BINS }
+};
+enum SpectrumColumn { S_SOURCE, S_BIN_HZ, S_SCALE, S_BINS, S_MAGNITUDES, S_COUNT };
+
+static const ColumnSpec_t ALARM_COLUMNS[] = {
+    { "source", 4 }, { "code", 1 }, { "hz", 4 }, { "value", 4 }, { "limit", 4 }
+};
+enum AlarmColumn { A_SOURCE, A_CODE, A_HZ, A_VALUE, A_LIMIT, A_COUNT };
+
+// Columns a /api/history field can name
+static const struct { const char* name; int column; } HISTORY_FIELDS[] = {
+    { "rms", F_RMS }, { "peak", F_PEAK }, { "crest", F_CREST }, { "kurtosis", F_KURTOSIS }, { "peak_hz", F_PEAK_HZ }, { "peak_mag", F_PEAK_MAG }
+};
+
+struct Options {
+    int port = UPLINK_DEFAULT_PORT;
+    int http = 8080;
+    std::string store = "./gateway-store";
+    uint32_t partitionSeconds = 3600;
+    double retainHours = 168;
+    int maxHubs = 64;
+    double duration = 0;
+};
+
+// --- Gateway ---
+class Gateway {
+	public:
+		explicit Gateway(const Options& opt);
+		~Gateway();
+
+		bool start();
+		void run();
+		void report() const;
+
+	private:
+		// One hub connection
+		struct Hub {
+			int			fd = -1;
+			uint16_t	id = 0;
+			bool		greeted = false;
+			UplinkHello_t hello = {};
+			UplinkParser parser;
+			UplinkEncoder local;			// Raw forwarding: frames for the DSP results run here
+			uint32_t	frames[UPLINK_KIND_COUNT] = {};
+			uint64_t	bytes = 0;
+			uint32_t	badPayloads = 0;
+			uint64_t	connectedMs = 0;
+		};
+
+		// Latest state of one (hub, slot, type)
+		struct Source {
+			uint16_t	hub;
+			uint8_t		slot;
+			SensorDataType type;
+			UplinkFeatures_t features = {};
+			std::vector<float> spectrum;
+			float		binHz = 0;
+			uint8_t		alarm = ALARM_NONE;
+			uint64_t	seenMs = 0;
+			uint32_t	featureFrames = 0;
+			ProcessingChannel* channel = nullptr;	// Raw forwarding only
+		};
+
+		const Options&	_opt;
+		int				_listen = -1;
+		int				_httpListen = -1;
+		std::vector<Hub*> _hubs;
+		std::map<uint32_t, Source> _sources;
+		std::string		_hubNames[1 << 16];		// Last HELLO name per hub id, kept after it disconnects
+
+		ColumnStore		_features;
+		ColumnStore		_spectra;
+		ColumnStore		_alarms;
+
+		uint64_t		_startMs = 0;
+		uint64_t		_lastRetentionMs = 0;
+		uint32_t		_framesTotal[UPLINK_KIND_COUNT] = {};
+		uint32_t		_rejected = 0;
+		uint32_t		_httpRequests = 0;
+		uint32_t		_storeErrors = 0;
+		uint32_t		_rawSpectra = 0;
+		uint8_t			_frame[UplinkEncoder::maxFrameBytes(2 * UPLINK_MAX_BINS)];
+
+		void acceptHub();
+		void readHub(Hub* hub);
+		void closeHub(Hub* hub);
+		void handleFrame(Hub* hub, const UplinkHeader_t& h, const uint8_t* payload);
+		void handleRaw(Hub* hub, const UplinkHeader_t& h, const uint8_t* payload);
+		Source& source(uint16_t hub, uint8_t slot, uint8_t type);
+		void storeFeatures(uint32_t key, const UplinkFeatures_t& f, uint64_t now);
+		void storeSpectrum(uint32_t key, const float* magnitudes, int bins, float binHz, uint64_t now);
+		void storeAlarm(uint32_t key, const UplinkAlarm_t& a, uint64_t now);
+		void applyRetention(uint64_t now);
+
+		void serveHttp(int fd);
+		void sendResponse(int fd, int status, const char* contentType, const std::string& body);
+		void apiHubs(TextWriter& out);
+		void apiSources(TextWriter& out);
+		bool apiSpectrum(TextWriter& out, const std::string& query);
+		bool apiHistory(TextWriter& out, const std::string& query);
+		void apiAlarms(TextWriter& out, const std::string& query);
+		void metrics(std::string& out);
+};
+
+static int listenOn(int port){
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        perror("listen");
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+Gateway::Gateway(const Options& opt)
+	: _opt(opt),
+	  _features((opt.store + "/features").c_str(), FEATURE_COLUMNS, F_COUNT, opt.partitionSeconds, 65536),
+	  _spectra((opt.store + "/spectra").c_str(), SPECTRUM_COLUMNS, S_COUNT, opt.partitionSeconds, 8192),
+	  _alarms((opt.store + "/alarms").c_str(), ALARM_COLUMNS, A_COUNT, opt.partitionSeconds, 4096){
+}
+
+Gateway::~Gateway(){
+    for (Hub* hub : _hubs) { close(hub->fd); delete hub; }
+    for (auto& s : _sources) delete s.second.channel;
+    if (_listen >= 0) close(_listen);
+    if (_httpListen >= 0) close(_httpListen);
+}
+
+bool Gateway::start(){
+    mkdir(_opt.store.c_str(), 0755);
+    if (!_features.open() || !_spectra.open() || !_alarms.open()) {
+        fprintf(stderr, "%s: cannot open the store\n", _opt.store.c_str());
+        return false;
+    }
+    _listen = listenOn(_opt.port);
+    _httpListen = listenOn(_opt.http);
+    _startMs = wallMs();
+    _lastRetentionMs = _startMs;
+    return _listen >= 0 && _httpListen >= 0;
+}
+
+void Gateway::run(){
+    std::vector<pollfd> polls;
+    while (!s_stop) {
+        polls.clear();
+        polls.push_back({ _listen, POLLIN, 0 });
+        polls.push_back({ _httpListen, POLLIN, 0 });
+        for (Hub* hub : _hubs) polls.push_back({ hub->fd, POLLIN, 0 });
+        int ready = poll(polls.data(), polls.size(), 100);
+
+        const uint64_t now = wallMs();
+        if (_opt.duration > 0 && now - _startMs >= _opt.duration * 1000) break;
+        if (now - _lastRetentionMs >= 60000) applyRetention(now);
+        if (ready <= 0) continue;
+
+        if (polls[0].revents & POLLIN) acceptHub();
+        if (polls[1].revents & POLLIN) {
+            int fd = accept(_httpListen, nullptr, nullptr);
+            if (fd >= 0) serveHttp(fd);
+        }
+        // Hubs that went away are removed after the loop, the poll list indexes _hubs
+        for (size_t i = 0; i < polls.size() - 2; i++) {
+            if (polls[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) readHub(_hubs[i]);
+        }
+        for (size_t i = 0; i < _hubs.size();) {
+            if (_hubs[i]->fd < 0) { delete _hubs[i]; _hubs.erase(_hubs.begin() + i); }
+            else i++;
+        }
+    }
+}
+
+// --- Hub connections ---
+void Gateway::acceptHub(){
+    int fd = accept(_listen, nullptr, nullptr);
+    if (fd < 0) return;
+    if ((int)_hubs.size() >= _opt.maxHubs) {
+        close(fd);
+        _rejected++;
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    Hub* hub = new Hub();
+    hub->fd = fd;
+    hub->connectedMs = wallMs();
+    _hubs.push_back(hub);
+}
+
+void Gateway::closeHub(Hub* hub){
+    close(hub->fd);
+    hub->fd = -1;
+    if (hub->greeted) printf("hub %u (%s) disconnected: %u frames, %u lost\n", hub->id, hub->hello.name, hub->parser.frames(), hub->parser.lostFrames());
+}
+
+void Gateway::readHub(Hub* hub){
+    for (;;) {
+        ssize_t got = recv(hub->fd, hub->parser.writePtr(), hub->parser.want(), MSG_DONTWAIT);
+        if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            closeHub(hub);
+            return;
+        }
+        if (got < 0) return;
+        hub->bytes += got;
+        if (hub->parser.commit(got) == UplinkParser::EVENT_FRAME) handleFrame(hub, hub->parser.header(), hub->parser.payload());
+    }
+}
+
+Gateway::Source& Gateway::source(uint16_t hub, uint8_t slot, uint8_t type){
+    Source& s = _sources[sourceKey(hub, slot, type)];
+    s.hub = hub;
+    s.slot = slot;
+    s.type = (SensorDataType)type;
+    return s;
+}
+
+void Gateway::handleFrame(Hub* hub, const UplinkHeader_t& h, const uint8_t* payload){
+    const uint64_t now = wallMs();
+    const uint32_t key = sourceKey(h.hubId, h.slot, h.type);
+    hub->frames[h.kind]++;
+    _framesTotal[h.kind]++;
+
+    switch (h.kind) {
+        case UPLINK_HELLO:
+            if (!UplinkCodec::decodeHello(payload, h.payloadBytes, &hub->hello)) break;
+            hub->id = h.hubId;
+            hub->greeted = true;
+            hub->local = UplinkEncoder(h.hubId);
+            _hubNames[h.hubId] = hub->hello.name;
+            printf("hub %u (%s) connected: %u sensors, %u-point FFT\n", h.hubId, hub->hello.name, hub->hello.maxSensors, hub->hello.fftSize);
+            return;
+
+        case UPLINK_FEATURES: {
+            Source& s = source(h.hubId, h.slot, h.type);
+            if (!UplinkCodec::decodeFeatures(payload, h.payloadBytes, &s.features)) break;
+            s.alarm = s.features.alarm;
+            s.seenMs = now;
+            s.featureFrames++;
+            storeFeatures(key, s.features, now);
+            return;
+        }
+
+        case UPLINK_SPECTRUM: {
+            Source& s = source(h.hubId, h.slot, h.type);
+            s.spectrum.resize(UPLINK_MAX_BINS);
+            int bins = UplinkCodec::decodeSpectrum(payload, h.payloadBytes, s.spectrum.data(), UPLINK_MAX_BINS, &s.binHz);
+            s.spectrum.resize(bins);
+            if (bins == 0) break;
+            s.seenMs = now;
+            storeSpectrum(key, s.spectrum.data(), bins, s.binHz, now);
+            return;
+        }
+
+        case UPLINK_ALARM: {
+            UplinkAlarm_t a;
+            if (!UplinkCodec::decodeAlarm(payload, h.payloadBytes, &a)) break;
+            Source& s = source(h.hubId, h.slot, h.type);
+            s.alarm = a.code;
+            storeAlarm(key, a, now);
+            return;
+        }
+
+        case UPLINK_RAW:
+            handleRaw(hub, h, payload);
+            return;
+
+        default:
+            break;
+    }
+    hub->badPayloads++;
+}
+
+// Runs the hub's per-batch processing (ProcessingCore::handleBatch) and feeds the features and
+// spectra back through handleFrame as the frames a processing hub would have sent
+void Gateway::handleRaw(Hub* hub, const UplinkHeader_t& h, const uint8_t* payload){
+    InternalMessage_t batch;
+    if (!UplinkCodec::decodeRaw(payload, h.payloadBytes, h.slot, &batch)) {
+        hub->badPayloads++;
+        return;
+    }
+    Source& s = source(h.hubId, h.slot, batch.type);
+    if (s.channel == nullptr) {
+        float fs = (batch.info.sampleRateHz > 0) ? (float)batch.info.sampleRateHz : DEFAULT_SAMPLE_RATE;
+        s.channel = new ProcessingChannel(h.slot, batch.type, BATCH_SAMPLES, AGGREGATION_FACTOR, fs, HOP_SIZE, SPECTRUM_INTERVAL_MS,
+                                          (batch.format == BATCH_CODES) ? DSP_Q15 : DSP_FLOAT32);
+        s.channel->extractor().setHarmonicBands(DEFAULT_RUNNING_HZ, RUNNING_HARMONICS);
+        s.channel->detector().startLearning(LEARN_FRAMES);
+    }
+    ProcessingChannel* channel = s.channel;
+    if (!channel->pushBatch(batch)) return;
+
+    const uint32_t hubMs = h.hubTimeMs;
+    _rawSpectra++;
+    // Alarm changes are not re-sent: the hub's own detector sees the same batches and sends them
+    AlarmEvent_t alarm;
+    channel->analyse(&alarm);
+    channel->extractFeatures();
+    channel->accumulate();
+    size_t len = hub->local.features(_frame, sizeof(_frame), *channel, hubMs);
+    if (len > 0) handleFrame(hub, *(const UplinkHeader_t*)_frame, _frame + sizeof(UplinkHeader_t));
+    if (channel->publishDue((uint32_t)wallMs())) {
+        len = hub->local.spectrum(_frame, sizeof(_frame), *channel, hubMs);
+        if (len > 0) handleFrame(hub, *(const UplinkHeader_t*)_frame, _frame + sizeof(UplinkHeader_t));
+    }
+}
+
+// --- Store ---
+void Gateway::storeFeatures(uint32_t key, const UplinkFeatures_t& f, uint64_t now){
+    float bands[FEATURE_MAX_BANDS] = {};
+    memcpy(bands, f.bandEnergy, sizeof(float) * f.bandCount);
+    const void* values[F_COUNT] = { &key, &f.rms, &f.peak, &f.crestFactor, &f.kurtosis, &f.peakHz, &f.peakMagnitude,
+                                    &f.state, &f.alarm, &f.bandCount, bands };
+    if (!_features.append(now, values)) _storeErrors++;
+}
+
+void Gateway::storeSpectrum(uint32_t key, const float* magnitudes, int bins, float binHz, uint64_t now){
+    // Longer spectra keep the largest of each group of bins
+    const int merge = (bins + STORE_BINS - 1) / STORE_BINS;
+    const int stored = (bins + merge - 1) / merge;
+    float merged[STORE_BINS];
+    float peak = 0;
+    for (int i = 0; i < stored; i++) {
+        float m = 0;
+        for (int k = i * merge; k < (i + 1) * merge && k < bins; k++) m = fmaxf(m, magnitudes[k]);
+        merged[i] = m;
+        peak = fmaxf(peak, m);
+    }
+    uint16_t q[STORE_BINS] = {};
+    const float scale = (peak > 0) ? peak / 65535.0f : 1.0f;
+    for (int i = 0; i < stored; i++) q[i] = (uint16_t)lrintf(merged[i] / scale);
+    const float storedHz = binHz * merge;
+    const uint16_t count = (uint16_t)stored;
+    const void* values[S_COUNT] = { &key, &storedHz, &scale, &count, q };
+    if (!_spectra.append(now, values)) _storeErrors++;
+}
+
+void Gateway::storeAlarm(uint32_t key, const UplinkAlarm_t& a, uint64_t now){
+    const void* values[A_COUNT] = { &key, &a.code, &a.frequencyHz, &a.value, &a.limit };
+    if (!_alarms.append(now, values)) _storeErrors++;
+}
+
+void Gateway::applyRetention(uint64_t now){
+    _lastRetentionMs = now;
+    if (_opt.retainHours <= 0) return;
+    const uint64_t before = now - (uint64_t)(_opt.retainHours * 3600e3);
+    int dropped = _features.dropBefore(before) + _spectra.dropBefore(before) + _alarms.dropBefore(before);
+    if (dropped > 0) printf("retention: dropped %d partitions\n", dropped);
+}
+
+// --- HTTP ---
+static const char GATEWAY_HTML[] = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Gateway</title>
+<style>
+body{font-family:sans-serif;margin:16px;background:#f4f4f4}table{border-collapse:collapse;background:#fff}
+td,th{padding:4px 10px;border-bottom:1px solid #ddd;text-align:right}tr.sel{background:#dde8ff}tr:hover{cursor:pointer}
+.alarm{color:#c00;font-weight:bold}canvas{background:#fff;border:1px solid #ccc;margin-top:12px}
+</style></head><body>
+<h2>Line overview</h2>
+<div id="hubs"></div>
+<table id="sources"><thead><tr><th>Hub</th><th>Slot</th><th>Type</th><th>RMS</th><th>Peak Hz</th><th>Crest</th><th>Kurtosis</th><th>State</th><th>Alarm</th><th>Age s</th></tr></thead><tbody></tbody></table>
+<canvas id="spectrum" width="900" height="220"></canvas>
+<canvas id="history" width="900" height="160"></canvas>
+<script>
+const states=["uncalibrated","learning","monitoring"];
+const alarms=["","VIB: HIGH ENERGY","VIB: FREQ SPIKE","CUR: OVERLOAD (JAM)","CUR: UNDERLOAD (DRY)","CUR: ARCING"];
+let sel=null;
+function plot(id,xs,ys,label){
+  const c=document.getElementById(id),g=c.getContext("2d");g.clearRect(0,0,c.width,c.height);
+  if(!ys.length)return;const max=Math.max(...ys)||1;g.beginPath();
+  ys.forEach((y,i)=>{const px=i*c.width/ys.length,py=c.height-4-(c.height-20)*y/max;i?g.lineTo(px,py):g.moveTo(px,py);});
+  g.strokeStyle="#2a62c9";g.stroke();g.fillText(label+"  max "+max.toFixed(2),6,12);
+}
+async function refresh(){
+  const hubs=await (await fetch("/api/hubs")).json();
+  document.getElementById("hubs").textContent=hubs.hubs.length+" hubs connected, "+hubs.hubs.map(h=>h.name+" ("+h.id+")").join(", ");
+  const src=await (await fetch("/api/sources")).json();const body=document.querySelector("#sources tbody");body.innerHTML="";
+  src.sources.forEach(s=>{const tr=document.createElement("tr");const key=s.hub+"/"+s.slot+"/"+s.type;if(key==sel)tr.className="sel";
+    tr.innerHTML=`<td>${s.name||s.hub}</td><td>${s.slot}</td><td>${s.type}</td><td>${s.rms.toFixed(3)}</td><td>${s.hz.toFixed(1)}</td><td>${s.crest.toFixed(2)}</td><td>${s.kurt.toFixed(2)}</td><td>${states[s.state]||""}</td><td class="alarm">${alarms[s.alarm]||""}</td><td>${(s.age/1000).toFixed(1)}</td>`;
+    tr.onclick=()=>{sel=key;refresh();};body.appendChild(tr);});
+  if(sel){const [h,sl,t]=sel.split("/");const q=`hub=${h}&slot=${sl}&type=${t}`;
+    const sp=await (await fetch("/api/spectrum?"+q)).json();plot("spectrum",[],sp.fft||[],"Spectrum "+sel+" ("+(sp.binHz||0).toFixed(3)+" Hz/bin)");
+    const hi=await (await fetch("/api/history?"+q+"&field=rms&minutes=60&points=300")).json();plot("history",hi.t,hi.v,"RMS, last hour");}
+}
+setInterval(refresh,2000);refresh();
+</script></body></html>
+)HTML";
+
+// TextWriter sink: appends each chunk to a std::string
+static bool toString(const char* data, size_t len, void* ctx){
+    ((std::string*)ctx)->append(data, len);
+    return true;
+}
+
+static std::string param(const std::string& query, const char* name){
+    const size_t n = strlen(name);
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == std::string::npos) end = query.size();
+        if (query.compare(pos, n, name) == 0 && pos + n < end && query[pos + n] == '=') return query.substr(pos + n + 1, end - pos - n - 1);
+        pos = end + 1;
+    }
+    return "";
+}
+
+static int typeFromName(const std::string& name){
+    if (name == "vib") return TYPE_VIBRATION;
+    if (name == "cur") return TYPE_CURRENT;
+    return atoi(name.c_str());
+}
+
+void Gateway::serveHttp(int fd){
+    // One request per connection, read with a short deadline (the dashboard polls every 2 s)
+    char request[HTTP_REQUEST_BYTES];
+    size_t len = 0;
+    pollfd p = { fd, POLLIN, 0 };
+    while (len < sizeof(request) - 1 && poll(&p, 1, 500) > 0) {
+        ssize_t got = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if (got <= 0) break;
+        len += got;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n")) break;
+    }
+    request[len] = '\0';
+    _httpRequests++;
+
+    char method[8] = "", target[1024] = "";
+    if (sscanf(request, "%7s %1023s", method, target) != 2 || strcmp(method, "GET") != 0) {
+        sendResponse(fd, 400, "text/plain", "GET only\n");
+        close(fd);
+        return;
+    }
+    std::string path = target, query;
+    size_t q = path.find('?');
+    if (q != std::string::npos) { query = path.substr(q + 1); path.resize(q); }
+
+    std::string body;
+    char chunk[JSON_CHUNK_BYTES];
+    TextWriter out(chunk, sizeof(chunk), toString, &body);
+    int status = 200;
+    const char* type = "application/json";
+    if (path == "/") { body = GATEWAY_HTML; type = "text/html"; }
+    else if (path == "/api/hubs") apiHubs(out);
+    else if (path == "/api/sources") apiSources(out);
+    else if (path == "/api/spectrum") { if (!apiSpectrum(out, query)) status = 404; }
+    else if (path == "/api/history") { if (!apiHistory(out, query)) status = 400; }
+    else if (path == "/api/alarms") apiAlarms(out, query);
+    else if (path == "/metrics") { metrics(body); type = "text/plain; version=0.0.4"; }
+    else status = 404;
+    out.flush();
+    if (status != 200 && body.empty()) body = "{\"error\":\"not found\"}";
+    sendResponse(fd, status, type, body);
+    close(fd);
+}
+
+void Gateway::sendResponse(int fd, int status, const char* contentType, const std::string& body){
+    char head[256];
+    int n = snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\nCache-Control: no-store\r\n\r\n",
+                     status, (status == 200) ? "OK" : (status == 404) ? "Not Found" : "Bad Request", contentType, body.size());
+    std::string response(head, n);
+    response += body;
+    const char* data = response.data();
+    size_t left = response.size();
+    pollfd p = { fd, POLLOUT, 0 };
+    while (left > 0 && poll(&p, 1, 1000) > 0) {
+        ssize_t sent = send(fd, data, left, MSG_NOSIGNAL);
+        if (sent <= 0) break;
+        data += sent;
+        left -= sent;
+    }
+}
+
+void Gateway::apiHubs(TextWriter& out){
+    out.text("{\"hubs\":[");
+    bool first = true;
+    for (const Hub* hub : _hubs) {
+        if (!hub->greeted || hub->fd < 0) continue;
+        if (!first) out.put(',');
+        first = false;
+        out.text("{\"id\":").uinteger(hub->id).text(",\"name\":\"").text(hub->hello.name)
+           .text("\",\"sensors\":").uinteger(hub->hello.maxSensors).text(",\"fft\":").uinteger(hub->hello.fftSize)
+           .text(",\"frames\":").uinteger(hub->parser.frames()).text(",\"lost\":").uinteger(hub->parser.lostFrames())
+           .text(",\"resyncs\":").uinteger(hub->parser.resyncs()).text(",\"raw\":").uinteger(hub->frames[UPLINK_RAW])
+           .text(",\"bytes\":").uinteger((unsigned long)hub->bytes).text(",\"uptime\":").uinteger((unsigned long)((wallMs() - hub->connectedMs) / 1000)).put('}');
+    }
+    out.text("]}");
+}
+
+void Gateway::apiSources(TextWriter& out){
+    const uint64_t now = wallMs();
+    out.text("{\"sources\":[");
+    bool first = true;
+    for (const auto& entry : _sources) {
+        const Source& s = entry.second;
+        if (s.seenMs == 0) continue;
+        if (!first) out.put(',');
+        first = false;
+        const UplinkFeatures_t& f = s.features;
+        out.text("{\"hub\":").uinteger(s.hub).text(",\"name\":\"").text(_hubNames[s.hub].c_str()).text("\",\"slot\":").uinteger(s.slot)
+           .text(",\"type\":\"").text(sensorTypeName(s.type)).text("\",\"rms\":").fixed(f.rms, 3).text(",\"peak\":").fixed(f.peak, 3)
+           .text(",\"crest\":").fixed(f.crestFactor, 2).text(",\"kurt\":").fixed(f.kurtosis, 2).text(",\"hz\":").fixed(f.peakHz, 1)
+           .text(",\"state\":").uinteger(f.state).text(",\"alarm\":").uinteger(s.alarm).text(",\"frames\":").uinteger(s.featureFrames)
+           .text(",\"raw\":").text(s.channel ? "true" : "false").text(",\"age\":").uinteger((unsigned long)(now - s.seenMs)).put('}');
+    }
+    out.text("]}");
+}
+
+bool Gateway::apiSpectrum(TextWriter& out, const std::string& query){
+    uint32_t key = sourceKey((uint16_t)atoi(param(query, "hub").c_str()), (uint8_t)atoi(param(query, "slot").c_str()), (uint8_t)typeFromName(param(query, "type")));
+    auto it = _sources.find(key);
+    if (it == _sources.end() || it->second.spectrum.empty()) return false;
+    const Source& s = it->second;
+    out.text("{\"binHz\":").fixed(s.binHz, 4).text(",\"fft\":[");
+    for (size_t i = 0; i < s.spectrum.size(); i++) {
+        if (i) out.put(',');
+        out.fixed(s.spectrum[i], 2);
+    }
+    out.text("]}");
+    return true;
+}
+
+// Column scan: time + source filter, one value column, folded into `points` buckets (max)
+struct HistoryScan {
+    uint32_t	key;
+    int			column;
+    uint64_t	fromMs;
+    uint64_t	bucketMs;
+    std::vector<float> value;
+    std::vector<bool> have;
+};
+
+static bool historyRow(const ColumnStore::Partition& p, uint32_t row, void* ctx){
+    HistoryScan& scan = *(HistoryScan*)ctx;
+    uint32_t key;
+    memcpy(&key, p.column(F_SOURCE) + 4 * (size_t)row, sizeof(key));
+    if (key != scan.key) return true;
+    float v;
+    memcpy(&v, p.column(scan.column) + 4 * (size_t)row, sizeof(v));
+    size_t b = (size_t)((p.time()[row] - scan.fromMs) / scan.bucketMs);
+    if (b >= scan.value.size()) return true;
+    if (!scan.have[b] || v > scan.value[b]) scan.value[b] = v;
+    scan.have[b] = true;
+    return true;
+}
+
+bool Gateway::apiHistory(TextWriter& out, const std::string& query){
+    HistoryScan scan;
+    scan.key = sourceKey((uint16_t)atoi(param(query, "hub").c_str()), (uint8_t)atoi(param(query, "slot").c_str()), (uint8_t)typeFromName(param(query, "type")));
+    std::string field = param(query, "field");
+    scan.column = -1;
+    for (const auto& f : HISTORY_FIELDS) if (field == f.name) scan.column = f.column;
+    if (scan.column < 0) return false;
+    double minutes = param(query, "minutes").empty() ? 60 : atof(param(query, "minutes").c_str());
+    int points = param(query, "points").empty() ? 240 : atoi(param(query, "points").c_str());
+    if (minutes <= 0 || points <= 0 || points > 10000) return false;
+
+    const uint64_t now = wallMs();
+    const uint64_t spanMs = (uint64_t)(minutes * 60e3);
+    scan.fromMs = (now > spanMs) ? now - spanMs : 0;
+    scan.bucketMs = (spanMs + points - 1) / points;
+    if (scan.bucketMs == 0) scan.bucketMs = 1;
+    scan.value.assign(points, 0.0f);
+    scan.have.assign(points, false);
+    _features.scan(scan.fromMs, now + 1, historyRow, &scan);
+
+    // Buckets without rows are left out; t = seconds relative to now
+    out.text("{\"field\":\"").text(field.c_str()).text("\",\"t\":[");
+    bool first = true;
+    for (int b = 0; b < points; b++) {
+        if (!scan.have[b]) continue;
+        if (!first) out.put(',');
+        first = false;
+        out.fixed(-(float)((now - (scan.fromMs + b * scan.bucketMs)) / 1000.0), 1);
+    }
+    out.text("],\"v\":[");
+    first = true;
+    for (int b = 0; b < points; b++) {
+        if (!scan.have[b]) continue;
+        if (!first) out.put(',');
+        first = false;
+        out.fixed(scan.value[b], 4);
+    }
+    out.text("]}");
+    return true;
+}
+
+struct AlarmScan {
+    TextWriter*	out;
+    const std::string* names;
+    uint64_t	now;
+    bool		first;
+};
+
+static bool alarmRow(const ColumnStore::Partition& p, uint32_t row, void* ctx){
+    AlarmScan& scan = *(AlarmScan*)ctx;
+    uint32_t key;
+    float hz, value, limit;
+    memcpy(&key, p.column(A_SOURCE) + 4 * (size_t)row, 4);
+    memcpy(&hz, p.column(A_HZ) + 4 * (size_t)row, 4);
+    memcpy(&value, p.column(A_VALUE) + 4 * (size_t)row, 4);
+    memcpy(&limit, p.column(A_LIMIT) + 4 * (size_t)row, 4);
+    const uint8_t code = p.column(A_CODE)[row];
+    TextWriter& out = *scan.out;
+    if (!scan.first) out.put(',');
+    scan.first = false;
+    out.text("{\"ago\":").fixed((scan.now - p.time()[row]) / 1000.0f, 1).text(",\"hub\":").uinteger(key >> 16)
+       .text(",\"name\":\"").text(scan.names[key >> 16].c_str()).text("\",\"slot\":").uinteger((key >> 8) & 0xFF)
+       .text(",\"type\":\"").text(sensorTypeName((SensorDataType)(key & 0xFF))).text("\",\"code\":").uinteger(code)
+       .text(",\"text\":\"").text(alarmText((AlarmCode)code)).text("\",\"hz\":").fixed(hz, 1)
+       .text(",\"value\":").fixed(value, 2).text(",\"limit\":").fixed(limit, 2).put('}');
+    return true;
+}
+
+void Gateway::apiAlarms(TextWriter& out, const std::string& query){
+    double minutes = param(query, "minutes").empty() ? 60 : atof(param(query, "minutes").c_str());
+    const uint64_t now = wallMs();
+    const uint64_t spanMs = (uint64_t)(minutes * 60e3);
+    AlarmScan scan = { &out, _hubNames, now, true };
+    out.text("{\"alarms\":[");
+    _alarms.scan((now > spanMs) ? now - spanMs : 0, now + 1, alarmRow, &scan);
+    out.text("]}");
+}
+
+void Gateway::metrics(std::string& out){
+    char line[256];
+    auto add = [&](const char* fmt, auto... args){ snprintf(line, sizeof(line), fmt, args...); out += line; };
+    int greeted = 0;
+    uint32_t lost = 0, resyncs = 0, bad = 0;
+    for (const Hub* hub : _hubs) {
+        if (hub->greeted) greeted++;
+        lost += hub->parser.lostFrames();
+        resyncs += hub->parser.resyncs();
+        bad += hub->badPayloads;
+    }
+    out += "# HELP gw_hubs_connected Hubs with an open uplink.\n# TYPE gw_hubs_connected gauge\n";
+    add("gw_hubs_connected %d\n", greeted);
+    out += "# HELP gw_sources Sources (hub, slot, type) seen since start.\n# TYPE gw_sources gauge\n";
+    add("gw_sources %zu\n", _sources.size());
+    out += "# HELP gw_frames_total Uplink frames handled (features / spectra computed for raw hubs included).\n# TYPE gw_frames_total counter\n";
+    for (int k = UPLINK_HELLO; k < UPLINK_KIND_COUNT; k++) add("gw_frames_total{kind=\"%s\"} %u\n", uplinkKindName((UplinkKind)k), _framesTotal[k]);
+    out += "# HELP gw_lost_frames Sequence gaps on the open uplinks (frames the hubs dropped).\n# TYPE gw_lost_frames gauge\n";
+    add("gw_lost_frames %u\n", lost);
+    out += "# HELP gw_resyncs Times an open uplink lost framing.\n# TYPE gw_resyncs gauge\n";
+    add("gw_resyncs %u\n", resyncs);
+    out += "# HELP gw_bad_payloads Frames whose payload did not decode.\n# TYPE gw_bad_payloads gauge\n";
+    add("gw_bad_payloads %u\n", bad);
+    out += "# HELP gw_rejected_total Hub connections refused (over --max-hubs).\n# TYPE gw_rejected_total counter\n";
+    add("gw_rejected_total %u\n", _rejected);
+    out += "# HELP gw_raw_spectra_total Spectra computed here for raw-forwarding hubs.\n# TYPE gw_raw_spectra_total counter\n";
+    add("gw_raw_spectra_total %u\n", _rawSpectra);
+    out += "# HELP gw_store_rows Rows in the store per table.\n# TYPE gw_store_rows gauge\n";
+    const struct { const char* name; const ColumnStore* store; } tables[] = { { "features", &_features }, { "spectra", &_spectra }, { "alarms", &_alarms } };
+    for (const auto& t : tables) add("gw_store_rows{table=\"%s\"} %llu\n", t.name, (unsigned long long)t.store->rows());
+    out += "# HELP gw_store_partitions Partitions per table.\n# TYPE gw_store_partitions gauge\n";
+    for (const auto& t : tables) add("gw_store_partitions{table=\"%s\"} %d\n", t.name, t.store->partitionCount());
+    out += "# HELP gw_store_mapped_bytes File bytes mapped per table (open partitions at full size, sparse).\n# TYPE gw_store_mapped_bytes gauge\n";
+    for (const auto& t : tables) add("gw_store_mapped_bytes{table=\"%s\"} %zu\n", t.name, t.store->mappedBytes());
+    out += "# HELP gw_store_errors_total Rows that could not be appended.\n# TYPE gw_store_errors_total counter\n";
+    add("gw_store_errors_total %u\n", _storeErrors);
+    out += "# HELP gw_http_requests_total Dashboard / API requests.\n# TYPE gw_http_requests_total counter\n";
+    add("gw_http_requests_total %u\n", _httpRequests);
+}
+
+void Gateway::report() const {
+    int greeted = 0;
+    uint32_t lost = 0;
+    for (const Hub* hub : _hubs) {
+        if (hub->greeted) greeted++;
+        lost += hub->parser.lostFrames();
+    }
+    printf("gateway  : %d hubs connected, %zu sources, frames:", greeted, _sources.size());
+    for (int k = UPLINK_HELLO; k < UPLINK_KIND_COUNT; k++) printf(" %u %s", _framesTotal[k], uplinkKindName((UplinkKind)k));
+    printf(", %u lost, %u raw spectra\n", lost, _rawSpectra);
+    printf("store    : %llu feature rows, %llu spectra, %llu alarms in %d / %d / %d partitions, %u errors\n",
+           (unsigned long long)_features.rows(), (unsigned long long)_spectra.rows(), (unsigned long long)_alarms.rows(),
+           _features.partitionCount(), _spectra.partitionCount(), _alarms.partitionCount(), _storeErrors);
+}
+
+// --- Main ---
+static bool parseOptions(int argc, char** argv, Options& opt){
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto value = [&](){ if (!next) { fprintf(stderr, "%s needs a value\n", a.c_str()); exit(2); } i++; return next; };
+        if (a == "--port") opt.port = atoi(value());
+        else if (a == "--http") opt.http = atoi(value());
+        else if (a == "--store") opt.store = value();
+        else if (a == "--partition-s") opt.partitionSeconds = (uint32_t)atoi(value());
+        else if (a == "--retain-h") opt.retainHours = atof(value());
+        else if (a == "--max-hubs") opt.maxHubs = atoi(value());
+        else if (a == "--duration") opt.duration = atof(value());
+        else { fprintf(stderr, "unknown option %s (see tools/Gateway.cpp)\n", a.c_str()); return false; }
+    }
+    return opt.port > 0 && opt.http > 0 && opt.partitionSeconds > 0 && opt.maxHubs > 0;
+}
+
+static void onSignal(int){
+    s_stop = 1;
+}
+
+int main(int argc, char** argv){
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 2;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    Gateway* gateway = new Gateway(opt);
+    if (!gateway->start()) return 1;
+    printf("gateway: uplink port %d, dashboard http://localhost:%d/, store %s\n", opt.port, opt.http, opt.store.c_str());
+    fflush(stdout);
+    gateway->run();
+    gateway->report();
+    delete gateway;
+    return 0;
+}
@@ -0,0 +1,786 @@
+// Load generator: emulates N sensor nodes streaming to the hub on TCP port 8888.
+// Build: cmake -S . -B build && cmake --build build
+//
+//   load_gen --hub --nodes 8 --duration 20                  Against an in-process host hub (same SensorLink /
+//                                                           BatchPool / ProcessingChannel code as the ESP32)
+//   load_gen --target 192.168.4.1:8888 --nodes 2 --rate 50  Against a real hub
+//
+// Options:
+//   --nodes N          Concurrent sensor connections (2)
+//   --rate PPS         Packets per second per node (fs / 256 = real time), 0 = as fast as the socket takes them
+//   --duration S       Seconds to run (10)
+//   --fs HZ            Sample rate of the synthetic signals (1000)
+//   --signal KIND      sine | bearing | noise | current | jam | dry | motor | replay=capture.csv (sine)
+//                      jam / dry run the normal current profile for --fault-after seconds first (20),
+//                      then shift its level like the dashboard's simCurJam / simCurDry did.
+//                      motor: even nodes send the motor current, odd nodes its vibration (shaft lines
+//                      plus torque ripple locked to the current), all on one timeline (CorrelationEngine)
+//   --v2 [ENC]         v2 frames, ENC = f32 | i16 | i12 | d8 (default v1 DataPacket_t)
+//   --corrupt P        Probability per packet of garbage / header / truncation / payload corruption (0)
+//   --slots N          Client slots per host hub (--nodes / --hubs)
+//   --hubs N           Host hubs on ports port .. port+N-1, node n talks to hub n * N / nodes (1)
+//   --uplink HOST:PORT Host hubs forward features / spectra / alarms to a gateway (tools/Gateway)
+//   --uplink-raw       ... or their raw batches, the gateway runs the DSP (GatewayLink::setForwardRaw)
+//   --hub-id N         Uplink id of the first host hub, the others count up (1)
+//   --seed S           Random seed (1)
+//
+// Replay files are capture_dump --csv output (id,slot,type,ms,sample0..255), one batch per line.
+// Several host hubs with --uplink are the stand-in for a line of hubs feeding one gateway:
+//   gateway &  load_gen --hub --hubs 8 --nodes 16 --v2 --uplink 127.0.0.1:9100 --duration 60
+// End-to-end latency (socket send -> batch aggregated by the DSP channel) needs --hub and --v2,
+// because only v2 frames carry a timestamp.
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BatchPool.h"
+#include "CorrelationEngine.h"
+#include "MemoryArena.h"
+#include "MemoryPlan.h"
+#include "ProcessingChannel.h"
+#include "SampleCodec.h"
+#include "SensorLink.h"
+#include "UplinkCodec.h"
+
+// Same DSP settings as the firmware (Esp32ServerRefactored.ino / ProcessingCore)
+static const int AGGREGATION_FACTOR = 4;
+static const int HOP_SIZE = 256;
+static const int LEARN_FRAMES = 50;
+static const float DEFAULT_SAMPLE_RATE = 1000.0f;
+static const float LINE_FREQUENCY_HZ = 50.0f;
+static const int LINE_ZOOM_POINTS = 256;
+static const int LINE_ZOOM_DECIMATION = 16;
+static const float DEFAULT_RUNNING_HZ = 25.0f;
+static const uint32_t SPECTRUM_INTERVAL_MS = 5000;
+
+static uint32_t nowMs(){
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t nowUs(){
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Start of the run, the motor signal's time zero
+static const uint32_t s_epochUs = nowUs();
+
+// --- Options ---
+enum SignalKind { SIG_SINE, SIG_BEARING, SIG_NOISE, SIG_CURRENT, SIG_JAM, SIG_DRY, SIG_MOTOR, SIG_REPLAY };
+enum CorruptKind { CORRUPT_GARBAGE, CORRUPT_HEADER, CORRUPT_TRUNCATE, CORRUPT_PAYLOAD, CORRUPT_COUNT };
+static const char* signalNames[] = { "sine", "bearing", "noise", "current", "jam", "dry", "motor", "replay" };
+static const char* corruptNames[CORRUPT_COUNT] = { "garbage", "header", "truncate", "payload" };
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8888;
+    bool hub = false;
+    int nodes = 2;
+    double rate = -1;			// < 0: real time (fs / BATCH_SAMPLES)
+    double duration = 10;
+    float fs = DEFAULT_SAMPLE_RATE;
+    SignalKind signal = SIG_SINE;
+    std::string replayFile;
+    double faultAfter = 20;
+    bool v2 = false;
+    uint8_t encoding = ENC_FLOAT32;
+    double corrupt = 0;
+    int slots = 0;
+    unsigned seed = 1;
+    int hubs = 1;
+    std::string uplinkHost;			// Empty: no uplink
+    int uplinkPort = UPLINK_DEFAULT_PORT;
+    bool uplinkRaw = false;
+    int hubId = 1;
+};
+
+// --- Signals ---
+// Recorded batches for --signal replay
+struct ReplayBatch {
+    SensorDataType type;
+    float data[BATCH_SAMPLES];
+};
+
+static bool loadReplay(const char* path, std::vector<ReplayBatch>& out){
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) { perror(path); return false; }
+    char line[8192];
+    while (fgets(line, sizeof(line), f)) {
+        ReplayBatch b;
+        char* p = line;
+        long field[4];
+        for (int i = 0; i < 4; i++) { field[i] = strtol(p, &p, 10); if (*p == ',') p++; }
+        b.type = (SensorDataType)field[2];
+        int n = 0;
+        while (n < BATCH_SAMPLES && *p) {
+            char* end;
+            b.data[n] = strtof(p, &end);
+            if (end == p) break;
+            n++;
+            p = (*end == ',') ? end + 1 : end;
+        }
+        if (n == BATCH_SAMPLES) out.push_back(b);
+    }
+    fclose(f);
+    return !out.empty();
+}
+
+// One node's sample source, continuous across batches
+class SignalSource {
+	public:
+		SignalSource(const Options& opt, int node, const std::vector<ReplayBatch>* replay)
+			: _opt(opt), _replay(replay), _rng(opt.seed * 7919u + node), _noise(0.0f, 1.0f), _node(node) {
+			_replayPos = replay ? (size_t)node % replay->size() : 0;
+			_phase = 0.1f * node;
+		}
+
+		// Motor nodes: time of the first sample on the shared timeline, in seconds
+		void start(double seconds) { _start = seconds; }
+
+		SensorDataType type() const {
+			if (_opt.signal == SIG_REPLAY) return (*_replay)[_replayPos].type;
+			if (_opt.signal == SIG_MOTOR) return (_node % 2 == 0) ? TYPE_CURRENT : TYPE_VIBRATION;
+			return (_opt.signal >= SIG_CURRENT) ? TYPE_CURRENT : TYPE_VIBRATION;
+		}
+
+		void fill(float* out){
+			if (_opt.signal == SIG_REPLAY) {
+				memcpy(out, (*_replay)[_replayPos].data, sizeof(float) * BATCH_SAMPLES);
+				_replayPos = (_replayPos + 1) % _replay->size();
+				return;
+			}
+			const double twoPi = 2.0 * M_PI;
+			for (int i = 0; i < BATCH_SAMPLES; i++, _n++) {
+				// Phases in double: float loses the 50 Hz phase after a few minutes and adds spurs
+				const double t = (double)_n / _opt.fs + _phase;
+				double v = 0;
+				switch (_opt.signal) {
+					case SIG_SINE:
+						v = 512.0f + 100.0f * sin(twoPi * 50.0 * t) + 20.0f * sin(twoPi * 120.0 * t);
+						break;
+					case SIG_BEARING: {
+						// 1500 rpm shaft (1x..3x) plus outer-race impacts at BPFO = 3.58x, each ringing a 350 Hz resonance
+						const double shaft = 25.0, bpfo = 3.58 * shaft;
+						const double sinceImpact = fmod(t, 1.0 / bpfo);
+						v = 512.0f + 60.0f * sin(twoPi * shaft * t) + 25.0f * sin(twoPi * 2 * shaft * t) + 10.0f * sin(twoPi * 3 * shaft * t)
+							+ 80.0f * exp(-sinceImpact * 400.0) * sin(twoPi * 350.0 * sinceImpact) + 5.0f * _noise(_rng);
+						break;
+					}
+					case SIG_NOISE:
+						v = 512.0f + 30.0f * _noise(_rng);
+						break;
+					case SIG_MOTOR: {
+						// One motor seen by two nodes. Current: the normal profile. Vibration: shaft at 24.2 Hz
+						// (1452 rpm, slip below 25 Hz) and 2x, plus torque ripple at the current's 150 Hz harmonic.
+						const double tm = _start + (double)_n / _opt.fs;
+						if (_node % 2 == 0) {
+							v = CURRENT_LEVEL + 200.0f * sin(twoPi * 50.0 * tm) + 20.0f * sin(twoPi * 150.0 * tm);
+						} else {
+							const double shaft = 24.2;
+							v = 512.0f + 40.0f * sin(twoPi * shaft * tm) + 15.0f * sin(twoPi * 2 * shaft * tm + 1.0)
+								+ 60.0f * sin(twoPi * 150.0 * tm - 0.7) + 5.0f * _noise(_rng);
+						}
+						break;
+					}
+					default: {
+						// Motor current: level + 50 Hz ripple and its 3rd harmonic, no noise (the learned ripple mask
+						// is a max over 50 frames, random noise would cross it now and then and raise arcing alarms).
+						// Jam / dry shift the level by the margins the dashboard simulation used (AnomalyDetector::simulate).
+						float level = CURRENT_LEVEL;
+						bool faulted = (double)_n / _opt.fs >= _opt.faultAfter;
+						if (faulted && _opt.signal == SIG_JAM) level += fmaxf(CURRENT_LEVEL * 0.5f, 150.0f);
+						if (faulted && _opt.signal == SIG_DRY) level -= fmaxf(CURRENT_LEVEL * 0.6f, 150.0f);
+						v = level + 200.0f * sin(twoPi * 50.0 * t) + 20.0f * sin(twoPi * 150.0 * t);
+						break;
+					}
+				}
+				out[i] = (float)v;
+			}
+		}
+
+	private:
+		static constexpr float CURRENT_LEVEL = 1000.0f;
+
+		const Options&	_opt;
+		const std::vector<ReplayBatch>* _replay;
+		std::mt19937	_rng;
+		std::normal_distribution<float> _noise;
+		uint64_t		_n = 0;
+		double			_phase;
+		int				_node;
+		double			_start = 0;
+		size_t			_replayPos;
+};
+
+// --- Sensor node ---
+struct NodeStats {
+    std::atomic<uint32_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint32_t> corrupted[CORRUPT_COUNT];
+    std::atomic<uint64_t> stallUs{0};		// Time send() blocked for more than 1 ms (hub not draining)
+    std::atomic<uint32_t> stalls{0};
+    std::atomic<bool> failed{false};
+
+    NodeStats() { for (auto& c : corrupted) c = 0; }
+};
+
+static int connectTo(const std::string& host, int port){
+    addrinfo hints = {}, *res = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return -1;
+    int fd = socket(res->ai_family, res->ai_socktype, 0);
+    if (fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0) { close(fd); fd = -1; }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const uint8_t* p, size_t len, NodeStats& st){
+    uint32_t start = nowUs();
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    uint32_t blocked = nowUs() - start;
+    if (blocked > 1000) { st.stalls++; st.stallUs += blocked; }
+    return true;
+}
+
+// Builds one frame (v1 DataPacket_t or v2 header + payload) into pkt, returns the header length
+static size_t buildPacket(const Options& opt, SensorDataType type, int node, uint32_t seq, uint32_t timestampUs, const float* samples, std::vector<uint8_t>& pkt){
+    if (!opt.v2) {
+        DataPacket_t p;
+        p.header = PACKET_HEADER;
+        p.type = type;
+        memcpy(p.data, samples, sizeof(p.data));
+        pkt.assign((uint8_t*)&p, (uint8_t*)&p + sizeof(p));
+        return sizeof(PacketHeader_t);
+    }
+    uint8_t payload[sizeof(float) * BATCH_SAMPLES];
+    const float scale = 1.0f, offset = 0.0f;		// Synthetic ADC: one code per unit
+    size_t len = SampleCodec::encode(opt.encoding, samples, BATCH_SAMPLES, scale, offset, payload, sizeof(payload));
+    PacketHeaderV2_t h;
+    SampleCodec::buildHeader(&h, type, (uint8_t)node, opt.encoding, BATCH_SAMPLES, seq, timestampUs, (uint16_t)opt.fs, (uint16_t)len, scale, offset);
+    pkt.assign((uint8_t*)&h, (uint8_t*)&h + sizeof(h));
+    pkt.insert(pkt.end(), payload, payload + len);
+    return sizeof(h);
+}
+
+static void runNode(const Options& opt, int node, const std::vector<ReplayBatch>* replay, NodeStats& st){
+    // With several host hubs the nodes are spread over them in blocks
+    const int port = opt.port + (opt.hub ? node * opt.hubs / opt.nodes : 0);
+    int fd = -1;
+    for (int attempt = 0; attempt < 50 && fd < 0; attempt++) {
+        fd = connectTo(opt.host, port);
+        if (fd < 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (fd < 0) { st.failed = true; return; }
+
+    SignalSource source(opt, node, replay);
+    const uint32_t startUs = nowUs();
+    source.start((startUs - s_epochUs) * 1e-6);
+    std::mt19937 rng(opt.seed * 104729u + node);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    const double rate = (opt.rate < 0) ? opt.fs / BATCH_SAMPLES : opt.rate;
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::duration<double>(opt.duration);
+    float samples[BATCH_SAMPLES];
+    std::vector<uint8_t> pkt;
+
+    for (uint32_t seq = 0; std::chrono::steady_clock::now() < end; seq++) {
+        if (rate > 0) std::this_thread::sleep_until(start + std::chrono::duration<double>(seq / rate));
+
+        SensorDataType type = source.type();
+        source.fill(samples);
+        // Motor nodes stamp the first sample like a sensor would; the others the send time (latency report)
+        uint32_t stamp = (opt.signal == SIG_MOTOR) ? startUs + (uint32_t)llround(seq * BATCH_SAMPLES * 1e6 / opt.fs) : nowUs();
+        size_t headerBytes = buildPacket(opt, type, node, seq, stamp, samples, pkt);
+        size_t len = pkt.size();
+
+        if (opt.corrupt > 0 && chance(rng) < opt.corrupt) {
+            CorruptKind kind = (CorruptKind)(rng() % CORRUPT_COUNT);
+            st.corrupted[kind]++;
+            switch (kind) {
+                case CORRUPT_GARBAGE: {
+                    // Random bytes ahead of the frame; some will look like a 0xA5 lead byte
+                    uint8_t junk[64];
+                    size_t n = 1 + rng() % sizeof(junk);
+                    for (size_t i = 0; i < n; i++) junk[i] = (uint8_t)rng();
+                    if (!sendAll(fd, junk, n, st)) { st.failed = true; break; }
+                    st.bytes += n;
+                    break;
+                }
+                case CORRUPT_HEADER:
+                    pkt[rng() % headerBytes] ^= (uint8_t)(1 + rng() % 255);
+                    break;
+                case CORRUPT_TRUNCATE:
+                    len = 1 + rng() % (len - 1);
+                    break;
+                case CORRUPT_PAYLOAD:
+                    pkt[headerBytes + rng() % (len - headerBytes)] ^= (uint8_t)(1 + rng() % 255);
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (st.failed || !sendAll(fd, pkt.data(), len, st)) { st.failed = true; break; }
+        st.packets++;
+        st.bytes += len;
+    }
+    close(fd);
+}
+
+// --- Host hub: CommunicationHub's socket loop + ProcessingCore's batch handling, on POSIX sockets ---
+class HostHub {
+	public:
+		HostHub(int port, int slots, uint16_t hubId = 1)
+			: _port(port), _slots(slots), _pool(slots * (BATCH_RING_DEPTH + 1) + 1), _rings(slots), _links(slots), _fds(slots, -1), _encoder(hubId) {
+			for (int i = 0; i < slots; i++) _links[i].attach(i, &_rings[i], &_pool);
+			_channels.reserve(2 * slots);
+			_latencyUs.reserve(1 << 16);
+
+			// Channel buffers in an arena budgeted like the firmware's: one worst-case channel per slot
+			const int fftSize = AGGREGATION_FACTOR * BATCH_SAMPLES;
+			_fastMemory.resize(slots * MemoryPlan::channelFast(fftSize, DSP_FLOAT32, LINE_ZOOM_POINTS, LINE_ZOOM_DECIMATION)
+			                   + MemoryPlan::correlationFast(fftSize, DSP_FLOAT32) + ARENA_ALIGN);
+			_bulkMemory.resize(slots * MemoryPlan::channelBulk(fftSize) + MemoryPlan::correlationBulk(fftSize) + ARENA_ALIGN);
+			_arena.begin(MEM_FAST, _fastMemory.data(), _fastMemory.size());
+			_arena.begin(MEM_BULK, _bulkMemory.data(), _bulkMemory.size());
+		}
+
+		~HostHub() {
+			ArenaScope scope(&_arena);		// With --hubs the installed arena is another hub's
+			arenaDestroy(_correlation);
+			for (ProcessingChannel* c : _channels) arenaDestroy(c);
+		}
+
+		bool start(){
+			_listen = socket(AF_INET, SOCK_STREAM, 0);
+			int one = 1;
+			setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+			sockaddr_in addr = {};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = htons(_port);
+			if (bind(_listen, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listen, 16) != 0) {
+				perror("hub");
+				return false;
+			}
+			_running = true;
+			_hubThread = std::thread(&HostHub::connectionWorker, this);
+			_dspThread = std::thread(&HostHub::processingWorker, this);
+			return true;
+		}
+
+		void stop(){
+			_running = false;
+			notify();
+			_hubThread.join();
+			_dspThread.join();
+			// Hand back what is still queued or half read: every slot must be free again
+			for (int i = 0; i < _slots; i++) {
+				uint8_t index;
+				while (_rings[i].pop(index)) _pool.recycle(index);
+				_links[i].reset();
+			}
+			_leaked = _pool.capacity() - _pool.freeSlots();
+			for (int fd : _fds) if (fd >= 0) close(fd);
+			close(_listen);
+			if (_uplink >= 0) close(_uplink);
+		}
+
+		// Forwards to a gateway like GatewayLink does; call before start(). Blocking sends on the
+		// DSP thread: the gateway is on this machine, and a stalled uplink shows in the latency report.
+		bool connectUplink(const std::string& host, int port, bool raw){
+			_uplink = connectTo(host, port);
+			if (_uplink < 0) return false;
+			_uplinkRaw = raw;
+			const int fftSize = AGGREGATION_FACTOR * BATCH_SAMPLES;
+			_frame.resize(UplinkEncoder::maxFrameBytes(fftSize));
+			char name[UPLINK_NAME_BYTES];
+			snprintf(name, sizeof(name), "loadgen-%u", _encoder.hubId());
+			forward(UPLINK_HELLO, _encoder.hello(_frame.data(), _frame.size(), name, _slots, fftSize, nowMs()));
+			return _uplink >= 0;
+		}
+
+		uint16_t hubId() const { return _encoder.hubId(); }
+		// arena: include the arena footprint (the same for every host hub)
+		void report(bool arena = true) const;
+
+	private:
+		int			_port;
+		int			_slots;
+		BatchPool	_pool;
+		std::vector<BatchRing>	_rings;
+		std::vector<SensorLink>	_links;
+		std::vector<int>		_fds;
+		MemoryArena	_arena;
+		std::vector<uint8_t>	_fastMemory, _bulkMemory;
+		int			_listen = -1;
+		uint32_t	_rejected = 0;
+		int			_leaked = 0;		// Pool slots not free after stop()
+
+		std::atomic<bool> _running{false};
+		std::thread	_hubThread, _dspThread;
+		std::mutex	_lock;				// Stands in for xTaskNotifyGive / ulTaskNotifyTake
+		std::condition_variable _wake;
+		uint32_t	_notifications = 0;
+
+		// Consumer side only
+		std::vector<ProcessingChannel*> _channels;
+		CorrelationEngine* _correlation = nullptr;		// First current channel vs first vibration channel
+		std::vector<uint32_t> _latencyUs;
+		uint32_t	_batches = 0;
+		uint32_t	_spectra = 0;
+		uint32_t	_alarms[6] = {};
+
+		// Uplink (DSP thread after start)
+		UplinkEncoder _encoder;
+		int			_uplink = -1;
+		bool		_uplinkRaw = false;
+		std::vector<uint8_t> _frame;
+		uint32_t	_uplinkFrames[UPLINK_KIND_COUNT] = {};
+		uint64_t	_uplinkBytes = 0;
+		bool		_uplinkLost = false;
+
+		void notify(){
+			std::lock_guard<std::mutex> guard(_lock);
+			_notifications++;
+			_wake.notify_one();
+		}
+
+		void connectionWorker(){
+			std::vector<pollfd> polls;
+			while (_running) {
+				polls.clear();
+				polls.push_back({ _listen, POLLIN, 0 });
+				for (int fd : _fds) polls.push_back({ fd, (short)(fd >= 0 ? POLLIN : 0), 0 });
+				if (poll(polls.data(), polls.size(), 20) <= 0) continue;
+
+				// --- Accept new clients ---
+				if (polls[0].revents & POLLIN) {
+					int fd = accept(_listen, nullptr, nullptr);
+					int slot = (int)(std::find(_fds.begin(), _fds.end(), -1) - _fds.begin());
+					if (fd >= 0 && slot < _slots) {
+						_links[slot].reset();
+						_fds[slot] = fd;
+					} else if (fd >= 0) {
+						close(fd);		// No room
+						_rejected++;
+					}
+				}
+
+				// --- Read whatever each client has, straight into its link ---
+				for (int i = 0; i < _slots; i++) {
+					if (_fds[i] < 0 || !(polls[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+					for (;;) {
+						ssize_t got = recv(_fds[i], _links[i].writePtr(), _links[i].want(), MSG_DONTWAIT);
+						if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+							close(_fds[i]);
+							_fds[i] = -1;
+							break;
+						}
+						if (got < 0) break;
+						if (_links[i].commit(got) == PacketParser::EVENT_PACKET) notify();
+					}
+				}
+			}
+		}
+
+		ProcessingChannel* channelFor(const InternalMessage_t& msg){
+			for (ProcessingChannel* c : _channels) if (c->matches(msg.sensorSlot, msg.type)) return c;
+			float fs = (msg.info.sampleRateHz > 0) ? (float)msg.info.sampleRateHz : DEFAULT_SAMPLE_RATE;
+			ArenaScope scope(&_arena);
+			ProcessingChannel* c = arenaCreate<ProcessingChannel>(MEM_FAST, "channel", msg.sensorSlot, msg.type, BATCH_SAMPLES, AGGREGATION_FACTOR, fs, HOP_SIZE, SPECTRUM_INTERVAL_MS,
+			                                                      (msg.format == BATCH_CODES) ? DSP_Q15 : DSP_FLOAT32);
+			if (msg.type == TYPE_CURRENT) c->pipeline().addZoomAnalysis(LINE_FREQUENCY_HZ, LINE_ZOOM_POINTS, LINE_ZOOM_DECIMATION);
+			c->detector().startLearning(LEARN_FRAMES);
+			_channels.push_back(c);
+			pairChannels();
+			return c;
+		}
+
+		// Same pairing as ProcessingCore::pairChannels, called inside channelFor's arena scope
+		void pairChannels(){
+			if (_correlation) return;
+			ProcessingChannel* current = nullptr;
+			ProcessingChannel* vibration = nullptr;
+			for (ProcessingChannel* c : _channels) {
+				if (!current && c->type() == TYPE_CURRENT) current = c;
+				if (!vibration && c->type() == TYPE_VIBRATION) vibration = c;
+			}
+			const int points = AGGREGATION_FACTOR * BATCH_SAMPLES;
+			if (!current || !vibration || !CorrelationEngine::compatible(current->pipeline(), vibration->pipeline(), points)) return;
+			_correlation = arenaCreate<CorrelationEngine>(MEM_FAST, "correlate", current->pipeline(), vibration->pipeline(), points);
+			_correlation->setRunningHz(DEFAULT_RUNNING_HZ);
+		}
+
+		void processingWorker(){
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> guard(_lock);
+					_wake.wait_for(guard, std::chrono::milliseconds(100), [this]{ return _notifications > 0 || !_running; });
+					_notifications = 0;
+				}
+				// Drain every sensor ring, one batch per sensor per round
+				bool any = true;
+				while (any) {
+					any = false;
+					for (int i = 0; i < _slots; i++) {
+						uint8_t index;
+						if (!_rings[i].pop(index)) continue;
+						handleBatch(*_pool.slot(index));
+						_pool.release(index);
+						any = true;
+					}
+				}
+				if (!_running) return;
+			}
+		}
+
+		void forward(UplinkKind kind, size_t len){
+			if (_uplink < 0 || len == 0) return;
+			const uint8_t* p = _frame.data();
+			for (size_t left = len; left > 0;) {
+				ssize_t n = send(_uplink, p, left, MSG_NOSIGNAL);
+				if (n <= 0) {
+					close(_uplink);		// Gateway gone: the hub carries on without it
+					_uplink = -1;
+					_uplinkLost = true;
+					return;
+				}
+				p += n;
+				left -= n;
+			}
+			_uplinkFrames[kind]++;
+			_uplinkBytes += len;
+		}
+
+		void handleBatch(const InternalMessage_t& msg){
+			ProcessingChannel* channel = channelFor(msg);
+			_batches++;
+			if (_uplinkRaw) forward(UPLINK_RAW, _encoder.raw(_frame.data(), _frame.size(), msg, nowMs()));
+			if (channel->pushBatch(msg)) {
+				// Per-spectrum work ProcessingCore does before publishing
+				AlarmEvent_t alarm;
+				if (channel->analyse(&alarm)) {
+					if (alarm.code < 6) _alarms[alarm.code]++;
+					forward(UPLINK_ALARM, _encoder.alarm(_frame.data(), _frame.size(), *channel, alarm, nowMs()));
+				}
+				channel->extractFeatures();
+				channel->accumulate();
+				_spectra++;
+				if (!_uplinkRaw) {
+					forward(UPLINK_FEATURES, _encoder.features(_frame.data(), _frame.size(), *channel, nowMs()));
+					if (channel->publishDue(nowMs())) forward(UPLINK_SPECTRUM, _encoder.spectrum(_frame.data(), _frame.size(), *channel, nowMs()));
+				}
+			}
+			if (_correlation) _correlation->onBatch(channel->pipeline(), msg.info, nowUs());
+			if (msg.info.version >= PACKET_VERSION_V2) _latencyUs.push_back(nowUs() - msg.info.timestampUs);
+		}
+};
+
+void HostHub::report(bool arena) const {
+    uint32_t packets = 0, resyncs = 0, dropped = 0, skipped = 0, decodeErrors = 0, lost = 0, ringDrops = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < _slots; i++) {
+        const PacketParser& p = _links[i].parser();
+        packets += p.packets();
+        resyncs += p.resyncs();
+        dropped += p.droppedBytes();
+        skipped += p.skippedPackets();
+        decodeErrors += p.decodeErrors();
+        lost += p.lostPackets();
+        bytes += _links[i].bytesReceived();
+        ringDrops += _rings[i].dropped();
+    }
+    printf("hub      : %u packets, %.2f MB, %u resyncs, %u bytes dropped, %u skipped, %u decode errors, %u lost (v2 seq)\n",
+           packets, bytes / 1e6, resyncs, dropped, skipped, decodeErrors, lost);
+    printf("handoff  : %u ring drops, %u pool exhausted, %u connections refused, %d pool slots leaked\n", ringDrops, _pool.exhausted(), _rejected, _leaked);
+    printf("dsp      : %u batches, %u spectra, %zu channels, alarms:", _batches, _spectra, _channels.size());
+    bool anyAlarm = false;
+    for (int c = 1; c < 6; c++) {
+        if (_alarms[c] == 0) continue;
+        printf(" %s x%u", alarmText((AlarmCode)c), _alarms[c]);
+        anyAlarm = true;
+    }
+    printf("%s\n", anyAlarm ? "" : " none");
+    if (_correlation) {
+        const CorrelationSummary_t& s = _correlation->summary();
+        printf("correlate: %u frames, %.0f%% coherent, peak %.1f Hz coherence %.2f phase %.0f deg, running %.2f Hz, %s (%u skipped, %u gaps)\n",
+               s.frames, 100.0f * s.coherentPower, s.peakHz, s.peakCoherence, s.peakPhaseDeg, s.runningHz,
+               correlationVerdictName((CorrelationVerdict)s.verdict), _correlation->skipped(), _correlation->gaps());
+    }
+    if (!_frame.empty()) {
+        printf("uplink   : hub %u,", _encoder.hubId());
+        for (int k = UPLINK_HELLO; k < UPLINK_KIND_COUNT; k++) if (_uplinkFrames[k]) printf(" %u %s", _uplinkFrames[k], uplinkKindName((UplinkKind)k));
+        printf(", %.2f MB%s\n", _uplinkBytes / 1e6, _uplinkLost ? ", gateway lost" : "");
+    }
+    if (arena) {
+        char text[1024];
+        _arena.report(text, sizeof(text));
+        printf("%s", text);
+    }
+
+    if (_latencyUs.empty()) {
+        printf("latency  : n/a (v1 frames carry no timestamp, use --v2)\n");
+        return;
+    }
+    std::vector<uint32_t> sorted(_latencyUs);
+    std::sort(sorted.begin(), sorted.end());
+    auto pct = [&](double p){ return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+    printf("latency  : p50 %u us, p90 %u us, p99 %u us, max %u us (send -> aggregated, %zu batches)\n",
+           pct(0.50), pct(0.90), pct(0.99), sorted.back(), sorted.size());
+}
+
+// --- Command line ---
+static bool parseOptions(int argc, char** argv, Options& opt){
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto value = [&](){ if (next == nullptr) { fprintf(stderr, "%s needs a value\n", a.c_str()); exit(2); } i++; return next; };
+
+        if (a == "--target") {
+            std::string t = value();
+            size_t colon = t.rfind(':');
+            opt.host = t.substr(0, colon);
+            if (colon != std::string::npos) opt.port = atoi(t.c_str() + colon + 1);
+        }
+        else if (a == "--hub") {
+            opt.hub = true;
+            if (next && isdigit((unsigned char)next[0])) opt.port = atoi(value());
+        }
+        else if (a == "--nodes") opt.nodes = atoi(value());
+        else if (a == "--rate") opt.rate = atof(value());
+        else if (a == "--duration") opt.duration = atof(value());
+        else if (a == "--fs") opt.fs = atof(value());
+        else if (a == "--fault-after") opt.faultAfter = atof(value());
+        else if (a == "--corrupt") opt.corrupt = atof(value());
+        else if (a == "--slots") opt.slots = atoi(value());
+        else if (a == "--seed") opt.seed = (unsigned)atoi(value());
+        else if (a == "--hubs") opt.hubs = atoi(value());
+        else if (a == "--hub-id") opt.hubId = atoi(value());
+        else if (a == "--uplink-raw") opt.uplinkRaw = true;
+        else if (a == "--uplink") {
+            std::string t = value();
+            size_t colon = t.rfind(':');
+            opt.uplinkHost = t.substr(0, colon);
+            if (colon != std::string::npos) opt.uplinkPort = atoi(t.c_str() + colon + 1);
+        }
+        else if (a == "--v2") {
+            opt.v2 = true;
+            if (next && next[0] != '-') {
+                std::string e = value();
+                if (e == "f32") opt.encoding = ENC_FLOAT32;
+                else if (e == "i16") opt.encoding = ENC_INT16;
+                else if (e == "i12") opt.encoding = ENC_INT12_PACKED;
+                else if (e == "d8") opt.encoding = ENC_DELTA8;
+                else { fprintf(stderr, "unknown encoding %s\n", e.c_str()); return false; }
+            }
+        }
+        else if (a == "--signal") {
+            std::string s = value();
+            if (s == "sine") opt.signal = SIG_SINE;
+            else if (s == "bearing") opt.signal = SIG_BEARING;
+            else if (s == "noise") opt.signal = SIG_NOISE;
+            else if (s == "current") opt.signal = SIG_CURRENT;
+            else if (s == "jam") opt.signal = SIG_JAM;
+            else if (s == "dry") opt.signal = SIG_DRY;
+            else if (s == "motor") opt.signal = SIG_MOTOR;
+            else if (s.compare(0, 7, "replay=") == 0) { opt.signal = SIG_REPLAY; opt.replayFile = s.substr(7); }
+            else { fprintf(stderr, "unknown signal %s\n", s.c_str()); return false; }
+        }
+        else { fprintf(stderr, "unknown option %s (see tools/LoadGen.cpp)\n", a.c_str()); return false; }
+    }
+    if (opt.hubs <= 0 || opt.hubs > opt.nodes) { fprintf(stderr, "--hubs must be 1 .. --nodes\n"); return false; }
+    if (!opt.uplinkHost.empty() && !opt.hub) { fprintf(stderr, "--uplink needs --hub\n"); return false; }
+    if (opt.slots <= 0) opt.slots = (opt.nodes + opt.hubs - 1) / opt.hubs;
+    return opt.nodes > 0 && opt.fs > 0 && opt.duration > 0;
+}
+
+int main(int argc, char** argv){
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 2;
+
+    std::vector<ReplayBatch> replay;
+    if (opt.signal == SIG_REPLAY && !loadReplay(opt.replayFile.c_str(), replay)) return 1;
+
+    std::vector<HostHub*> hubs;
+    if (opt.hub) {
+        opt.host = "127.0.0.1";
+        for (int h = 0; h < opt.hubs; h++) {
+            HostHub* hub = new HostHub(opt.port + h, opt.slots, (uint16_t)(opt.hubId + h));
+            if (!opt.uplinkHost.empty() && !hub->connectUplink(opt.uplinkHost, opt.uplinkPort, opt.uplinkRaw)) {
+                fprintf(stderr, "uplink %s:%d: cannot connect\n", opt.uplinkHost.c_str(), opt.uplinkPort);
+                return 1;
+            }
+            if (!hub->start()) return 1;
+            hubs.push_back(hub);
+        }
+    }
+
+    static const char* encodings[] = { "f32", "i16", "i12", "d8" };
+    printf("%d nodes -> %s:%d, %.1f s, %s%s, signal %s\n", opt.nodes, opt.host.c_str(), opt.port, opt.duration,
+           opt.v2 ? "v2 " : "v1", opt.v2 ? encodings[opt.encoding] : "", signalNames[opt.signal]);
+    if (opt.hubs > 1) printf("%d host hubs on ports %d .. %d, %d slots each\n", opt.hubs, opt.port, opt.port + opt.hubs - 1, opt.slots);
+    if (!opt.uplinkHost.empty()) printf("uplink -> %s:%d, %s\n", opt.uplinkHost.c_str(), opt.uplinkPort, opt.uplinkRaw ? "raw batches" : "features / spectra / alarms");
+
+    std::vector<NodeStats> stats(opt.nodes);
+    std::vector<std::thread> nodes;
+    const auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < opt.nodes; n++) nodes.emplace_back(runNode, std::cref(opt), n, replay.empty() ? nullptr : &replay, std::ref(stats[n]));
+    for (std::thread& t : nodes) t.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t packets = 0, stalls = 0, failed = 0, corrupted[CORRUPT_COUNT] = {};
+    uint64_t bytes = 0, stallUs = 0;
+    for (NodeStats& s : stats) {
+        packets += s.packets;
+        bytes += s.bytes;
+        stalls += s.stalls;
+        stallUs += s.stallUs;
+        failed += s.failed;
+        for (int c = 0; c < CORRUPT_COUNT; c++) corrupted[c] += s.corrupted[c];
+    }
+    const double target = (opt.rate < 0) ? opt.fs / BATCH_SAMPLES : opt.rate;
+    char targetText[32] = "max";
+    if (target > 0) snprintf(targetText, sizeof(targetText), "%.1f", target * opt.nodes);
+    printf("sent     : %u packets in %.2f s = %.1f packets/s (target %s), %.3f MB/s, %u send stalls (%.1f ms), %u nodes failed\n",
+           packets, elapsed, packets / elapsed, targetText, bytes / elapsed / 1e6, stalls, stallUs / 1000.0, failed);
+    printf("corrupted:");
+    for (int c = 0; c < CORRUPT_COUNT; c++) printf(" %u %s", corrupted[c], corruptNames[c]);
+    printf("\n");
+
+    if (!hubs.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(200));	// Let the hubs drain the sockets
+    for (HostHub* hub : hubs) {
+        hub->stop();
+        if (hubs.size() > 1) printf("--- hub %u ---\n", hub->hubId());
+        hub->report(hub == hubs.front());
+        delete hub;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+// Two-thread stress check of SpscRing, the hub -> DSP handoff, without Google Benchmark.
+// Build: cmake -S . -B build && cmake --build build && ./build/spsc_stress  (also run by ctest)
+//
+// A producer thread pushes sequence numbers 1..N while a consumer thread pops them, for the
+// BatchRing depth and a deep ring, under both overflow policies. Every number must come out
+// exactly once, either popped (in increasing order) or handed back to the producer as evicted
+// (DROP_OLDEST) / refused (DROP_NEWEST); the ring's counters must agree. Exits 1 on any violation.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "BatchPool.h"
+#include "SpscRing.h"
+
+static const uint32_t ITEMS_PER_RUN = 1 << 20;
+
+template<size_t Capacity>
+static bool stress(const char* name, typename SpscRing<uint32_t, Capacity>::OverflowPolicy policy){
+    typedef SpscRing<uint32_t, Capacity> Ring;
+    Ring ring(policy);
+    std::atomic<bool> done{false};
+    // Where each number ended up, one array per thread so neither writes the other's
+    std::vector<uint8_t> popped(ITEMS_PER_RUN + 1, 0), lost(ITEMS_PER_RUN + 1, 0);
+    uint32_t lostCount = 0;
+
+    std::thread producer([&](){
+        uint32_t evicted;
+        for (uint32_t seq = 1; seq <= ITEMS_PER_RUN; seq++) {
+            typename Ring::PushResult result = ring.push(seq, &evicted);
+            if (result == Ring::PUSHED_EVICTED) { lost[evicted]++; lostCount++; }
+            if (result == Ring::DROPPED) { lost[seq]++; lostCount++; }
+            if ((seq & 15) == 0) std::this_thread::yield();		// Interleave with the consumer even on one core
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint32_t last = 0, count = 0;
+    bool ordered = true;
+    std::thread consumer([&](){
+        uint32_t item;
+        for (;;) {
+            bool finished = done.load(std::memory_order_acquire);
+            if (ring.pop(item)) {
+                if (item <= last || item > ITEMS_PER_RUN) ordered = false;
+                else popped[item]++;
+                last = item;
+                count++;
+            } else if (finished) {
+                break;		// Empty after the producer finished: nothing more can arrive
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    uint32_t missing = 0, duplicated = 0;
+    for (uint32_t seq = 1; seq <= ITEMS_PER_RUN; seq++) {
+        int seen = popped[seq] + lost[seq];
+        if (seen == 0) missing++;
+        if (seen > 1) duplicated++;
+    }
+    const uint32_t expectedPushed = ITEMS_PER_RUN - (policy == Ring::DROP_NEWEST ? lostCount : 0);
+    bool ok = ordered && missing == 0 && duplicated == 0 && (uint64_t)count + lostCount == ITEMS_PER_RUN
+              && ring.pushed() == expectedPushed && ring.dropped() == lostCount;
+
+    printf("%-24s %s  popped %u, %s %u, missing %u, duplicated %u%s\n", name, ok ? "ok  " : "FAIL", count,
+           (policy == Ring::DROP_OLDEST) ? "evicted" : "refused", lostCount, missing, duplicated, ordered ? "" : ", out of order");
+    return ok;
+}
+
+int main(){
+    bool ok = true;
+    ok &= stress<BATCH_RING_DEPTH>("BatchRing, drop oldest", SpscRing<uint32_t, BATCH_RING_DEPTH>::DROP_OLDEST);
+    ok &= stress<BATCH_RING_DEPTH>("BatchRing, drop newest", SpscRing<uint32_t, BATCH_RING_DEPTH>::DROP_NEWEST);
+    ok &= stress<1024>("depth 1024, drop oldest", SpscRing<uint32_t, 1024>::DROP_OLDEST);
+    ok &= stress<1024>("depth 1024, drop newest", SpscRing<uint32_t, 1024>::DROP_NEWEST);
+    return ok ? 0 : 1;
+}